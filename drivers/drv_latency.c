@@ -0,0 +1,93 @@
+/**
+ * @file drv_latency.c
+ * @brief Text dump of the driver latency histograms over UART.
+ *
+ * Every histogram is snapshotted before anything is written, so the dump's
+ * own UART traffic only shows up in the next dump.
+ */
+
+#include "drv_latency.h"
+#include "i2c.h"
+#include "uart.h"
+#include "log_token.h"
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+#if DRV_LATENCY_STATS
+static void DRV_LatencyPutChar(char c)
+{
+    UART_WriteChar(c);
+}
+
+static void DRV_LatencyDumpOne(const char *name, const HIST_Snapshot_t *snap)
+{
+    if (snap->count == 0)
+        return;
+
+    const int32_t args[] = {
+        (int32_t)snap->count,
+        (int32_t)HAL_TIMER_TicksToNs(snap->min),
+        (int32_t)HAL_TIMER_TicksToNs(HIST_ValueAt(snap, HIST_P50)),
+        (int32_t)HAL_TIMER_TicksToNs(HIST_ValueAt(snap, HIST_P90)),
+        (int32_t)HAL_TIMER_TicksToNs(HIST_ValueAt(snap, HIST_P99)),
+        (int32_t)HAL_TIMER_TicksToNs(HIST_ValueAt(snap, HIST_P999)),
+        (int32_t)HAL_TIMER_TicksToNs(snap->max),
+    };
+
+    UART_WriteString(name);
+    LOG_Format(" n=%u min=%u p50=%u p90=%u p99=%u p99.9=%u max=%u\r\n",
+               args, sizeof(args) / sizeof(args[0]), DRV_LatencyPutChar);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void DRV_LatencyDump(void)
+{
+#if DRV_LATENCY_STATS
+    static const char *const i2c_names[I2C_LATENCY_COUNT] = {
+        "i2c.write  ", "i2c.read   ", "i2c.xfer   ", "i2c.all    ", "i2c.recover"
+    };
+    static const char *const uart_names[UART_LATENCY_COUNT] = {
+        "uart.txchar", "uart.write ", "uart.read  "
+    };
+    static HIST_Snapshot_t i2c_snap[I2C_LATENCY_COUNT];
+    static HIST_Snapshot_t dev_snap[I2C_MAX_DEVICES];
+    static HIST_Snapshot_t uart_snap[UART_LATENCY_COUNT];
+    uint8_t addrs[I2C_MAX_DEVICES];
+
+    uint32_t devices = I2C_GetLatencyDevices(addrs, I2C_MAX_DEVICES);
+
+    for (uint32_t op = 0; op < I2C_LATENCY_COUNT; op++)
+        I2C_GetLatency((I2C_LatencyOp_t)op, &i2c_snap[op]);
+    for (uint32_t i = 0; i < devices; i++)
+        I2C_GetDeviceLatency(addrs[i], &dev_snap[i]);
+    for (uint32_t op = 0; op < UART_LATENCY_COUNT; op++)
+        UART_GetLatency((UART_LatencyOp_t)op, &uart_snap[op]);
+
+    UART_WriteString("-- latency (ns) --\r\n");
+
+    for (uint32_t op = 0; op < I2C_LATENCY_COUNT; op++)
+        DRV_LatencyDumpOne(i2c_names[op], &i2c_snap[op]);
+
+    for (uint32_t i = 0; i < devices; i++)
+    {
+        const int32_t addr = addrs[i];
+
+        if (dev_snap[i].count == 0)
+            continue;
+
+        LOG_Format("i2c.dev%02X  ", &addr, 1, DRV_LatencyPutChar);
+        DRV_LatencyDumpOne("", &dev_snap[i]);
+    }
+
+    for (uint32_t op = 0; op < UART_LATENCY_COUNT; op++)
+        DRV_LatencyDumpOne(uart_names[op], &uart_snap[op]);
+#else
+    UART_WriteString("-- latency stats disabled --\r\n");
+#endif
+}
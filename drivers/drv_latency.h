@@ -0,0 +1,76 @@
+/**
+ * @file drv_latency.h
+ * @brief Optional per-transaction latency histograms for the drivers.
+ *
+ * With DRV_LATENCY_STATS enabled, the I2C and UART drivers time every
+ * transaction with the HAL tick counter (hal_timer.h) and record it in a
+ * fixed-size lock-free histogram (histogram.h): O(1) per record, no
+ * allocation, safe from interrupt context. Values are in timer ticks.
+ *
+ * Query the histograms with I2C_GetLatency(), I2C_GetDeviceLatency() and
+ * UART_GetLatency(), or print all of them with DRV_LatencyDump().
+ *
+ * Build with -DDRV_LATENCY_STATS=0 to compile the timing out completely.
+ */
+
+#ifndef DRV_LATENCY_H
+#define DRV_LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "histogram.h"
+#include "../include/hal_timer.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#ifndef DRV_LATENCY_STATS
+#define DRV_LATENCY_STATS   1
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                                   Helpers                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Timestamp taken at the start of a transaction.
+ */
+static inline uint32_t DRV_LatencyStart(void)
+{
+#if DRV_LATENCY_STATS
+    return HAL_TIMER_GetTicks();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Record the time elapsed since @p start into @p hist (may be NULL).
+ */
+static inline void DRV_LatencyRecord(HIST_Histogram_t *hist, uint32_t start)
+{
+#if DRV_LATENCY_STATS
+    if (hist != NULL)
+        HIST_Record(hist, HAL_TIMER_GetTicks() - start);
+#else
+    (void)hist;
+    (void)start;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Write a latency summary of every driver histogram over UART.
+ *
+ * One line per non-empty histogram, values in nanoseconds:
+ *
+ *   i2c.read   n=5 min=812 p50=937 p90=1062 p99=1062 p99.9=1062 max=1041
+ */
+void DRV_LatencyDump(void);
+
+#endif /* DRV_LATENCY_H */
@@ -0,0 +1,139 @@
+/**
+ * @file histogram.c
+ * @brief Log-linear latency histogram (see histogram.h).
+ *
+ * All live counters are updated with relaxed atomics: the histogram only
+ * needs each increment to land exactly once, not any ordering between them.
+ */
+
+#include "histogram.h"
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t HIST_Msb(uint32_t value)
+{
+    return 31U - (uint32_t)__builtin_clz(value);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+uint32_t HIST_BucketIndex(uint32_t value)
+{
+    if (value < 2U * HIST_SUB_COUNT)
+        return value;
+
+    uint32_t shift = HIST_Msb(value) - HIST_SUB_BITS;
+    return (shift + 1U) * HIST_SUB_COUNT + ((value >> shift) & (HIST_SUB_COUNT - 1U));
+}
+
+uint32_t HIST_BucketLowest(uint32_t index)
+{
+    if (index < 2U * HIST_SUB_COUNT)
+        return index;
+
+    uint32_t shift = index / HIST_SUB_COUNT - 1U;
+    return (HIST_SUB_COUNT + index % HIST_SUB_COUNT) << shift;
+}
+
+uint32_t HIST_BucketHighest(uint32_t index)
+{
+    if (index < 2U * HIST_SUB_COUNT)
+        return index;
+
+    uint32_t shift = index / HIST_SUB_COUNT - 1U;
+    return HIST_BucketLowest(index) + ((1U << shift) - 1U);
+}
+
+void HIST_Reset(HIST_Histogram_t *hist)
+{
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+        atomic_store_explicit(&hist->bucket[i], 0U, memory_order_relaxed);
+
+    atomic_store_explicit(&hist->count, 0U, memory_order_relaxed);
+    atomic_store_explicit(&hist->min, UINT32_MAX, memory_order_relaxed);
+    atomic_store_explicit(&hist->max, 0U, memory_order_relaxed);
+    atomic_store_explicit(&hist->sum, 0U, memory_order_relaxed);
+}
+
+void HIST_Record(HIST_Histogram_t *hist, uint32_t value)
+{
+    atomic_fetch_add_explicit(&hist->bucket[HIST_BucketIndex(value)], 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->count, 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum, value, memory_order_relaxed);
+
+    uint32_t seen = atomic_load_explicit(&hist->min, memory_order_relaxed);
+    while (value < seen &&
+           !atomic_compare_exchange_weak_explicit(&hist->min, &seen, value,
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    seen = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(&hist->max, &seen, value,
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+void HIST_Snapshot(const HIST_Histogram_t *hist, HIST_Snapshot_t *snap)
+{
+    snap->count = 0;
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+    {
+        snap->bucket[i] = atomic_load_explicit(&hist->bucket[i], memory_order_relaxed);
+        snap->count += snap->bucket[i];
+    }
+
+    snap->min = atomic_load_explicit(&hist->min, memory_order_relaxed);
+    snap->max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    snap->sum = atomic_load_explicit(&hist->sum, memory_order_relaxed);
+}
+
+void HIST_Merge(HIST_Snapshot_t *dst, const HIST_Snapshot_t *src)
+{
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+        dst->bucket[i] += src->bucket[i];
+
+    if (src->count == 0)
+        return;
+
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+uint32_t HIST_ValueAt(const HIST_Snapshot_t *snap, uint32_t basis_points)
+{
+    if (snap->count == 0)
+        return 0;
+
+    if (basis_points > 10000U)
+        basis_points = 10000U;
+
+    /* Rank of the requested sample, rounded up (1-based) */
+    uint64_t rank = ((uint64_t)snap->count * basis_points + 9999U) / 10000U;
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += snap->bucket[i];
+        if (seen >= rank)
+        {
+            uint32_t value = HIST_BucketHighest(i);
+            return (value > snap->max) ? snap->max : value;
+        }
+    }
+
+    return snap->max;
+}
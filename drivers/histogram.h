@@ -0,0 +1,118 @@
+/**
+ * @file histogram.h
+ * @brief Fixed-memory, lock-free log-linear (HDR-style) histogram.
+ *
+ * Values are 32-bit (e.g. nanoseconds or microseconds). Each power-of-two
+ * range is split into 2^HIST_SUB_BITS equal sub-buckets, so any recorded
+ * value is reported with a relative error below 1 / 2^HIST_SUB_BITS while the
+ * whole 32-bit range needs only HIST_BUCKETS counters:
+ *
+ *   0..15        exact
+ *   16..31       buckets of 2
+ *   32..63       buckets of 4
+ *   ...
+ *
+ * Recording is O(1) (one count-leading-zeros and a few relaxed atomic
+ * updates), never allocates and may be called from several threads or from
+ * an interrupt handler at the same time. Readers take a snapshot with
+ * HIST_Snapshot() and compute percentiles on the copy.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#ifndef HIST_SUB_BITS
+#define HIST_SUB_BITS        3U    /* 8 sub-buckets per octave: < 12.5% error */
+#endif
+
+#define HIST_SUB_COUNT       (1U << HIST_SUB_BITS)
+#define HIST_BUCKETS         ((32U - HIST_SUB_BITS + 1U) * HIST_SUB_COUNT)
+
+/* Percentiles are given in basis points (1/100 of a percent) */
+#define HIST_P50             5000U
+#define HIST_P90             9000U
+#define HIST_P99             9900U
+#define HIST_P999            9990U
+
+/**
+ * @brief Live histogram; safe to record into concurrently.
+ */
+typedef struct
+{
+    _Atomic uint32_t bucket[HIST_BUCKETS];
+    _Atomic uint32_t count;
+    _Atomic uint32_t min;       /**< UINT32_MAX while empty */
+    _Atomic uint32_t max;
+    _Atomic uint64_t sum;
+} HIST_Histogram_t;
+
+/**
+ * @brief Plain copy of a histogram for reporting.
+ */
+typedef struct
+{
+    uint32_t bucket[HIST_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} HIST_Snapshot_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Clear all counts. Not atomic with respect to concurrent recorders.
+ */
+void HIST_Reset(HIST_Histogram_t *hist);
+
+/**
+ * @brief Record one value (O(1), lock-free).
+ */
+void HIST_Record(HIST_Histogram_t *hist, uint32_t value);
+
+/**
+ * @brief Copy the live counts into @p snap.
+ *
+ * Values recorded while the copy is taken may be partially included.
+ */
+void HIST_Snapshot(const HIST_Histogram_t *hist, HIST_Snapshot_t *snap);
+
+/**
+ * @brief Add the counts of @p src to @p dst (e.g. per-thread histograms).
+ */
+void HIST_Merge(HIST_Snapshot_t *dst, const HIST_Snapshot_t *src);
+
+/**
+ * @brief Value below or at which @p basis_points / 100 percent of samples fall.
+ *
+ * Reports the upper end of the bucket, clamped to the recorded maximum.
+ *
+ * @return 0 for an empty snapshot
+ */
+uint32_t HIST_ValueAt(const HIST_Snapshot_t *snap, uint32_t basis_points);
+
+/**
+ * @brief Bucket index for @p value.
+ */
+uint32_t HIST_BucketIndex(uint32_t value);
+
+/**
+ * @brief Smallest value that falls into bucket @p index.
+ */
+uint32_t HIST_BucketLowest(uint32_t index);
+
+/**
+ * @brief Largest value that falls into bucket @p index.
+ */
+uint32_t HIST_BucketHighest(uint32_t index);
+
+#endif /* HISTOGRAM_H */
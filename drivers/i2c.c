@@ -10,8 +10,11 @@
  * and timeout protection. Interrupt-driven extensions can be added later.
  */
 
+#include <stdatomic.h>
+
 #include "../include/hal_i2c.h"
 #include "i2c.h"
+#include "drv_latency.h"
 
 /* -------------------------------------------------------------------------- */
 /*                           Static I2C Driver Handle                          */
@@ -19,20 +22,654 @@
 
 static I2C_Handle_t i2c_handle;
 
+/**
+ * Per-address state. Slots are claimed lock-free on first use (key is the
+ * address + 1, 0 while free) and never move, so a lookup is a short scan.
+ */
+typedef struct
+{
+    _Atomic uint32_t key;
+#if DRV_LATENCY_STATS
+    HIST_Histogram_t latency;
+#endif
+} I2C_DeviceState_t;
+
+static I2C_DeviceState_t i2c_devices[I2C_MAX_DEVICES];
+
+/**
+ * Per-address retry policy and circuit-breaker state. Configured by the
+ * application after I2C_Init, so unlike i2c_devices this table is only
+ * accessed from driver calls and needs no atomics.
+ */
+typedef struct
+{
+    bool in_use;
+    uint8_t dev_addr;
+    I2C_RetryPolicy_t policy;
+    I2C_RetryStats_t stats;
+    uint32_t consecutive_failures;
+    uint32_t opened_at;           /* Tick at which the breaker opened */
+} I2C_PolicySlot_t;
+
+static I2C_PolicySlot_t i2c_policies[I2C_MAX_DEVICES];
+
+/* Per-address bus speed, configured like the retry policies */
+typedef struct
+{
+    bool in_use;
+    uint8_t dev_addr;
+    I2C_Speed_t speed;
+} I2C_SpeedSlot_t;
+
+static I2C_SpeedSlot_t i2c_speeds[I2C_MAX_DEVICES];
+
+#if DRV_LATENCY_STATS
+static HIST_Histogram_t i2c_latency[I2C_LATENCY_COUNT];
+#define I2C_LATENCY_HIST(op)   (&i2c_latency[(op)])
+#else
+#define I2C_LATENCY_HIST(op)   NULL
+#endif
+
+/* Clock-stretch bound in HAL timer ticks */
+#define I2C_STRETCH_TIMEOUT_TICKS   (I2C_STRETCH_TIMEOUT_US * (HAL_TIMER_TICK_HZ / 1000000U))
+
+#define I2C_TICKS_PER_US            (HAL_TIMER_TICK_HZ / 1000000U)
+#define I2C_RNG_SEED                0x2545F491U
+
 /* -------------------------------------------------------------------------- */
 /*                          Internal Helper Functions                          */
 /* -------------------------------------------------------------------------- */
 
+/**
+ * Waits for a status flag. Polls are bounded by @p timeout, except while a
+ * slave stretches the clock: that time is bounded separately by
+ * I2C_STRETCH_TIMEOUT_US so slow-but-legal devices are not cut off while a
+ * slave that never releases SCL still is.
+ */
 static I2C_Status_t I2C_WaitForFlag(bool (*flag_func)(void), uint32_t timeout)
 {
+    bool stretching = false;
+    uint32_t stretch_start = 0;
+
     while (!flag_func())
     {
+        if (HAL_I2C_IsAckFailure())
+            return I2C_STATUS_DATA_NACK;
+
+        if (HAL_I2C_IsClockStretched())
+        {
+            if (!stretching)
+            {
+                stretching = true;
+                stretch_start = HAL_TIMER_GetTicks();
+            }
+            else if (HAL_TIMER_GetTicks() - stretch_start > I2C_STRETCH_TIMEOUT_TICKS)
+            {
+                i2c_handle.stretch_timeouts++;
+                return I2C_STATUS_TIMEOUT;
+            }
+            continue;
+        }
+
+        stretching = false;
         if (timeout-- == 0)
             return I2C_STATUS_TIMEOUT;
     }
     return I2C_STATUS_OK;
 }
 
+#if DRV_LATENCY_STATS
+static I2C_DeviceState_t *I2C_GetDevice(uint8_t dev_addr, bool claim)
+{
+    uint32_t key = (uint32_t)dev_addr + 1U;
+
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        uint32_t seen = atomic_load_explicit(&i2c_devices[i].key, memory_order_acquire);
+
+        if (seen == 0 && claim)
+        {
+            if (atomic_compare_exchange_strong(&i2c_devices[i].key, &seen, key))
+                return &i2c_devices[i];
+        }
+
+        /* Someone else may have claimed this slot for the same address */
+        if (seen == key)
+            return &i2c_devices[i];
+        if (seen == 0)
+            return NULL;
+    }
+
+    return NULL;
+}
+#endif
+
+static I2C_Status_t I2C_RecordLatency(uint8_t dev_addr, I2C_LatencyOp_t op, uint32_t start,
+                                      I2C_Status_t status)
+{
+#if DRV_LATENCY_STATS
+    I2C_DeviceState_t *dev = I2C_GetDevice(dev_addr, true);
+    uint32_t elapsed = HAL_TIMER_GetTicks() - start;
+
+    HIST_Record(&i2c_latency[op], elapsed);
+    HIST_Record(&i2c_latency[I2C_LATENCY_ALL], elapsed);
+    if (dev != NULL)
+        HIST_Record(&dev->latency, elapsed);
+#else
+    (void)dev_addr;
+    (void)op;
+    (void)start;
+#endif
+    return status;
+}
+
+static I2C_PolicySlot_t *I2C_FindPolicy(uint8_t dev_addr)
+{
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        if (i2c_policies[i].in_use && i2c_policies[i].dev_addr == dev_addr)
+            return &i2c_policies[i];
+    }
+    return NULL;
+}
+
+static I2C_SpeedSlot_t *I2C_FindSpeed(uint8_t dev_addr)
+{
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        if (i2c_speeds[i].in_use && i2c_speeds[i].dev_addr == dev_addr)
+            return &i2c_speeds[i];
+    }
+    return NULL;
+}
+
+/* Program @p speed unless the peripheral already runs at it */
+static void I2C_ApplySpeed(I2C_Speed_t speed)
+{
+    if (speed == i2c_handle.active_speed)
+        return;
+
+    HAL_I2C_SetSpeed(speed);
+    i2c_handle.active_speed = speed;
+    i2c_handle.speed_switches++;
+}
+
+static uint32_t I2C_Random(void)
+{
+    /* xorshift32: jitter only needs to de-correlate callers */
+    uint32_t x = i2c_handle.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return i2c_handle.rng = x;
+}
+
+static void I2C_DelayUs(uint32_t us)
+{
+    uint32_t start = HAL_TIMER_GetTicks();
+    uint32_t ticks = us * I2C_TICKS_PER_US;
+
+    while (HAL_TIMER_GetTicks() - start < ticks)
+        ;
+}
+
+/**
+ * Admit a call to the device behind @p slot (NULL: no policy). Returns the
+ * number of attempts allowed, or 0 if the circuit breaker rejects the call.
+ */
+static uint32_t I2C_RetryAdmit(I2C_PolicySlot_t *slot)
+{
+    if (slot == NULL)
+        return 1;
+
+    slot->stats.calls++;
+
+    if (!slot->stats.breaker_open)
+        return (slot->policy.max_attempts != 0) ? slot->policy.max_attempts : 1U;
+
+    if (HAL_TIMER_GetTicks() - slot->opened_at <
+        slot->policy.breaker_cooldown_us * I2C_TICKS_PER_US)
+    {
+        slot->stats.fast_fails++;
+        return 0;
+    }
+
+    /* Cooldown over: one probe decides whether the breaker closes */
+    return 1;
+}
+
+static bool I2C_IsRetryable(const I2C_PolicySlot_t *slot, I2C_Status_t status)
+{
+    switch (status)
+    {
+    case I2C_STATUS_ADDR_NACK:
+    case I2C_STATUS_DATA_NACK:
+        return true;
+    case I2C_STATUS_TIMEOUT:
+        return !slot->policy.nack_only;
+    default:
+        return false;   /* BUS_STUCK already went through recovery */
+    }
+}
+
+/**
+ * Called after attempt number @p attempt (0-based) finished with @p status.
+ * Waits out the backoff and returns true if another attempt should follow.
+ */
+static bool I2C_RetryAgain(I2C_PolicySlot_t *slot, uint32_t attempt, uint32_t allowed,
+                           I2C_Status_t status)
+{
+    if (slot == NULL)
+        return false;
+
+    slot->stats.attempts++;
+
+    if (status == I2C_STATUS_OK || attempt + 1U >= allowed || !I2C_IsRetryable(slot, status))
+        return false;
+
+    uint32_t delay = slot->policy.backoff_base_us;
+    for (uint32_t i = 0; i < attempt && delay < slot->policy.backoff_max_us; i++)
+        delay <<= 1;
+    if (delay > slot->policy.backoff_max_us)
+        delay = slot->policy.backoff_max_us;
+    if (slot->policy.jitter && delay > 1U)
+        delay = delay / 2U + I2C_Random() % (delay - delay / 2U + 1U);
+
+    I2C_DelayUs(delay);
+
+    slot->stats.backoff_us += delay;
+    slot->stats.retries++;
+    return true;
+}
+
+static I2C_Status_t I2C_RetryFinish(I2C_PolicySlot_t *slot, uint32_t attempts, I2C_Status_t status)
+{
+    if (slot == NULL)
+        return status;
+
+    if (status == I2C_STATUS_OK)
+    {
+        if (attempts > 1U)
+            slot->stats.recovered++;
+        slot->consecutive_failures = 0;
+        slot->stats.breaker_open = false;
+        return status;
+    }
+
+    slot->stats.exhausted++;
+    slot->consecutive_failures++;
+
+    /* A failed probe re-opens the breaker straight away */
+    if (slot->policy.breaker_threshold != 0 &&
+        (slot->stats.breaker_open || slot->consecutive_failures >= slot->policy.breaker_threshold))
+    {
+        slot->stats.breaker_open = true;
+        slot->stats.breaker_trips++;
+        slot->opened_at = HAL_TIMER_GetTicks();
+    }
+    return status;
+}
+
+/**
+ * Generate a START, recovering the bus first if a slave is holding SDA low.
+ */
+static I2C_Status_t I2C_Start(void)
+{
+    if (HAL_I2C_IsSDALow() && I2C_RecoverBus() != I2C_STATUS_OK)
+        return I2C_STATUS_BUS_STUCK;
+
+    HAL_I2C_GenerateStart();
+    return I2C_WaitForFlag(HAL_I2C_IsStartGenerated, I2C_TIMEOUT);
+}
+
+/**
+ * Terminate a failed transaction: release the bus with a STOP and, if a
+ * slave kept SDA low, recover it now so the next transaction starts clean.
+ */
+static I2C_Status_t I2C_Abort(I2C_Status_t status)
+{
+    if (status == I2C_STATUS_ADDR_NACK || status == I2C_STATUS_DATA_NACK)
+        i2c_handle.nacks++;
+
+    HAL_I2C_ClearAckFailure();
+    HAL_I2C_GenerateStop();
+
+    /* BUS_STUCK means a recovery just failed; do not repeat it */
+    if (status != I2C_STATUS_BUS_STUCK && HAL_I2C_IsSDALow())
+        I2C_RecoverBus();
+
+    return status;
+}
+
+static I2C_Status_t I2C_SendAddressPhase(uint8_t dev_addr, I2C_Direction_t direction)
+{
+    HAL_I2C_SendAddress(dev_addr, direction);
+
+    I2C_Status_t status = I2C_WaitForFlag(HAL_I2C_IsAddressSent, I2C_TIMEOUT);
+    return (status == I2C_STATUS_DATA_NACK) ? I2C_STATUS_ADDR_NACK : status;
+}
+
+static I2C_Status_t I2C_DoWriteBuffer(uint8_t dev_addr, const uint8_t *buffer, uint32_t len)
+{
+    I2C_ApplySpeed(I2C_GetDeviceSpeed(dev_addr));
+
+    I2C_Status_t status = I2C_Start();
+    if (status != I2C_STATUS_OK)
+        return I2C_Abort(status);
+
+    status = I2C_SendAddressPhase(dev_addr, I2C_WRITE);
+    if (status != I2C_STATUS_OK)
+        return I2C_Abort(status);
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        HAL_I2C_SendData(buffer[i]);
+
+        status = I2C_WaitForFlag(HAL_I2C_IsTxComplete, I2C_TIMEOUT);
+        if (status != I2C_STATUS_OK)
+            return I2C_Abort(status);
+    }
+
+    HAL_I2C_GenerateStop();
+    return I2C_STATUS_OK;
+}
+
+/**
+ * Destination of received bytes. put() returns false to end the read as
+ * early as the protocol allows; the bytes still clocked in after that are
+ * not passed on.
+ */
+typedef struct I2C_RxSink I2C_RxSink_t;
+
+struct I2C_RxSink
+{
+    bool (*put)(I2C_RxSink_t *sink, uint8_t byte);
+};
+
+/* I2C_Transfer: a read segment plus the NOSTART segments continuing it */
+typedef struct
+{
+    I2C_RxSink_t sink;
+    const I2C_Msg_t *msgs;
+    uint32_t seg;
+    uint32_t pos;
+} I2C_MsgSink_t;
+
+static bool I2C_MsgSinkPut(I2C_RxSink_t *sink, uint8_t byte)
+{
+    I2C_MsgSink_t *ms = (I2C_MsgSink_t *)sink;
+
+    while (ms->pos == ms->msgs[ms->seg].len)
+    {
+        ms->seg++;
+        ms->pos = 0;
+    }
+    ms->msgs[ms->seg].buf[ms->pos++] = byte;
+    return true;
+}
+
+/**
+ * Receive a read run of @p total bytes into @p sink, after its address
+ * phase (e.g. msgs[0] plus the I2C_M_NOSTART reads continuing it). The controller is
+ * double-buffered (see hal_i2c.h): byte k+1 keeps clocking in while byte k
+ * waits in DR, and once both are full SCL is held until DR is read. NACK and
+ * STOP are therefore armed while the bus is held, never against a byte in
+ * flight, so the result does not depend on how fast the CPU gets here:
+ *  - 1 byte:  NACK before releasing ADDR, STOP right after
+ *  - 2 bytes: NACK with POS (applies to the second byte) before releasing
+ *             ADDR, STOP once both bytes are in (BTF)
+ *  - more:    ACK; with three bytes left wait for BTF and arm the NACK for
+ *             the last byte, with two left wait for BTF again and arm STOP
+ * With @p stop false the run ends in a NACK only and the caller issues a
+ * repeated START. A sink that asks to stop early shortens the run to the
+ * three bytes needed to reach the NACK.
+ */
+static I2C_Status_t I2C_ReceiveRun(uint32_t total, bool stop, I2C_RxSink_t *sink)
+{
+    bool draining = false;
+
+    /* Address-only probe: nothing is clocked before the STOP */
+    if (total == 0)
+    {
+        if (stop)
+            HAL_I2C_GenerateStop();
+        return I2C_STATUS_OK;
+    }
+
+    if (total == 1)
+    {
+        HAL_I2C_SendNACK();
+    }
+    else if (total == 2)
+    {
+        HAL_I2C_ControlBegin();
+        HAL_I2C_SendNACK();
+        HAL_I2C_SetAckPosition(true);
+        HAL_I2C_ControlCommit();
+    }
+    else
+    {
+        HAL_I2C_SendACK();
+    }
+
+    HAL_I2C_ClearAddress();
+
+    if (total == 1 && stop)
+        HAL_I2C_GenerateStop();
+
+    for (uint32_t left = total; left > 0; left--)
+    {
+        I2C_Status_t status;
+
+        if (left == 3 || left == 2)
+        {
+            status = I2C_WaitForFlag(HAL_I2C_IsByteTransferFinished, I2C_TIMEOUT);
+
+            if (status == I2C_STATUS_OK && left == 3)
+                HAL_I2C_SendNACK();
+            else if (status == I2C_STATUS_OK && stop)
+                HAL_I2C_GenerateStop();
+        }
+        else
+        {
+            status = I2C_WaitForFlag(HAL_I2C_IsRxReady, I2C_TIMEOUT);
+        }
+
+        if (status != I2C_STATUS_OK)
+        {
+            HAL_I2C_SetAckPosition(false);
+            return status;
+        }
+
+        uint8_t byte = HAL_I2C_ReadData();
+
+        if (!draining && !sink->put(sink, byte))
+        {
+            draining = true;
+            if (left > 4)
+                left = 4;   /* The next pass is the "three left" one */
+        }
+    }
+
+    HAL_I2C_SetAckPosition(false);
+    return I2C_STATUS_OK;
+}
+
+/**
+ * With I2C_M_IGNORE_NAK, a NACK is acknowledged in software and the segment
+ * carries on.
+ */
+static I2C_Status_t I2C_CheckNack(I2C_Status_t status, uint16_t flags)
+{
+    if ((flags & I2C_M_IGNORE_NAK) &&
+        (status == I2C_STATUS_ADDR_NACK || status == I2C_STATUS_DATA_NACK))
+    {
+        HAL_I2C_ClearAckFailure();
+        return I2C_STATUS_OK;
+    }
+    return status;
+}
+
+static bool I2C_IsValidTransfer(const I2C_Msg_t *msgs, uint32_t count)
+{
+    if (msgs == NULL || count == 0 || (msgs[0].flags & I2C_M_NOSTART))
+        return false;
+
+    for (uint32_t m = 0; m < count; m++)
+    {
+        if (msgs[m].len != 0 && msgs[m].buf == NULL)
+            return false;
+
+        /* Without a new address byte the direction cannot change */
+        if (m > 0 && (msgs[m].flags & I2C_M_NOSTART) &&
+            ((msgs[m].flags ^ msgs[m - 1].flags) & I2C_M_RD))
+            return false;
+    }
+    return true;
+}
+
+static I2C_Status_t I2C_DoTransfer(const I2C_Msg_t *msgs, uint32_t count)
+{
+    I2C_Status_t status;
+    bool stopped = false;
+    I2C_Speed_t speed = I2C_GetDeviceSpeed(msgs[0].addr);
+
+    /* Every device addressed must keep up with the whole transfer */
+    for (uint32_t m = 1; m < count; m++)
+    {
+        I2C_Speed_t other = I2C_GetDeviceSpeed(msgs[m].addr);
+
+        if (!(msgs[m].flags & I2C_M_NOSTART) && other < speed)
+            speed = other;
+    }
+    I2C_ApplySpeed(speed);
+
+    for (uint32_t m = 0; m < count; m++)
+    {
+        const I2C_Msg_t *msg = &msgs[m];
+        bool read = (msg->flags & I2C_M_RD) != 0;
+
+        if (!(msg->flags & I2C_M_NOSTART))
+        {
+            /* START for the first segment, repeated START for the others */
+            status = I2C_Start();
+            if (status == I2C_STATUS_OK)
+                status = I2C_SendAddressPhase(msg->addr, read ? I2C_READ : I2C_WRITE);
+
+            status = I2C_CheckNack(status, msg->flags);
+            if (status != I2C_STATUS_OK)
+                return I2C_Abort(status);
+        }
+
+        if (read)
+        {
+            /* NOSTART reads continue the same run of received bytes */
+            I2C_MsgSink_t sink = { .sink = { I2C_MsgSinkPut }, .msgs = msg };
+            uint32_t segments = 1;
+            uint32_t total = msg->len;
+
+            while (m + segments < count && (msgs[m + segments].flags & I2C_M_NOSTART))
+                total += msgs[m + segments++].len;
+
+            stopped = (m + segments == count);
+            status = I2C_ReceiveRun(total, stopped, &sink.sink);
+            if (status != I2C_STATUS_OK)
+                return I2C_Abort(status);
+
+            m += segments - 1U;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < msg->len; i++)
+            {
+                HAL_I2C_SendData(msg->buf[i]);
+
+                status = I2C_CheckNack(I2C_WaitForFlag(HAL_I2C_IsTxComplete, I2C_TIMEOUT),
+                                       msg->flags);
+                if (status != I2C_STATUS_OK)
+                    return I2C_Abort(status);
+            }
+        }
+    }
+
+    /* A final read run has already armed its STOP */
+    if (!stopped)
+        HAL_I2C_GenerateStop();
+    return I2C_STATUS_OK;
+}
+
+/* I2C_ReadStream: fill the caller's chunk buffer and hand it over when full */
+typedef struct
+{
+    I2C_RxSink_t sink;
+    I2C_Stream_t *stream;
+    uint32_t fill;
+    bool stopped;
+} I2C_ChunkSink_t;
+
+static bool I2C_ChunkSinkPut(I2C_RxSink_t *sink, uint8_t byte)
+{
+    I2C_ChunkSink_t *cs = (I2C_ChunkSink_t *)sink;
+    I2C_Stream_t *stream = cs->stream;
+
+    stream->chunk[cs->fill++] = byte;
+    if (cs->fill < stream->chunk_len)
+        return true;
+
+    /* SCL is held once DR and the shift register are full */
+    cs->fill = 0;
+    stream->delivered += stream->chunk_len;
+    cs->stopped = !stream->on_chunk(stream->ctx, stream->chunk, stream->chunk_len);
+    return !cs->stopped;
+}
+
+static I2C_Status_t I2C_DoReadStream(uint8_t dev_addr, I2C_Stream_t *stream)
+{
+    I2C_ChunkSink_t sink = { .sink = { I2C_ChunkSinkPut }, .stream = stream };
+    I2C_Status_t status;
+
+    I2C_ApplySpeed(I2C_GetDeviceSpeed(dev_addr));
+    stream->delivered = 0;
+
+    if (stream->cmd_len != 0)
+    {
+        status = I2C_Start();
+        if (status == I2C_STATUS_OK)
+            status = I2C_SendAddressPhase(dev_addr, I2C_WRITE);
+
+        for (uint32_t i = 0; i < stream->cmd_len && status == I2C_STATUS_OK; i++)
+        {
+            HAL_I2C_SendData(stream->cmd[i]);
+            status = I2C_WaitForFlag(HAL_I2C_IsTxComplete, I2C_TIMEOUT);
+        }
+        if (status != I2C_STATUS_OK)
+            return I2C_Abort(status);
+    }
+
+    status = I2C_Start();
+    if (status == I2C_STATUS_OK)
+        status = I2C_SendAddressPhase(dev_addr, I2C_READ);
+    if (status == I2C_STATUS_OK)
+        status = I2C_ReceiveRun(stream->len, true, &sink.sink);
+    if (status != I2C_STATUS_OK)
+        return I2C_Abort(status);
+
+    /* The short last chunk */
+    if (sink.fill != 0 && !sink.stopped)
+    {
+        stream->delivered += sink.fill;
+        stream->on_chunk(stream->ctx, stream->chunk, sink.fill);
+    }
+    return I2C_STATUS_OK;
+}
+
+static I2C_Status_t I2C_DoReadBuffer(uint8_t dev_addr, uint8_t *buffer, uint32_t len)
+{
+    I2C_Msg_t msg = { .addr = dev_addr, .flags = I2C_M_RD, .len = len, .buf = buffer };
+
+    return I2C_DoTransfer(&msg, 1);
+}
+
 /* -------------------------------------------------------------------------- */
 /*                          Public API Implementations                         */
 /* -------------------------------------------------------------------------- */
@@ -40,7 +677,22 @@ static I2C_Status_t I2C_WaitForFlag(bool (*flag_func)(void), uint32_t timeout)
 void I2C_Init(const I2C_Config_t *config)
 {
     i2c_handle.speed = config->speed;
+    i2c_handle.active_speed = config->speed;
     i2c_handle.addressing_mode = config->addressing_mode;
+    i2c_handle.speed_switches = 0;
+    i2c_handle.recoveries = 0;
+    i2c_handle.recovery_failures = 0;
+    i2c_handle.stretch_timeouts = 0;
+    i2c_handle.nacks = 0;
+    i2c_handle.rng = I2C_RNG_SEED;
+
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        i2c_policies[i].in_use = false;
+        i2c_speeds[i].in_use = false;
+    }
+
+    I2C_ResetLatency();
 
     HAL_I2C_EnableClock();
     HAL_I2C_ConfigurePins();
@@ -49,97 +701,279 @@ void I2C_Init(const I2C_Config_t *config)
     HAL_I2C_Enable();
 }
 
-I2C_Status_t I2C_WriteByte(uint8_t dev_addr, uint8_t data)
+I2C_Status_t I2C_RecoverBus(void)
 {
-    HAL_I2C_GenerateStart();
+    uint32_t start = DRV_LatencyStart();
 
-    if (I2C_WaitForFlag(HAL_I2C_IsStartGenerated, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+    i2c_handle.recoveries++;
 
-    HAL_I2C_SendAddress(dev_addr, I2C_WRITE);
+    /* Clock the stuck slave through the rest of its byte (and ACK) until it
+     * lets go of SDA, then terminate whatever it thought was happening. */
+    HAL_I2C_RecoveryBegin();
 
-    if (I2C_WaitForFlag(HAL_I2C_IsAddressSent, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_ADDR_NACK;
+    for (uint32_t pulse = 0; pulse < I2C_RECOVERY_PULSES && HAL_I2C_IsSDALow(); pulse++)
+        HAL_I2C_RecoveryPulseSCL();
 
-    HAL_I2C_SendData(data);
+    HAL_I2C_RecoveryStop();
+    HAL_I2C_RecoveryEnd();
 
-    if (I2C_WaitForFlag(HAL_I2C_IsTxComplete, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+    /* The peripheral may be wedged mid-transfer too: reset and re-init it */
+    HAL_I2C_Reset();
+    HAL_I2C_SetSpeed(i2c_handle.active_speed);
+    HAL_I2C_Enable();
 
-    HAL_I2C_GenerateStop();
+    DRV_LatencyRecord(I2C_LATENCY_HIST(I2C_LATENCY_RECOVERY), start);
+
+    if (HAL_I2C_IsSDALow())
+    {
+        i2c_handle.recovery_failures++;
+        return I2C_STATUS_BUS_STUCK;
+    }
     return I2C_STATUS_OK;
 }
 
-I2C_Status_t I2C_WriteBuffer(uint8_t dev_addr, const uint8_t *buffer, uint32_t len)
+void I2C_GetBusStats(I2C_BusStats_t *stats)
 {
-    HAL_I2C_GenerateStart();
+    stats->recoveries = i2c_handle.recoveries;
+    stats->recovery_failures = i2c_handle.recovery_failures;
+    stats->stretch_timeouts = i2c_handle.stretch_timeouts;
+    stats->nacks = i2c_handle.nacks;
+    stats->speed_switches = i2c_handle.speed_switches;
+}
 
-    if (I2C_WaitForFlag(HAL_I2C_IsStartGenerated, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+bool I2C_SetDeviceSpeed(uint8_t dev_addr, I2C_Speed_t speed)
+{
+    I2C_SpeedSlot_t *slot = I2C_FindSpeed(dev_addr);
 
-    HAL_I2C_SendAddress(dev_addr, I2C_WRITE);
+    if (speed == I2C_SPEED_BUS_DEFAULT)
+    {
+        if (slot != NULL)
+            slot->in_use = false;
+        return true;
+    }
 
-    if (I2C_WaitForFlag(HAL_I2C_IsAddressSent, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_ADDR_NACK;
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES && slot == NULL; i++)
+    {
+        if (!i2c_speeds[i].in_use)
+            slot = &i2c_speeds[i];
+    }
+    if (slot == NULL)
+        return false;
 
-    for (uint32_t i = 0; i < len; i++)
+    slot->in_use = true;
+    slot->dev_addr = dev_addr;
+    slot->speed = speed;
+    return true;
+}
+
+I2C_Speed_t I2C_GetDeviceSpeed(uint8_t dev_addr)
+{
+    const I2C_SpeedSlot_t *slot = I2C_FindSpeed(dev_addr);
+
+    return (slot != NULL) ? slot->speed : i2c_handle.speed;
+}
+
+bool I2C_SetRetryPolicy(uint8_t dev_addr, const I2C_RetryPolicy_t *policy)
+{
+    I2C_PolicySlot_t *slot = I2C_FindPolicy(dev_addr);
+
+    if (policy == NULL)
     {
-        HAL_I2C_SendData(buffer[i]);
+        if (slot != NULL)
+            slot->in_use = false;
+        return true;
+    }
 
-        if (I2C_WaitForFlag(HAL_I2C_IsTxComplete, I2C_TIMEOUT) != I2C_STATUS_OK)
-            return I2C_STATUS_TIMEOUT;
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES && slot == NULL; i++)
+    {
+        if (!i2c_policies[i].in_use)
+            slot = &i2c_policies[i];
     }
+    if (slot == NULL)
+        return false;
+
+    slot->in_use = true;
+    slot->dev_addr = dev_addr;
+    slot->policy = *policy;
+    slot->stats = (I2C_RetryStats_t){ 0 };
+    slot->consecutive_failures = 0;
+    slot->opened_at = 0;
+    return true;
+}
 
-    HAL_I2C_GenerateStop();
-    return I2C_STATUS_OK;
+bool I2C_GetRetryStats(uint8_t dev_addr, I2C_RetryStats_t *stats)
+{
+    const I2C_PolicySlot_t *slot = I2C_FindPolicy(dev_addr);
+    if (slot == NULL)
+        return false;
+
+    *stats = slot->stats;
+    return true;
 }
 
-I2C_Status_t I2C_ReadByte(uint8_t dev_addr, uint8_t *data)
+I2C_Status_t I2C_WriteByte(uint8_t dev_addr, uint8_t data)
 {
-    HAL_I2C_GenerateStart();
+    return I2C_WriteBuffer(dev_addr, &data, 1);
+}
 
-    if (I2C_WaitForFlag(HAL_I2C_IsStartGenerated, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+I2C_Status_t I2C_WriteBuffer(uint8_t dev_addr, const uint8_t *buffer, uint32_t len)
+{
+    uint32_t start = DRV_LatencyStart();
+    I2C_PolicySlot_t *policy = I2C_FindPolicy(dev_addr);
+    uint32_t allowed = I2C_RetryAdmit(policy);
+    uint32_t attempt = 0;
+    I2C_Status_t status;
 
-    HAL_I2C_SendAddress(dev_addr, I2C_READ);
+    if (allowed == 0)
+        return I2C_STATUS_CIRCUIT_OPEN;
 
-    if (I2C_WaitForFlag(HAL_I2C_IsAddressSent, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_ADDR_NACK;
+    do
+        status = I2C_DoWriteBuffer(dev_addr, buffer, len);
+    while (I2C_RetryAgain(policy, attempt++, allowed, status));
 
-    if (I2C_WaitForFlag(HAL_I2C_IsRxReady, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+    return I2C_RecordLatency(dev_addr, I2C_LATENCY_WRITE, start,
+                             I2C_RetryFinish(policy, attempt, status));
+}
 
-    *data = HAL_I2C_ReadData();
+I2C_Status_t I2C_ReadByte(uint8_t dev_addr, uint8_t *data)
+{
+    uint32_t start = DRV_LatencyStart();
+    I2C_PolicySlot_t *policy = I2C_FindPolicy(dev_addr);
+    uint32_t allowed = I2C_RetryAdmit(policy);
+    uint32_t attempt = 0;
+    I2C_Status_t status;
 
-    HAL_I2C_GenerateStop();
-    return I2C_STATUS_OK;
+    if (allowed == 0)
+        return I2C_STATUS_CIRCUIT_OPEN;
+
+    do
+        status = I2C_DoReadBuffer(dev_addr, data, 1);
+    while (I2C_RetryAgain(policy, attempt++, allowed, status));
+
+    return I2C_RecordLatency(dev_addr, I2C_LATENCY_READ, start,
+                             I2C_RetryFinish(policy, attempt, status));
 }
 
 I2C_Status_t I2C_ReadBuffer(uint8_t dev_addr, uint8_t *buffer, uint32_t len)
 {
-    HAL_I2C_GenerateStart();
+    uint32_t start = DRV_LatencyStart();
+    I2C_PolicySlot_t *policy = I2C_FindPolicy(dev_addr);
+    uint32_t allowed = I2C_RetryAdmit(policy);
+    uint32_t attempt = 0;
+    I2C_Status_t status;
 
-    if (I2C_WaitForFlag(HAL_I2C_IsStartGenerated, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_TIMEOUT;
+    if (allowed == 0)
+        return I2C_STATUS_CIRCUIT_OPEN;
 
-    HAL_I2C_SendAddress(dev_addr, I2C_READ);
+    do
+        status = I2C_DoReadBuffer(dev_addr, buffer, len);
+    while (I2C_RetryAgain(policy, attempt++, allowed, status));
 
-    if (I2C_WaitForFlag(HAL_I2C_IsAddressSent, I2C_TIMEOUT) != I2C_STATUS_OK)
-        return I2C_STATUS_ADDR_NACK;
+    return I2C_RecordLatency(dev_addr, I2C_LATENCY_READ, start,
+                             I2C_RetryFinish(policy, attempt, status));
+}
 
-    for (uint32_t i = 0; i < len; i++)
+I2C_Status_t I2C_Transfer(const I2C_Msg_t *msgs, uint32_t count)
+{
+    if (!I2C_IsValidTransfer(msgs, count))
+        return I2C_STATUS_ERROR;
+
+    uint32_t start = DRV_LatencyStart();
+    I2C_PolicySlot_t *policy = I2C_FindPolicy(msgs[0].addr);
+    uint32_t allowed = I2C_RetryAdmit(policy);
+    uint32_t attempt = 0;
+    I2C_Status_t status;
+
+    if (allowed == 0)
+        return I2C_STATUS_CIRCUIT_OPEN;
+
+    do
+        status = I2C_DoTransfer(msgs, count);
+    while (I2C_RetryAgain(policy, attempt++, allowed, status));
+
+    return I2C_RecordLatency(msgs[0].addr, I2C_LATENCY_TRANSFER, start,
+                             I2C_RetryFinish(policy, attempt, status));
+}
+
+I2C_Status_t I2C_ReadStream(uint8_t dev_addr, I2C_Stream_t *stream)
+{
+    if (stream == NULL || stream->chunk == NULL || stream->chunk_len == 0 ||
+        stream->on_chunk == NULL || (stream->cmd_len != 0 && stream->cmd == NULL))
+        return I2C_STATUS_ERROR;
+
+    uint32_t start = DRV_LatencyStart();
+    I2C_PolicySlot_t *policy = I2C_FindPolicy(dev_addr);
+
+    if (I2C_RetryAdmit(policy) == 0)
+        return I2C_STATUS_CIRCUIT_OPEN;
+
+    /* Never retried: chunks already handed to the caller cannot be taken back */
+    I2C_Status_t status = I2C_DoReadStream(dev_addr, stream);
+    if (policy != NULL)
+        policy->stats.attempts++;
+
+    return I2C_RecordLatency(dev_addr, I2C_LATENCY_READ, start,
+                             I2C_RetryFinish(policy, 1, status));
+}
+
+bool I2C_GetLatency(I2C_LatencyOp_t op, HIST_Snapshot_t *snap)
+{
+#if DRV_LATENCY_STATS
+    if (op >= I2C_LATENCY_COUNT)
+        return false;
+
+    HIST_Snapshot(&i2c_latency[op], snap);
+    return true;
+#else
+    (void)op;
+    (void)snap;
+    return false;
+#endif
+}
+
+bool I2C_GetDeviceLatency(uint8_t dev_addr, HIST_Snapshot_t *snap)
+{
+#if DRV_LATENCY_STATS
+    I2C_DeviceState_t *dev = I2C_GetDevice(dev_addr, false);
+    if (dev == NULL)
+        return false;
+
+    HIST_Snapshot(&dev->latency, snap);
+    return true;
+#else
+    (void)dev_addr;
+    (void)snap;
+    return false;
+#endif
+}
+
+uint32_t I2C_GetLatencyDevices(uint8_t *addrs, uint32_t max)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES && count < max; i++)
     {
-        if (I2C_WaitForFlag(HAL_I2C_IsRxReady, I2C_TIMEOUT) != I2C_STATUS_OK)
-            return I2C_STATUS_TIMEOUT;
+        uint32_t key = atomic_load_explicit(&i2c_devices[i].key, memory_order_acquire);
+        if (key == 0)
+            break;
+        addrs[count++] = (uint8_t)(key - 1U);
+    }
 
-        buffer[i] = HAL_I2C_ReadData();
+    return count;
+}
 
-        if (i == (len - 1))
-            HAL_I2C_SendNACK();
-        else
-            HAL_I2C_SendACK();
+void I2C_ResetLatency(void)
+{
+    for (uint32_t i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        atomic_store(&i2c_devices[i].key, 0U);
+#if DRV_LATENCY_STATS
+        HIST_Reset(&i2c_devices[i].latency);
+#endif
     }
 
-    HAL_I2C_GenerateStop();
-    return I2C_STATUS_OK;
-}
\ No newline at end of file
+#if DRV_LATENCY_STATS
+    for (uint32_t op = 0; op < I2C_LATENCY_COUNT; op++)
+        HIST_Reset(&i2c_latency[op]);
+#endif
+}
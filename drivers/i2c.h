@@ -13,16 +13,36 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "histogram.h"
+
 /* -------------------------------------------------------------------------- */
 /*                                  Definitions                                */
 /* -------------------------------------------------------------------------- */
 
 #define I2C_TIMEOUT   50000U
 
+#define I2C_MAX_DEVICES   8U   /* Per-address statistics slots */
+
+/* A slave may hold SCL low this long per phase (SMBus tTIMEOUT minimum) */
+#define I2C_STRETCH_TIMEOUT_US   25000U
+
+/* SCL pulses clocked out to free a slave holding SDA low (8 data + ACK) */
+#define I2C_RECOVERY_PULSES      9U
+
+/* A reasonable starting point for I2C_SetRetryPolicy() */
+#define I2C_RETRY_POLICY_DEFAULT                                              \
+    {                                                                         \
+        .max_attempts = 3, .backoff_base_us = 100, .backoff_max_us = 2000,    \
+        .jitter = true, .nack_only = false,                                   \
+        .breaker_threshold = 5, .breaker_cooldown_us = 50000                  \
+    }
+
 typedef enum
 {
-    I2C_SPEED_STANDARD = 100000,  /**< 100 kHz */
-    I2C_SPEED_FAST     = 400000   /**< 400 kHz */
+    I2C_SPEED_BUS_DEFAULT = 0,         /**< Per-device: use I2C_Config_t.speed */
+    I2C_SPEED_STANDARD    = 100000,    /**< 100 kHz */
+    I2C_SPEED_FAST        = 400000,    /**< 400 kHz */
+    I2C_SPEED_FAST_PLUS   = 1000000    /**< 1 MHz */
 } I2C_Speed_t;
 
 typedef enum
@@ -37,9 +57,22 @@ typedef enum
     I2C_STATUS_TIMEOUT,
     I2C_STATUS_ADDR_NACK,
     I2C_STATUS_DATA_NACK,
-    I2C_STATUS_ERROR
+    I2C_STATUS_ERROR,
+    I2C_STATUS_BUS_STUCK,    /**< SDA still held low after bus recovery */
+    I2C_STATUS_CIRCUIT_OPEN  /**< Device fast-failed by its retry policy */
 } I2C_Status_t;
 
+/* Latency histogram selector (see drv_latency.h) */
+typedef enum
+{
+    I2C_LATENCY_WRITE = 0,   /**< I2C_WriteByte / I2C_WriteBuffer */
+    I2C_LATENCY_READ,        /**< I2C_ReadByte / I2C_ReadBuffer */
+    I2C_LATENCY_TRANSFER,    /**< I2C_Transfer */
+    I2C_LATENCY_ALL,         /**< Every transaction */
+    I2C_LATENCY_RECOVERY,    /**< I2C_RecoverBus */
+    I2C_LATENCY_COUNT
+} I2C_LatencyOp_t;
+
 /* Direction values used by HAL */
 typedef enum
 {
@@ -47,6 +80,44 @@ typedef enum
     I2C_READ  = 1
 } I2C_Direction_t;
 
+/* I2C_Msg_t flags (same values as Linux <linux/i2c.h>) */
+#define I2C_M_RD           0x0001U   /**< Read segment (default: write) */
+#define I2C_M_IGNORE_NAK   0x1000U   /**< Treat a NACK from the target as an ACK */
+#define I2C_M_NOSTART      0x4000U   /**< No (repeated) START/address: continue the previous segment */
+
+/**
+ * @brief One segment of an I2C_Transfer(), modeled on Linux `struct i2c_msg`.
+ */
+typedef struct
+{
+    uint8_t addr;      /**< 7-bit target address */
+    uint16_t flags;    /**< I2C_M_* */
+    uint16_t len;      /**< Bytes to write or read */
+    uint8_t *buf;      /**< Data to write, or destination of a read */
+} I2C_Msg_t;
+
+/**
+ * @brief Receives one chunk of an I2C_ReadStream().
+ *
+ * @return false to end the read early
+ */
+typedef bool (*I2C_ChunkCallback_t)(void *ctx, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief A streaming read (see I2C_ReadStream).
+ */
+typedef struct
+{
+    const uint8_t *cmd;            /**< Written first, e.g. a memory address (NULL: none) */
+    uint32_t cmd_len;
+    uint32_t len;                  /**< Bytes to read */
+    uint8_t *chunk;                /**< Caller's chunk buffer */
+    uint32_t chunk_len;
+    I2C_ChunkCallback_t on_chunk;
+    void *ctx;                     /**< Passed to on_chunk */
+    uint32_t delivered;            /**< Out: bytes handed to on_chunk */
+} I2C_Stream_t;
+
 /* -------------------------------------------------------------------------- */
 /*                               Configuration Struct                          */
 /* -------------------------------------------------------------------------- */
@@ -57,16 +128,76 @@ typedef struct
     I2C_AddressMode_t addressing_mode;
 } I2C_Config_t;
 
+/**
+ * @brief Per-device retry policy (see I2C_SetRetryPolicy).
+ *
+ * A failed transaction is retried after an exponential backoff of
+ * backoff_base_us, 2 * backoff_base_us, ... capped at backoff_max_us. With
+ * jitter, each delay is drawn uniformly from [delay / 2, delay] so that
+ * callers that failed together do not retry in lock-step.
+ *
+ * After breaker_threshold consecutive failed calls the circuit breaker
+ * opens: calls fail immediately with I2C_STATUS_CIRCUIT_OPEN, without
+ * touching the bus, for breaker_cooldown_us. The first call after that is
+ * a single-attempt probe that closes the breaker on success and re-opens it
+ * on failure.
+ */
+typedef struct
+{
+    uint32_t max_attempts;         /**< Bus transactions per call (1 = no retry) */
+    uint32_t backoff_base_us;      /**< Delay before the first retry */
+    uint32_t backoff_max_us;       /**< Upper bound of the backoff delay */
+    bool jitter;                   /**< Randomize each delay in [delay / 2, delay] */
+    bool nack_only;                /**< Retry NACKs only, not timeouts */
+    uint32_t breaker_threshold;    /**< Consecutive failed calls to open (0 = off) */
+    uint32_t breaker_cooldown_us;  /**< Time the breaker stays open */
+} I2C_RetryPolicy_t;
+
+/**
+ * @brief Per-device retry counters (see I2C_GetRetryStats).
+ */
+typedef struct
+{
+    uint32_t calls;          /**< Transfers requested by callers */
+    uint32_t attempts;       /**< Bus transactions issued, including retries */
+    uint32_t retries;        /**< Attempts after the first */
+    uint32_t recovered;      /**< Calls that succeeded after a retry */
+    uint32_t exhausted;      /**< Calls that failed on their last allowed attempt */
+    uint32_t fast_fails;     /**< Calls rejected while the breaker was open */
+    uint32_t breaker_trips;  /**< Times the breaker opened */
+    uint32_t backoff_us;     /**< Total time spent in backoff delays */
+    bool breaker_open;       /**< Breaker currently open */
+} I2C_RetryStats_t;
+
 /* -------------------------------------------------------------------------- */
 /*                               Internal Handle                               */
 /* -------------------------------------------------------------------------- */
 
 typedef struct
 {
-    I2C_Speed_t speed;
+    I2C_Speed_t speed;            /**< Bus default */
+    I2C_Speed_t active_speed;     /**< Speed the peripheral is programmed for */
     I2C_AddressMode_t addressing_mode;
+    uint32_t speed_switches;      /**< Times the clock was reprogrammed for a device */
+    uint32_t recoveries;          /**< Bus recovery sequences run */
+    uint32_t recovery_failures;   /**< Recoveries that left SDA low */
+    uint32_t stretch_timeouts;    /**< Phases aborted after I2C_STRETCH_TIMEOUT_US */
+    uint32_t nacks;               /**< Address or data NACKs */
+    uint32_t rng;                 /**< Backoff jitter state (xorshift32) */
 } I2C_Handle_t;
 
+/**
+ * @brief Bus error counters (see I2C_GetBusStats).
+ */
+typedef struct
+{
+    uint32_t recoveries;
+    uint32_t recovery_failures;
+    uint32_t stretch_timeouts;
+    uint32_t nacks;
+    uint32_t speed_switches;
+} I2C_BusStats_t;
+
 /* -------------------------------------------------------------------------- */
 /*                           Public API Function Prototypes                    */
 /* -------------------------------------------------------------------------- */
@@ -113,4 +244,144 @@ I2C_Status_t I2C_ReadByte(uint8_t dev_addr, uint8_t *data);
  */
 I2C_Status_t I2C_ReadBuffer(uint8_t dev_addr, uint8_t *buffer, uint32_t len);
 
+/**
+ * @brief Execute a sequence of read/write segments in one bus tenure.
+ *
+ * Each segment starts with a repeated START and its address (the first with
+ * a plain START) unless it has I2C_M_NOSTART, in which case its bytes
+ * directly continue the previous segment in the same direction. A single
+ * STOP ends the transfer. The last byte of a read is NACKed unless the next
+ * segment continues the read. Segments with I2C_M_IGNORE_NAK carry on past
+ * a NACKed address or data byte.
+ *
+ * Typical register read:
+ * @code
+ * uint8_t reg = 0x00, value[2];
+ * I2C_Msg_t msgs[] = {
+ *     { .addr = 0x48, .flags = 0,         .len = 1, .buf = &reg },
+ *     { .addr = 0x48, .flags = I2C_M_RD,  .len = 2, .buf = value },
+ * };
+ * I2C_Transfer(msgs, 2);
+ * @endcode
+ *
+ * The retry policy and per-device latency of msgs[0].addr apply.
+ *
+ * @param msgs  Segments, executed in order
+ * @param count Number of segments
+ * @return I2C_STATUS_ERROR for an invalid sequence (no bus activity),
+ *         otherwise the status of the first failing segment
+ */
+I2C_Status_t I2C_Transfer(const I2C_Msg_t *msgs, uint32_t count);
+
+/**
+ * @brief Read @p stream->len bytes in one transaction, a chunk at a time.
+ *
+ * Writes the optional command bytes, then reads with a repeated START (or
+ * a plain START without command) and a single STOP, however long the read:
+ * a 64 KiB EEPROM dump needs only a chunk_len buffer and one address
+ * setup. Each time the chunk buffer fills it is passed to on_chunk; the
+ * last chunk may be shorter. While on_chunk runs, the controller receives
+ * at most the next two bytes and then holds SCL low until reading resumes,
+ * so a slow consumer pauses the bus instead of losing data.
+ *
+ * If on_chunk returns false the read ends as soon as the protocol allows:
+ * up to three more bytes are clocked in to reach the NACK and STOP, and
+ * discarded. stream->delivered tells how much data was handed over.
+ *
+ * The device's speed profile applies and its breaker is honoured, but a
+ * failure is not retried: the chunks delivered cannot be taken back.
+ *
+ * @return I2C_STATUS_ERROR for a missing buffer or callback (no bus
+ *         activity), otherwise the transaction status
+ */
+I2C_Status_t I2C_ReadStream(uint8_t dev_addr, I2C_Stream_t *stream);
+
+/**
+ * @brief Free a bus whose SDA line is held low by a slave.
+ *
+ * Clocks up to I2C_RECOVERY_PULSES SCL pulses until SDA is released, sends a
+ * STOP, then resets and re-initializes the peripheral. The driver runs this
+ * automatically before a START when SDA is low and after a failed
+ * transaction that leaves SDA low.
+ *
+ * @return I2C_STATUS_OK, or I2C_STATUS_BUS_STUCK if SDA is still low
+ */
+I2C_Status_t I2C_RecoverBus(void);
+
+/**
+ * @brief Copy the bus error counters (reset by I2C_Init).
+ */
+void I2C_GetBusStats(I2C_BusStats_t *stats);
+
+/**
+ * @brief Install (or with @p policy NULL, remove) the retry policy of a device.
+ *
+ * Applies to I2C_WriteByte, I2C_WriteBuffer, I2C_ReadByte, I2C_ReadBuffer and
+ * I2C_Transfer.
+ * Devices without a policy get a single attempt, as before. Policies and
+ * their counters are cleared by I2C_Init.
+ *
+ * @return false if all I2C_MAX_DEVICES policy slots are taken
+ */
+bool I2C_SetRetryPolicy(uint8_t dev_addr, const I2C_RetryPolicy_t *policy);
+
+/**
+ * @brief Give @p dev_addr its own bus speed.
+ *
+ * On a bus shared by fast and slow devices, each transaction runs at the
+ * speed of the device it addresses instead of the whole bus running at the
+ * slowest one. The clock is reprogrammed before the START, only when the
+ * speed differs from the one currently set, so back-to-back transactions
+ * at the same speed cost nothing extra. An I2C_Transfer() addressing
+ * several devices runs at the slowest of their speeds.
+ *
+ * Slower devices still see the faster traffic addressed to others and must
+ * tolerate it (ignore it without holding the bus). Profiles are cleared by
+ * I2C_Init.
+ *
+ * @param speed I2C_SPEED_BUS_DEFAULT removes the profile
+ * @return false if all I2C_MAX_DEVICES profile slots are taken
+ */
+bool I2C_SetDeviceSpeed(uint8_t dev_addr, I2C_Speed_t speed);
+
+/**
+ * @brief Speed transactions to @p dev_addr run at.
+ */
+I2C_Speed_t I2C_GetDeviceSpeed(uint8_t dev_addr);
+
+/**
+ * @brief Copy the retry counters of @p dev_addr.
+ *
+ * @return false if the device has no retry policy
+ */
+bool I2C_GetRetryStats(uint8_t dev_addr, I2C_RetryStats_t *stats);
+
+/**
+ * @brief Snapshot the transaction latency histogram for @p op (timer ticks).
+ *
+ * @return false if latency statistics are compiled out
+ */
+bool I2C_GetLatency(I2C_LatencyOp_t op, HIST_Snapshot_t *snap);
+
+/**
+ * @brief Snapshot the latency histogram of all transactions to @p dev_addr.
+ *
+ * The first I2C_MAX_DEVICES addresses used get their own histogram.
+ *
+ * @return false if @p dev_addr has no histogram
+ */
+bool I2C_GetDeviceLatency(uint8_t dev_addr, HIST_Snapshot_t *snap);
+
+/**
+ * @brief Addresses that have a per-device histogram.
+ *
+ * @return Number of addresses written to @p addrs (at most @p max)
+ */
+uint32_t I2C_GetLatencyDevices(uint8_t *addrs, uint32_t max);
+
+/**
+ * @brief Clear all I2C latency histograms and per-device slots.
+ */
+void I2C_ResetLatency(void);
+
 #endif /* I2C_H */
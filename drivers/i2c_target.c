@@ -0,0 +1,180 @@
+/**
+ * @file i2c_target.c
+ * @brief I2C target (slave) mode with a zero-copy register map.
+ *
+ * All bus work happens in I2CT_EventIRQHandler(). The ACK for a written byte
+ * has to be decided before it arrives, so after each byte the handler arms
+ * ACK or NACK for the next one from where the pointer now stands. A NACKed
+ * byte still raises RXNE; it is counted and dropped.
+ *
+ * Reads work the other way round: the next byte is loaded while the current
+ * one is on the wire, so when the host NACKs its last byte one more has
+ * already been taken from the map. The handler puts it back.
+ */
+
+#include <stddef.h>
+
+#include "i2c_target.h"
+#include "../include/hal_i2c.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+static struct
+{
+    I2CT_Config_t config;
+    uint32_t pointer;
+    bool expect_pointer;      /* Next byte written is the register pointer */
+    uint32_t dirty_reg;       /* Range written in the current transaction */
+    uint32_t dirty_len;
+    bool tx_loaded;           /* DR holds a byte the host has not read yet */
+    bool tx_loaded_overrun;   /* ... and it is 0xFF from past the map */
+    I2CT_Stats_t stats;
+} i2ct;
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+/* A write transaction ended (STOP or repeated START): report what changed */
+static void I2CT_EndWrite(void)
+{
+    if (i2ct.dirty_len == 0)
+        return;
+
+    if (i2ct.config.on_write != NULL)
+        i2ct.config.on_write(i2ct.dirty_reg, i2ct.dirty_len);
+    i2ct.dirty_len = 0;
+}
+
+static void I2CT_Receive(uint8_t byte)
+{
+    if (i2ct.expect_pointer)
+    {
+        i2ct.pointer = byte;
+        i2ct.expect_pointer = false;
+    }
+    else if (i2ct.pointer < i2ct.config.writable_size)
+    {
+        if (i2ct.dirty_len == 0)
+            i2ct.dirty_reg = i2ct.pointer;
+        i2ct.dirty_len++;
+        i2ct.config.map[i2ct.pointer++] = byte;
+        i2ct.stats.bytes_written++;
+    }
+    else
+    {
+        i2ct.stats.write_nacks++;
+    }
+
+    HAL_I2C_TargetSetAck(i2ct.pointer < i2ct.config.writable_size);
+}
+
+static uint8_t I2CT_Transmit(void)
+{
+    i2ct.tx_loaded = true;
+    i2ct.tx_loaded_overrun = i2ct.pointer >= i2ct.config.map_size;
+
+    if (i2ct.tx_loaded_overrun)
+    {
+        i2ct.stats.read_overruns++;
+        return 0xFF;
+    }
+
+    i2ct.stats.bytes_read++;
+    return i2ct.config.map[i2ct.pointer++];
+}
+
+/* The read is over: the byte preloaded behind the host's last one stays unsent */
+static void I2CT_UnloadTx(void)
+{
+    if (!i2ct.tx_loaded)
+        return;
+
+    if (i2ct.tx_loaded_overrun)
+    {
+        i2ct.stats.read_overruns--;
+    }
+    else
+    {
+        i2ct.pointer--;
+        i2ct.stats.bytes_read--;
+    }
+    i2ct.tx_loaded = false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+bool I2CT_Init(const I2CT_Config_t *config)
+{
+    if (config->map == NULL || config->map_size == 0 || config->map_size > I2CT_MAX_MAP_SIZE)
+        return false;
+
+    i2ct.config = *config;
+    if (i2ct.config.writable_size > i2ct.config.map_size)
+        i2ct.config.writable_size = i2ct.config.map_size;
+
+    i2ct.pointer = 0;
+    i2ct.expect_pointer = false;
+    i2ct.dirty_len = 0;
+    i2ct.tx_loaded = false;
+    i2ct.stats = (I2CT_Stats_t){ 0 };
+
+    HAL_I2C_TargetEnable(config->own_address);
+    return true;
+}
+
+void I2CT_Deinit(void)
+{
+    HAL_I2C_TargetDisable();
+}
+
+void I2CT_EventIRQHandler(void)
+{
+    if (HAL_I2C_TargetIsAddressed())
+    {
+        I2CT_EndWrite();
+        I2CT_UnloadTx();
+
+        /* A write starts with the pointer byte, which is always accepted */
+        i2ct.expect_pointer = !HAL_I2C_TargetIsTransmitter();
+        i2ct.stats.transactions++;
+        HAL_I2C_TargetSetAck(true);
+        HAL_I2C_TargetClearAddress();
+    }
+
+    if (HAL_I2C_TargetIsRxReady())
+        I2CT_Receive(HAL_I2C_TargetReadData());
+
+    if (HAL_I2C_TargetIsTxEmpty())
+        HAL_I2C_TargetWriteData(I2CT_Transmit());
+
+    /* The host NACKed its last byte: nothing more is read */
+    if (HAL_I2C_TargetIsNacked())
+    {
+        HAL_I2C_TargetClearNack();
+        I2CT_UnloadTx();
+    }
+
+    /* Also covers a host that ACKed its last byte before the STOP */
+    if (HAL_I2C_TargetIsStopDetected())
+    {
+        HAL_I2C_TargetClearStop();
+        I2CT_EndWrite();
+        I2CT_UnloadTx();
+        HAL_I2C_TargetSetAck(true);
+    }
+}
+
+uint32_t I2CT_GetPointer(void)
+{
+    return i2ct.pointer;
+}
+
+void I2CT_GetStats(I2CT_Stats_t *stats)
+{
+    *stats = i2ct.stats;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file i2c_target.h
+ * @brief I2C target (slave) mode with a zero-copy register map.
+ *
+ * Makes the board look like a typical register-based I2C device to a host
+ * controller. The application hands over a block of its own memory; the
+ * host accesses it through an auto-incrementing register pointer:
+ *
+ *  - write [reg] [d0] [d1] ...   sets the pointer to reg, then stores the
+ *                                data bytes at reg, reg + 1, ...
+ *  - write [reg], (re)START, read n   returns n bytes starting at reg
+ *  - read n                      continues from where the pointer is
+ *
+ * Bytes go straight between the bus and the map from the event interrupt,
+ * with no per-byte callback. Bytes from writable_size onwards are
+ * read-only: the target NACKs a write into them. Reads past the end of the
+ * map return 0xFF. The optional on_write callback runs once per write
+ * transaction, at its STOP or repeated START, with the range that changed.
+ *
+ * The map is shared with the interrupt: values wider than a byte can change
+ * between two application reads while the host is writing. Use on_write to
+ * pick up new values.
+ */
+
+#ifndef I2C_TARGET_H
+#define I2C_TARGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define I2CT_MAX_MAP_SIZE   256U   /* Reachable with a one-byte register pointer */
+
+/**
+ * @brief Target configuration.
+ */
+typedef struct
+{
+    uint8_t own_address;        /**< 7-bit address the target answers to */
+    uint8_t *map;               /**< Register map in application memory */
+    uint32_t map_size;          /**< Bytes in the map (1..I2CT_MAX_MAP_SIZE) */
+    uint32_t writable_size;     /**< Bytes [0, writable_size) the host may write */
+    void (*on_write)(uint32_t reg, uint32_t len);   /**< After a write (NULL: none) */
+} I2CT_Config_t;
+
+/**
+ * @brief Target counters (see I2CT_GetStats).
+ */
+typedef struct
+{
+    uint32_t transactions;   /**< Address matches */
+    uint32_t bytes_written;  /**< Data bytes stored from the host */
+    uint32_t bytes_read;     /**< Bytes sent to the host */
+    uint32_t write_nacks;    /**< Host writes refused (read-only or past the end) */
+    uint32_t read_overruns;  /**< Bytes read past the end of the map (sent as 0xFF) */
+} I2CT_Stats_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Start answering to config->own_address with the register map.
+ *
+ * @return false if the map is missing or larger than I2CT_MAX_MAP_SIZE
+ */
+bool I2CT_Init(const I2CT_Config_t *config);
+
+/**
+ * @brief Stop answering on the bus.
+ */
+void I2CT_Deinit(void);
+
+/**
+ * @brief Target event interrupt handler (I2C2 event vector).
+ */
+void I2CT_EventIRQHandler(void);
+
+/**
+ * @brief Current register pointer.
+ */
+uint32_t I2CT_GetPointer(void);
+
+/**
+ * @brief Copy the target counters (reset by I2CT_Init).
+ */
+void I2CT_GetStats(I2CT_Stats_t *stats);
+
+#endif /* I2C_TARGET_H */
@@ -0,0 +1,275 @@
+/**
+ * @file line_scan.c
+ * @brief Zero-copy line framing over the UART RX buffer.
+ *
+ * LINE_FindAny() picks the widest scanner the target has at compile time:
+ * SSE2 or NEON (16 bytes per compare), otherwise SWAR on 32-bit words. All
+ * of them hand the last few bytes to the scalar loop.
+ */
+
+#include <string.h>
+
+#include "line_scan.h"
+
+#if LINE_SCAN_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#define LINE_SCAN_SSE2   1
+#elif LINE_SCAN_SIMD && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LINE_SCAN_NEON   1
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+#if defined(LINE_SCAN_SSE2)
+
+static uint32_t LINE_FindAnyVector(const uint8_t *data, uint32_t len, const uint8_t *delims,
+                                   uint32_t count)
+{
+    __m128i pattern[LINE_MAX_DELIMITERS];
+    uint32_t i = 0;
+
+    for (uint32_t d = 0; d < count; d++)
+        pattern[d] = _mm_set1_epi8((char)delims[d]);
+
+    for (; i + 16U <= len; i += 16U)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(const void *)&data[i]);
+        __m128i hit = _mm_cmpeq_epi8(block, pattern[0]);
+
+        for (uint32_t d = 1; d < count; d++)
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, pattern[d]));
+
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask != 0)
+            return i + (uint32_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+
+#elif defined(LINE_SCAN_NEON)
+
+static uint32_t LINE_FindAnyVector(const uint8_t *data, uint32_t len, const uint8_t *delims,
+                                   uint32_t count)
+{
+    uint8x16_t pattern[LINE_MAX_DELIMITERS];
+    uint32_t i = 0;
+
+    for (uint32_t d = 0; d < count; d++)
+        pattern[d] = vdupq_n_u8(delims[d]);
+
+    for (; i + 16U <= len; i += 16U)
+    {
+        uint8x16_t block = vld1q_u8(&data[i]);
+        uint8x16_t hit = vceqq_u8(block, pattern[0]);
+
+        for (uint32_t d = 1; d < count; d++)
+            hit = vorrq_u8(hit, vceqq_u8(block, pattern[d]));
+
+        /* Narrow to one nibble per byte: a 64-bit mask in byte order */
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask != 0)
+            return i + (uint32_t)(__builtin_ctzll(mask) >> 2);
+    }
+    return i;
+}
+
+#elif LINE_SCAN_SIMD
+
+#define LINE_ONES    0x01010101U
+#define LINE_LOWS    0x7F7F7F7FU
+#define LINE_HIGHS   0x80808080U
+
+static uint32_t LINE_FindAnyVector(const uint8_t *data, uint32_t len, const uint8_t *delims,
+                                   uint32_t count)
+{
+    uint32_t pattern[LINE_MAX_DELIMITERS];
+    uint32_t i = 0;
+
+    for (uint32_t d = 0; d < count; d++)
+        pattern[d] = delims[d] * LINE_ONES;
+
+    for (; i + 4U <= len; i += 4U)
+    {
+        uint32_t word;
+        uint32_t hit = 0;
+
+        memcpy(&word, &data[i], sizeof(word));
+
+        /* High bit set in exactly the bytes that are zero after the XOR.
+         * No borrow crosses bytes, so the first hit is right whichever
+         * end of the word it sits at */
+        for (uint32_t d = 0; d < count; d++)
+        {
+            uint32_t x = word ^ pattern[d];
+            hit |= ~(((x & LINE_LOWS) + LINE_LOWS) | x) & LINE_HIGHS;
+        }
+
+        if (hit != 0)
+        {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            return i + (uint32_t)(__builtin_clz(hit) >> 3);
+#else
+            return i + (uint32_t)(__builtin_ctz(hit) >> 3);
+#endif
+        }
+    }
+    return i;
+}
+
+#endif
+
+/* Find a delimiter in the RX view at or after @p from; returns @p avail if none */
+static uint32_t LINE_ScanView(const LINE_Reader_t *reader, const UART_RxView_t *view,
+                              uint32_t from, uint32_t avail)
+{
+    const uint32_t first = view->span[0].len;
+
+    if (from < first)
+    {
+        uint32_t pos = from + LINE_FindAny(view->span[0].data + from, first - from,
+                                           reader->delimiters, reader->delimiter_count);
+        if (pos < first)
+            return pos;
+        from = first;
+    }
+
+    return from + LINE_FindAny(view->span[1].data + (from - first), avail - from,
+                               reader->delimiters, reader->delimiter_count);
+}
+
+static void LINE_Drop(LINE_Reader_t *reader, uint32_t count)
+{
+    UART_RxConsume(count);
+    reader->scanned = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+uint32_t LINE_FindAnyScalar(const uint8_t *data, uint32_t len, const uint8_t *delims,
+                            uint32_t count)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        for (uint32_t d = 0; d < count; d++)
+        {
+            if (data[i] == delims[d])
+                return i;
+        }
+    }
+    return len;
+}
+
+uint32_t LINE_FindAny(const uint8_t *data, uint32_t len, const uint8_t *delims, uint32_t count)
+{
+    uint32_t i = 0;
+
+    if (count == 0)
+        return len;
+
+#if LINE_SCAN_SIMD
+    /* Stops on the block holding the first hit, or before the tail */
+    i = LINE_FindAnyVector(data, len, delims, count);
+#endif
+
+    return i + LINE_FindAnyScalar(data + i, len - i, delims, count);
+}
+
+void LINE_Init(LINE_Reader_t *reader, const LINE_Config_t *config)
+{
+    const char *delims = (config->delimiters != NULL) ? config->delimiters : "\r\n";
+
+    reader->delimiter_count = 0;
+    while (delims[reader->delimiter_count] != '\0' &&
+           reader->delimiter_count < LINE_MAX_DELIMITERS)
+    {
+        reader->delimiters[reader->delimiter_count] = (uint8_t)delims[reader->delimiter_count];
+        reader->delimiter_count++;
+    }
+
+    reader->max_line = config->max_line;
+    if (reader->max_line == 0 || reader->max_line > UART_RX_BUFFER_SIZE - 1U)
+        reader->max_line = UART_RX_BUFFER_SIZE - 1U;
+
+    reader->scanned = 0;
+    reader->pending = 0;
+    reader->discarding = false;
+    reader->lines = 0;
+    reader->overlong = 0;
+}
+
+bool LINE_Next(LINE_Reader_t *reader, LINE_Line_t *line)
+{
+    UART_RxView_t view;
+
+    if (reader->pending != 0)
+        return false;
+
+    UART_PollRx();
+
+    for (;;)
+    {
+        uint32_t avail = UART_RxPeek(&view);
+        uint32_t pos = LINE_ScanView(reader, &view, reader->scanned, avail);
+
+        if (pos == avail)
+        {
+            /* No delimiter yet: remember how far we looked */
+            reader->scanned = avail;
+
+            if (reader->discarding)
+            {
+                LINE_Drop(reader, avail);
+            }
+            else if (avail > reader->max_line || UART_IsRxThrottled())
+            {
+                /* A throttled sender sends nothing more until we consume */
+                reader->overlong++;
+                reader->discarding = true;
+                LINE_Drop(reader, avail);
+            }
+            return false;
+        }
+
+        if (reader->discarding || pos > reader->max_line)
+        {
+            if (!reader->discarding)
+                reader->overlong++;
+            reader->discarding = false;
+            LINE_Drop(reader, pos + 1U);
+            continue;
+        }
+
+        if (pos == 0)
+        {
+            LINE_Drop(reader, 1);   /* Empty line, e.g. the LF of CRLF */
+            continue;
+        }
+
+        uint32_t first = (pos < view.span[0].len) ? pos : view.span[0].len;
+
+        line->span[0].data = view.span[0].data;
+        line->span[0].len = first;
+        line->span[1].data = view.span[1].data;
+        line->span[1].len = pos - first;
+        line->len = pos;
+
+        reader->pending = pos + 1U;
+        reader->lines++;
+        return true;
+    }
+}
+
+void LINE_Release(LINE_Reader_t *reader)
+{
+    if (reader->pending == 0)
+        return;
+
+    LINE_Drop(reader, reader->pending);
+    reader->pending = 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file line_scan.h
+ * @brief Zero-copy line framing over the UART RX buffer.
+ *
+ * Splits received data into lines at any of up to LINE_MAX_DELIMITERS
+ * delimiter bytes (default "\r\n", so CR, LF and CRLF endings all work;
+ * the empty "line" between CR and LF is skipped). Complete lines are handed
+ * out as spans into the driver's RX ring (UART_RxPeek), so nothing is
+ * copied; LINE_Release() consumes the line once the caller is done.
+ *
+ * Delimiters are found with LINE_FindAny(), a memchr-style scan that
+ * compares 16 bytes per step with SSE2 (x86 hosts) or NEON (Cortex-A), and
+ * 4 bytes per step with word-at-a-time (SWAR) arithmetic elsewhere, such as
+ * Cortex-M cores that have no vector unit. Build with -DLINE_SCAN_SIMD=0 to
+ * force the byte loop. Bytes already scanned are not scanned again while a
+ * line is still incomplete.
+ *
+ * Lines longer than max_line are discarded up to their delimiter and
+ * counted, so a runaway sender cannot wedge the reader. So is a line that
+ * gets the sender throttled before its delimiter arrives: with flow control
+ * the buffer stops at the high watermark and the line could never finish.
+ */
+
+#ifndef LINE_SCAN_H
+#define LINE_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "uart.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#ifndef LINE_SCAN_SIMD
+#define LINE_SCAN_SIMD        1
+#endif
+
+#define LINE_MAX_DELIMITERS   4U
+
+/**
+ * @brief Line reader configuration.
+ */
+typedef struct
+{
+    const char *delimiters;   /**< Any of these bytes ends a line (NULL: "\r\n") */
+    uint32_t max_line;        /**< Longest accepted line (0: UART_RX_BUFFER_SIZE - 1) */
+} LINE_Config_t;
+
+/**
+ * @brief One complete line, without its delimiter.
+ *
+ * The line may wrap around the RX ring, so it is described by up to two
+ * spans (span[1].len is 0 when it does not wrap).
+ */
+typedef struct
+{
+    UART_RxSpan_t span[2];
+    uint32_t len;
+} LINE_Line_t;
+
+/**
+ * @brief Line reader state.
+ */
+typedef struct
+{
+    uint8_t delimiters[LINE_MAX_DELIMITERS];
+    uint32_t delimiter_count;
+    uint32_t max_line;
+    uint32_t scanned;         /**< Bytes at the front of the RX buffer known to hold no delimiter */
+    uint32_t pending;         /**< Bytes (line + delimiter) to release */
+    bool discarding;          /**< Dropping the rest of an overlong line */
+    uint32_t lines;           /**< Lines handed out */
+    uint32_t overlong;        /**< Lines discarded for exceeding max_line */
+} LINE_Reader_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Initialize @p reader (does not touch data already in the RX buffer).
+ */
+void LINE_Init(LINE_Reader_t *reader, const LINE_Config_t *config);
+
+/**
+ * @brief Get the next complete line from the UART RX buffer.
+ *
+ * Polls the UART first. The line stays valid, and no further line is
+ * returned, until LINE_Release().
+ *
+ * @return true if @p line was filled
+ */
+bool LINE_Next(LINE_Reader_t *reader, LINE_Line_t *line);
+
+/**
+ * @brief Consume the line returned by the last LINE_Next() and its delimiter.
+ */
+void LINE_Release(LINE_Reader_t *reader);
+
+/**
+ * @brief Index of the first byte of @p data that equals any of @p delims.
+ *
+ * @return Index, or @p len if there is none
+ */
+uint32_t LINE_FindAny(const uint8_t *data, uint32_t len, const uint8_t *delims, uint32_t count);
+
+/**
+ * @brief Byte-at-a-time reference for LINE_FindAny() (tests, benchmarks).
+ */
+uint32_t LINE_FindAnyScalar(const uint8_t *data, uint32_t len, const uint8_t *delims,
+                            uint32_t count);
+
+#endif /* LINE_SCAN_H */
@@ -0,0 +1,195 @@
+/**
+ * @file log_token.c
+ * @brief Tokenized log frame encoder/decoder and minimal formatter.
+ *
+ * See log_token.h for the wire format. The formatter deliberately supports
+ * only integer conversions: tokenized arguments are 32-bit integers, and the
+ * same code expands frames on the host and formats text on the target.
+ */
+
+#include <stdbool.h>
+
+#include "log_token.h"
+#include "varint.h"
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static void LOG_PutNumber(uint32_t value, uint32_t base, bool upper, bool negative,
+                          uint32_t width, char pad, LOG_PutChar_t put)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buffer[32];
+    uint32_t len = 0;
+
+    do
+    {
+        buffer[len++] = digits[value % base];
+        value /= base;
+    } while (value != 0);
+
+    if (negative)
+    {
+        if (width > 0)
+            width--;
+        if (pad == '0')
+            put('-');
+    }
+
+    while (width > len && width-- > 0)
+        put(pad);
+
+    if (negative && pad != '0')
+        put('-');
+
+    while (len > 0)
+        put(buffer[--len]);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+uint32_t LOG_EncodeFrame(uint16_t id, const int32_t *args, uint32_t argc, uint8_t *out)
+{
+    uint32_t len = 0;
+
+    if (argc > LOG_MAX_ARGS)
+        argc = LOG_MAX_ARGS;
+
+    out[len++] = LOG_FRAME_SYNC;
+    len += VARINT_Encode(id & LOG_MAX_ID, &out[len]);
+    out[len++] = (uint8_t)argc;
+
+    for (uint32_t i = 0; i < argc; i++)
+        len += VARINT_Encode(VARINT_ZigZag(args[i]), &out[len]);
+
+    return len;
+}
+
+LOG_DecodeStatus_t LOG_DecodeFrame(const uint8_t *in, uint32_t len,
+                                   LOG_Frame_t *frame, uint32_t *consumed)
+{
+    uint32_t pos = 1;
+    uint32_t value;
+    uint32_t n;
+
+    if (len == 0 || in[0] != LOG_FRAME_SYNC)
+        return LOG_DECODE_INVALID;
+
+    n = VARINT_Decode(&in[pos], len - pos, &value);
+    if (n == 0)
+        return (len - pos < VARINT_MAX_BYTES) ? LOG_DECODE_INCOMPLETE : LOG_DECODE_INVALID;
+    if (value > LOG_MAX_ID)
+        return LOG_DECODE_INVALID;
+    frame->id = (uint16_t)value;
+    pos += n;
+
+    if (pos >= len)
+        return LOG_DECODE_INCOMPLETE;
+    if (in[pos] > LOG_MAX_ARGS)
+        return LOG_DECODE_INVALID;
+    frame->argc = in[pos++];
+
+    for (uint32_t i = 0; i < frame->argc; i++)
+    {
+        n = VARINT_Decode(&in[pos], len - pos, &value);
+        if (n == 0)
+            return (len - pos < VARINT_MAX_BYTES) ? LOG_DECODE_INCOMPLETE : LOG_DECODE_INVALID;
+
+        frame->args[i] = VARINT_UnZigZag(value);
+        pos += n;
+    }
+
+    *consumed = pos;
+    return LOG_DECODE_OK;
+}
+
+void LOG_Format(const char *format, const int32_t *args, uint32_t argc, LOG_PutChar_t put)
+{
+    uint32_t next = 0;
+
+    while (*format)
+    {
+        if (*format != '%')
+        {
+            put(*format++);
+            continue;
+        }
+
+        format++;
+        if (*format == '%')
+        {
+            put(*format++);
+            continue;
+        }
+
+        char pad = ' ';
+        uint32_t width = 0;
+
+        if (*format == '0')
+        {
+            pad = '0';
+            format++;
+        }
+        while (*format >= '0' && *format <= '9')
+            width = width * 10U + (uint32_t)(*format++ - '0');
+
+        int32_t value = (next < argc) ? args[next] : 0;
+        next++;
+
+        switch (*format)
+        {
+        case 'd':
+        case 'i':
+            if (value < 0)
+                LOG_PutNumber(0U - (uint32_t)value, 10, false, true, width, pad, put);
+            else
+                LOG_PutNumber((uint32_t)value, 10, false, false, width, pad, put);
+            break;
+        case 'u':
+            LOG_PutNumber((uint32_t)value, 10, false, false, width, pad, put);
+            break;
+        case 'x':
+        case 'X':
+            LOG_PutNumber((uint32_t)value, 16, *format == 'X', false, width, pad, put);
+            break;
+        case 'c':
+            put((char)value);
+            break;
+        case '\0':
+            return;
+        default:
+            put('%');
+            put(*format);
+            break;
+        }
+        format++;
+    }
+}
+
+uint32_t LOG_CountArgs(const char *format)
+{
+    uint32_t count = 0;
+
+    while (*format)
+    {
+        if (*format++ != '%')
+            continue;
+
+        if (*format == '%')
+        {
+            format++;
+            continue;
+        }
+
+        while (*format >= '0' && *format <= '9')
+            format++;
+
+        if (*format != '\0')
+            count++;
+    }
+
+    return count;
+}
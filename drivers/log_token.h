@@ -0,0 +1,90 @@
+/**
+ * @file log_token.h
+ * @brief Wire format for tokenized (deferred) log messages.
+ *
+ * Instead of sending formatted text, the firmware sends a compact frame:
+ *
+ *   [LOG_FRAME_SYNC][varint id][argc][argc x zig-zag varint argument]
+ *
+ * where `id` indexes a table of constant format strings that is fixed at
+ * build time (see src/log_strings.def). The host decoder (tools/log_decode.c)
+ * is built from the same table and expands frames back into text. Bytes
+ * outside frames are passed through untouched, so tokenized logs and plain
+ * text can share one UART.
+ *
+ * This module is pure encoding/decoding and has no UART dependency, so it is
+ * linked into both the firmware and the host tools.
+ */
+
+#ifndef LOG_TOKEN_H
+#define LOG_TOKEN_H
+
+#include <stdint.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define LOG_FRAME_SYNC      0xF5U   /* Never valid in ASCII or UTF-8 text */
+#define LOG_MAX_ARGS        4U
+#define LOG_MAX_ID          0x3FFFU /* IDs fit in a two-byte varint */
+#define LOG_MAX_FRAME       (1U + 2U + 1U + LOG_MAX_ARGS * 5U)
+
+typedef enum
+{
+    LOG_DECODE_OK = 0,
+    LOG_DECODE_INCOMPLETE,   /**< Need more bytes */
+    LOG_DECODE_INVALID       /**< Not a valid frame; skip the sync byte */
+} LOG_DecodeStatus_t;
+
+/**
+ * @brief One decoded log frame.
+ */
+typedef struct
+{
+    uint16_t id;
+    uint8_t argc;
+    int32_t args[LOG_MAX_ARGS];
+} LOG_Frame_t;
+
+/**
+ * @brief Output callback used by LOG_Format().
+ */
+typedef void (*LOG_PutChar_t)(char c);
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Encode a frame into @p out (at least LOG_MAX_FRAME bytes).
+ *
+ * @param id    Format string ID (<= LOG_MAX_ID)
+ * @param args  Argument values
+ * @param argc  Number of arguments (<= LOG_MAX_ARGS, extra ones are dropped)
+ * @return Frame length in bytes
+ */
+uint32_t LOG_EncodeFrame(uint16_t id, const int32_t *args, uint32_t argc, uint8_t *out);
+
+/**
+ * @brief Decode the frame starting at @p in[0] (which must be LOG_FRAME_SYNC).
+ *
+ * @param consumed Set to the frame length on LOG_DECODE_OK
+ */
+LOG_DecodeStatus_t LOG_DecodeFrame(const uint8_t *in, uint32_t len,
+                                   LOG_Frame_t *frame, uint32_t *consumed);
+
+/**
+ * @brief Expand a printf-style format with 32-bit integer arguments.
+ *
+ * Supports %d %i %u %x %X %c and %% with an optional zero flag and width
+ * (e.g. %08X). Missing arguments print as 0.
+ */
+void LOG_Format(const char *format, const int32_t *args, uint32_t argc, LOG_PutChar_t put);
+
+/**
+ * @brief Number of argument conversions in @p format.
+ */
+uint32_t LOG_CountArgs(const char *format);
+
+#endif /* LOG_TOKEN_H */
@@ -0,0 +1,75 @@
+/**
+ * @file mux_frame.c
+ * @brief Wire format for virtual channels multiplexed over one UART.
+ */
+
+#include <string.h>
+
+#include "mux_frame.h"
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+uint32_t MUX_EncodeFrame(uint8_t channel, uint8_t seq, const uint8_t *data, uint32_t len,
+                         uint8_t *out)
+{
+    if (len > MUX_MAX_CHUNK)
+        len = MUX_MAX_CHUNK;
+
+    out[0] = MUX_FRAME_SYNC;
+    out[1] = channel;
+    out[2] = seq;
+    out[3] = (uint8_t)len;
+    memcpy(&out[MUX_HEADER_BYTES], data, len);
+
+    uint32_t total = MUX_HEADER_BYTES + len;
+    uint8_t check = 0;
+    for (uint32_t k = 1; k < total; k++)
+        check ^= out[k];
+    out[total++] = check;
+
+    return total;
+}
+
+void MUX_DecoderInit(MUX_Decoder_t *dec)
+{
+    *dec = (MUX_Decoder_t){ 0 };
+}
+
+MUX_DecodeStatus_t MUX_DecodeFrame(MUX_Decoder_t *dec, const uint8_t *in, uint32_t len,
+                                   MUX_Frame_t *frame, uint32_t *consumed)
+{
+    if (len == 0 || in[0] != MUX_FRAME_SYNC)
+        return MUX_DECODE_INVALID;
+    if (len < MUX_HEADER_BYTES)
+        return MUX_DECODE_INCOMPLETE;
+
+    uint8_t channel = in[1];
+    uint32_t total = MUX_HEADER_BYTES + in[3] + 1U;
+
+    if (channel >= MUX_MAX_CHANNELS || in[3] > MUX_MAX_CHUNK)
+        return MUX_DECODE_INVALID;
+    if (len < total)
+        return MUX_DECODE_INCOMPLETE;
+
+    uint8_t check = 0;
+    for (uint32_t k = 1; k < total; k++)
+        check ^= in[k];
+    if (check != 0)
+        return MUX_DECODE_INVALID;
+
+    if ((dec->seen & (1U << channel)) && in[2] != dec->next_seq[channel])
+        dec->lost[channel] += (uint8_t)(in[2] - dec->next_seq[channel]);
+    dec->next_seq[channel] = (uint8_t)(in[2] + 1U);
+    dec->seen |= (uint8_t)(1U << channel);
+    dec->frames[channel]++;
+    dec->bytes[channel] += in[3];
+
+    frame->channel = channel;
+    frame->seq = in[2];
+    frame->len = in[3];
+    frame->data = &in[MUX_HEADER_BYTES];
+    *consumed = total;
+    return MUX_DECODE_OK;
+}
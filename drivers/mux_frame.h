@@ -0,0 +1,87 @@
+/**
+ * @file mux_frame.h
+ * @brief Wire format for virtual channels multiplexed over one UART.
+ *
+ * Each chunk of channel data travels in its own frame:
+ *
+ *   [MUX_FRAME_SYNC][channel][seq][len][len x data][xor]
+ *
+ *  - seq:  per-channel chunk counter, so the receiver can count lost chunks
+ *  - xor:  XOR of every byte between the sync byte and the checksum
+ *
+ * Chunks are at most MUX_MAX_CHUNK bytes, which bounds how long a frame of
+ * one channel can hold up a more urgent one (see uart_mux.h).
+ *
+ * Like log_token.h this is pure encoding/decoding and is linked into both
+ * the firmware and tools/mux_decode.c.
+ */
+
+#ifndef MUX_FRAME_H
+#define MUX_FRAME_H
+
+#include <stdint.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define MUX_FRAME_SYNC      0xF7U   /* Distinct from LOG_FRAME_SYNC and SAMPLE_BLOCK_SYNC */
+#define MUX_MAX_CHANNELS    4U
+#define MUX_MAX_CHUNK       32U
+#define MUX_HEADER_BYTES    4U
+#define MUX_MAX_FRAME       (MUX_HEADER_BYTES + MUX_MAX_CHUNK + 1U)
+
+typedef enum
+{
+    MUX_DECODE_OK = 0,
+    MUX_DECODE_INCOMPLETE,   /**< Need more bytes */
+    MUX_DECODE_INVALID       /**< Not a valid frame; skip the sync byte */
+} MUX_DecodeStatus_t;
+
+/**
+ * @brief One decoded frame; data points into the input buffer.
+ */
+typedef struct
+{
+    uint8_t channel;
+    uint8_t seq;
+    uint8_t len;
+    const uint8_t *data;
+} MUX_Frame_t;
+
+/**
+ * @brief Receiver state for MUX_DecodeFrame().
+ */
+typedef struct
+{
+    uint8_t next_seq[MUX_MAX_CHANNELS];
+    uint8_t seen;                        /**< Bit per channel: next_seq is valid */
+    uint32_t frames[MUX_MAX_CHANNELS];
+    uint32_t bytes[MUX_MAX_CHANNELS];
+    uint32_t lost[MUX_MAX_CHANNELS];     /**< Chunks missing from the sequence */
+} MUX_Decoder_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Encode one chunk into @p out (at least MUX_MAX_FRAME bytes).
+ *
+ * @param len Chunk length (extra bytes beyond MUX_MAX_CHUNK are not sent)
+ * @return Frame length in bytes
+ */
+uint32_t MUX_EncodeFrame(uint8_t channel, uint8_t seq, const uint8_t *data, uint32_t len,
+                         uint8_t *out);
+
+void MUX_DecoderInit(MUX_Decoder_t *dec);
+
+/**
+ * @brief Decode the frame starting at @p in[0] (which must be MUX_FRAME_SYNC).
+ *
+ * @param consumed Set to the frame length on MUX_DECODE_OK
+ */
+MUX_DecodeStatus_t MUX_DecodeFrame(MUX_Decoder_t *dec, const uint8_t *in, uint32_t len,
+                                   MUX_Frame_t *frame, uint32_t *consumed);
+
+#endif /* MUX_FRAME_H */
@@ -0,0 +1,224 @@
+/**
+ * @file sample_codec.c
+ * @brief Delta/varint block encoder and decoder for sensor sample streams.
+ *
+ * See sample_codec.h for the wire format. Deltas are computed with unsigned
+ * wrap-around so any pair of int32_t samples round-trips exactly.
+ */
+
+#include <stddef.h>
+
+#include "sample_codec.h"
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static int32_t SAMPLE_Delta(int32_t value, int32_t reference)
+{
+    return (int32_t)((uint32_t)value - (uint32_t)reference);
+}
+
+static int32_t SAMPLE_Apply(int32_t reference, int32_t delta)
+{
+    return (int32_t)((uint32_t)reference + (uint32_t)delta);
+}
+
+static void SAMPLE_EmitChannel(SAMPLE_Encoder_t *enc, uint8_t channel)
+{
+    SAMPLE_EncoderChannel_t *ch = &enc->channel[channel];
+    uint8_t frame[SAMPLE_MAX_FRAME];
+
+    if (ch->count == 0)
+        return;
+
+    bool keyframe = (ch->seq % enc->cfg.keyframe_interval) == 0;
+    uint32_t len = SAMPLE_EncodeBlock(channel, ch->seq, keyframe, enc->cfg.run_length,
+                                      ch->reference, ch->pending, ch->count, frame);
+
+    ch->reference = ch->pending[ch->count - 1];
+    ch->seq++;
+    ch->count = 0;
+
+    enc->bytes_out += len;
+    if (enc->cfg.output != NULL)
+        enc->cfg.output(frame, len);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void SAMPLE_EncoderInit(SAMPLE_Encoder_t *enc, const SAMPLE_EncoderConfig_t *cfg)
+{
+    *enc = (SAMPLE_Encoder_t){ .cfg = *cfg };
+
+    if (enc->cfg.block_size == 0 || enc->cfg.block_size > SAMPLE_MAX_BLOCK)
+        enc->cfg.block_size = SAMPLE_DEFAULT_BLOCK;
+
+    /* seq is 8 bits: keep the keyframe period a divisor of 256 */
+    if (enc->cfg.keyframe_interval == 0 || (256U % enc->cfg.keyframe_interval) != 0)
+        enc->cfg.keyframe_interval = SAMPLE_DEFAULT_KEYFRAME;
+}
+
+void SAMPLE_Push(SAMPLE_Encoder_t *enc, uint8_t channel, int32_t value)
+{
+    if (channel >= SAMPLE_MAX_CHANNELS)
+        return;
+
+    SAMPLE_EncoderChannel_t *ch = &enc->channel[channel];
+
+    ch->pending[ch->count++] = value;
+    enc->samples_in++;
+
+    if (ch->count >= enc->cfg.block_size)
+        SAMPLE_EmitChannel(enc, channel);
+}
+
+void SAMPLE_Flush(SAMPLE_Encoder_t *enc)
+{
+    for (uint8_t channel = 0; channel < SAMPLE_MAX_CHANNELS; channel++)
+        SAMPLE_EmitChannel(enc, channel);
+}
+
+uint32_t SAMPLE_EncodeBlock(uint8_t channel, uint8_t seq, bool keyframe, bool run_length,
+                            int32_t reference, const int32_t *samples, uint32_t count,
+                            uint8_t *out)
+{
+    uint32_t len = SAMPLE_HEADER_BYTES;
+    uint32_t i = 0;
+
+    if (count > SAMPLE_MAX_BLOCK)
+        count = SAMPLE_MAX_BLOCK;
+
+    if (keyframe && count > 0)
+    {
+        len += VARINT_Encode(VARINT_ZigZag(samples[0]), &out[len]);
+        reference = samples[0];
+        i = 1;
+    }
+
+    while (i < count)
+    {
+        int32_t delta = SAMPLE_Delta(samples[i], reference);
+        len += VARINT_Encode(VARINT_ZigZag(delta), &out[len]);
+        reference = samples[i++];
+
+        if (run_length && delta == 0)
+        {
+            uint32_t run = 0;
+            while (i < count && samples[i] == reference)
+            {
+                run++;
+                i++;
+            }
+            len += VARINT_Encode(run, &out[len]);
+        }
+    }
+
+    out[0] = SAMPLE_BLOCK_SYNC;
+    out[1] = channel;
+    out[2] = seq;
+    out[3] = (uint8_t)(count | (keyframe ? SAMPLE_INFO_KEY : 0U) |
+                       (run_length ? SAMPLE_INFO_RLE : 0U));
+    out[4] = (uint8_t)(len - SAMPLE_HEADER_BYTES);
+
+    uint8_t check = 0;
+    for (uint32_t k = 1; k < len; k++)
+        check ^= out[k];
+    out[len++] = check;
+
+    return len;
+}
+
+void SAMPLE_DecoderInit(SAMPLE_Decoder_t *dec)
+{
+    *dec = (SAMPLE_Decoder_t){ 0 };
+}
+
+SAMPLE_DecodeStatus_t SAMPLE_DecodeBlock(SAMPLE_Decoder_t *dec, const uint8_t *in, uint32_t len,
+                                         uint32_t *consumed, uint8_t *channel,
+                                         int32_t *samples, uint32_t *count)
+{
+    if (len == 0 || in[0] != SAMPLE_BLOCK_SYNC)
+        return SAMPLE_DECODE_INVALID;
+    if (len < SAMPLE_HEADER_BYTES)
+        return SAMPLE_DECODE_INCOMPLETE;
+
+    uint8_t info = in[3];
+    uint32_t n = info & SAMPLE_INFO_COUNT;
+    uint32_t payload = in[4];
+    uint32_t total = SAMPLE_HEADER_BYTES + payload + 1U;
+
+    if (in[1] >= SAMPLE_MAX_CHANNELS || n > SAMPLE_MAX_BLOCK ||
+        total > SAMPLE_MAX_FRAME)
+        return SAMPLE_DECODE_INVALID;
+    if (len < total)
+        return SAMPLE_DECODE_INCOMPLETE;
+
+    uint8_t check = 0;
+    for (uint32_t k = 1; k < total; k++)
+        check ^= in[k];
+    if (check != 0)
+        return SAMPLE_DECODE_INVALID;
+
+    /* Parse the payload before touching channel state */
+    const uint8_t *p = &in[SAMPLE_HEADER_BYTES];
+    uint32_t left = payload;
+    SAMPLE_DecoderChannel_t *ch = &dec->channel[in[1]];
+    int32_t reference = ch->reference;
+    uint32_t value;
+    uint32_t used;
+    uint32_t i = 0;
+
+    while (i < n)
+    {
+        used = VARINT_Decode(p, left, &value);
+        if (used == 0)
+            return SAMPLE_DECODE_INVALID;
+        p += used;
+        left -= used;
+
+        if (i == 0 && (info & SAMPLE_INFO_KEY))
+            reference = VARINT_UnZigZag(value);
+        else
+            reference = SAMPLE_Apply(reference, VARINT_UnZigZag(value));
+        samples[i++] = reference;
+
+        if ((info & SAMPLE_INFO_RLE) && value == 0 && !(i == 1 && (info & SAMPLE_INFO_KEY)))
+        {
+            used = VARINT_Decode(p, left, &value);
+            if (used == 0 || value > n - i)
+                return SAMPLE_DECODE_INVALID;
+            p += used;
+            left -= used;
+
+            while (value-- > 0)
+                samples[i++] = reference;
+        }
+    }
+
+    if (left != 0)
+        return SAMPLE_DECODE_INVALID;
+
+    *consumed = total;
+    *channel = in[1];
+    *count = 0;
+
+    /* A gap in the sequence invalidates the delta reference */
+    if (ch->synced && in[2] != ch->next_seq)
+    {
+        ch->synced = false;
+        dec->blocks_lost += (uint8_t)(in[2] - ch->next_seq);
+    }
+    ch->next_seq = (uint8_t)(in[2] + 1U);
+
+    if (!(info & SAMPLE_INFO_KEY) && !ch->synced)
+        return SAMPLE_DECODE_UNSYNCED;
+
+    ch->synced = true;
+    if (n > 0)
+        ch->reference = reference;
+    *count = n;
+    return SAMPLE_DECODE_OK;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file sample_codec.h
+ * @brief Delta/varint block codec for streamed sensor samples.
+ *
+ * Consecutive readings of one sensor usually differ by a few counts, so each
+ * channel is sent as the difference to the previous sample (zig-zag varint,
+ * usually one byte) instead of a full 32-bit value. Samples are grouped into
+ * fixed-size blocks:
+ *
+ *   [SAMPLE_BLOCK_SYNC][channel][seq][info][len][len x payload][xor]
+ *
+ *  - info:    sample count | SAMPLE_INFO_KEY | SAMPLE_INFO_RLE
+ *  - payload: keyframe blocks start with the absolute first sample, every
+ *             other value is a delta to the previous sample
+ *  - RLE:     a zero delta is followed by a varint count of further zero
+ *             deltas, so an unchanged sensor costs two bytes per block
+ *  - xor:     XOR of every byte between the sync byte and the checksum
+ *
+ * Every keyframe_interval-th block of a channel is a keyframe. A receiver
+ * that joins late or sees a gap in `seq` drops delta blocks until the next
+ * keyframe and then continues exactly.
+ *
+ * Like log_token.h this is pure encoding/decoding: the encoder hands complete
+ * blocks to an output callback (UART_WriteBytes on the target) and the same
+ * decoder runs in tools/sample_decode.c on the host.
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "varint.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define SAMPLE_BLOCK_SYNC          0xF6U   /* Distinct from LOG_FRAME_SYNC */
+#define SAMPLE_MAX_CHANNELS        8U
+#define SAMPLE_MAX_BLOCK           32U     /* Samples per block */
+#define SAMPLE_DEFAULT_BLOCK       16U
+#define SAMPLE_DEFAULT_KEYFRAME    8U      /* Blocks per keyframe */
+
+#define SAMPLE_INFO_KEY            0x80U
+#define SAMPLE_INFO_RLE            0x40U
+#define SAMPLE_INFO_COUNT          0x3FU
+
+#define SAMPLE_HEADER_BYTES        5U
+#define SAMPLE_MAX_FRAME           (SAMPLE_HEADER_BYTES + SAMPLE_MAX_BLOCK * VARINT_MAX_BYTES + 1U)
+
+typedef enum
+{
+    SAMPLE_DECODE_OK = 0,
+    SAMPLE_DECODE_INCOMPLETE,   /**< Need more bytes */
+    SAMPLE_DECODE_INVALID,      /**< Not a valid block; skip the sync byte */
+    SAMPLE_DECODE_UNSYNCED      /**< Valid block, but no keyframe since the last gap */
+} SAMPLE_DecodeStatus_t;
+
+/**
+ * @brief Output callback receiving one complete block.
+ */
+typedef void (*SAMPLE_Output_t)(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Encoder configuration.
+ */
+typedef struct
+{
+    uint32_t block_size;         /**< Samples per block (0 = SAMPLE_DEFAULT_BLOCK) */
+    uint32_t keyframe_interval;  /**< Blocks per keyframe (0 = SAMPLE_DEFAULT_KEYFRAME) */
+    bool run_length;             /**< Collapse runs of unchanged samples */
+    SAMPLE_Output_t output;      /**< Block sink, e.g. UART_WriteBytes */
+} SAMPLE_EncoderConfig_t;
+
+/**
+ * @brief Per-channel encoder state.
+ */
+typedef struct
+{
+    int32_t reference;                  /**< Last sample already sent */
+    uint8_t seq;                        /**< Sequence number of the next block */
+    uint8_t count;                      /**< Samples waiting in pending[] */
+    int32_t pending[SAMPLE_MAX_BLOCK];
+} SAMPLE_EncoderChannel_t;
+
+/**
+ * @brief Streaming encoder for up to SAMPLE_MAX_CHANNELS channels.
+ */
+typedef struct
+{
+    SAMPLE_EncoderConfig_t cfg;
+    SAMPLE_EncoderChannel_t channel[SAMPLE_MAX_CHANNELS];
+    uint32_t samples_in;                /**< Samples pushed */
+    uint32_t bytes_out;                 /**< Bytes handed to the output */
+} SAMPLE_Encoder_t;
+
+/**
+ * @brief Per-channel decoder state.
+ */
+typedef struct
+{
+    int32_t reference;
+    uint8_t next_seq;
+    bool synced;
+} SAMPLE_DecoderChannel_t;
+
+/**
+ * @brief Receiver state for SAMPLE_DecodeBlock().
+ */
+typedef struct
+{
+    SAMPLE_DecoderChannel_t channel[SAMPLE_MAX_CHANNELS];
+    uint32_t blocks_lost;               /**< Sequence gaps detected */
+} SAMPLE_Decoder_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Reset @p enc and apply @p cfg (out-of-range values use defaults).
+ */
+void SAMPLE_EncoderInit(SAMPLE_Encoder_t *enc, const SAMPLE_EncoderConfig_t *cfg);
+
+/**
+ * @brief Queue one sample; a full block is encoded and output immediately.
+ *
+ * Samples for channels >= SAMPLE_MAX_CHANNELS are ignored.
+ */
+void SAMPLE_Push(SAMPLE_Encoder_t *enc, uint8_t channel, int32_t value);
+
+/**
+ * @brief Output the partially filled blocks of all channels.
+ */
+void SAMPLE_Flush(SAMPLE_Encoder_t *enc);
+
+/**
+ * @brief Encode one block into @p out (at least SAMPLE_MAX_FRAME bytes).
+ *
+ * @param reference Previous sample of the channel (ignored for keyframes)
+ * @return Block length in bytes
+ */
+uint32_t SAMPLE_EncodeBlock(uint8_t channel, uint8_t seq, bool keyframe, bool run_length,
+                            int32_t reference, const int32_t *samples, uint32_t count,
+                            uint8_t *out);
+
+/**
+ * @brief Reset @p dec; every channel waits for its next keyframe.
+ */
+void SAMPLE_DecoderInit(SAMPLE_Decoder_t *dec);
+
+/**
+ * @brief Decode the block starting at @p in[0] (which must be SAMPLE_BLOCK_SYNC).
+ *
+ * @param consumed Set to the block length on SAMPLE_DECODE_OK/UNSYNCED
+ * @param channel  Set to the block's channel
+ * @param samples  Receives up to SAMPLE_MAX_BLOCK samples
+ * @param count    Set to the number of samples (0 when unsynced)
+ */
+SAMPLE_DecodeStatus_t SAMPLE_DecodeBlock(SAMPLE_Decoder_t *dec, const uint8_t *in, uint32_t len,
+                                         uint32_t *consumed, uint8_t *channel,
+                                         int32_t *samples, uint32_t *count);
+
+#endif /* SAMPLE_CODEC_H */
@@ -0,0 +1,293 @@
+/**
+ * @file sample_window.c
+ * @brief Windowed aggregation of sensor samples (see sample_window.h).
+ *
+ * A window keeps the count, min, max, and the sum and sum of squares of
+ * each sample's offset from the window's first sample. An offset needs 33
+ * bits, so n*sum_sq - sum^2 needs up to 88 bits for SWIN_MAX_WINDOW
+ * samples; it is computed exactly in 128 bits built from 64-bit halves.
+ * Divided by n^2 the variance is below 2^62 again.
+ */
+
+#include <stddef.h>
+
+#include "sample_window.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define SWIN_HISTORY_MASK   (SWIN_HISTORY - 1U)
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t SWIN_Sqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/* 64 x 64 -> 128-bit product, from 32-bit partial products */
+static SWIN_U128_t SWIN_Mul64(uint64_t a, uint64_t b)
+{
+    uint64_t lo_lo = (a & 0xFFFFFFFFU) * (b & 0xFFFFFFFFU);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFFU);
+    uint64_t lo_hi = (a & 0xFFFFFFFFU) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t mid = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFU) + lo_hi;   /* Cannot overflow */
+
+    return (SWIN_U128_t){ .hi = hi_hi + (hi_lo >> 32) + (mid >> 32),
+                          .lo = (mid << 32) | (lo_lo & 0xFFFFFFFFU) };
+}
+
+/* x / d for a quotient known to fit 64 bits, 32-bit limbs at a time */
+static uint64_t SWIN_Div(SWIN_U128_t x, uint32_t d)
+{
+    const uint64_t limb[4] = { x.hi >> 32, x.hi & 0xFFFFFFFFU, x.lo >> 32, x.lo & 0xFFFFFFFFU };
+    uint64_t rem = 0;
+    uint64_t quot = 0;
+
+    for (uint32_t i = 0; i < 4U; i++)
+    {
+        uint64_t cur = (rem << 32) | limb[i];
+
+        quot = (quot << 32) | (cur / d);
+        rem = cur % d;
+    }
+    return quot;
+}
+
+static bool SWIN_SummariesOn(const SWIN_Channel_t *ch)
+{
+    return ch->cfg.window_samples != 0 || ch->cfg.window_ticks != 0;
+}
+
+static void SWIN_CloseWindow(SWIN_Pipeline_t *pipe, uint8_t channel)
+{
+    SWIN_Channel_t *ch = &pipe->channel[channel];
+    int64_t n = ch->n;
+
+    if (n == 0)
+        return;
+
+    /* Mean offset rounded half away from zero */
+    int64_t offset = (ch->sum >= 0) ? (ch->sum + n / 2) / n : -((-ch->sum + n / 2) / n);
+    uint64_t sum_abs = (uint64_t)((ch->sum >= 0) ? ch->sum : -ch->sum);
+
+    /* spread = n * sum_sq - sum^2, never negative */
+    SWIN_U128_t spread = SWIN_Mul64(ch->sum_sq.lo, (uint64_t)n);
+    SWIN_U128_t square = SWIN_Mul64(sum_abs, sum_abs);
+
+    spread.hi += ch->sum_sq.hi * (uint64_t)n;
+    spread.hi -= square.hi + ((spread.lo < square.lo) ? 1U : 0U);
+    spread.lo -= square.lo;
+
+    SWIN_Summary_t summary = {
+        .first_tick = ch->first_tick,
+        .last_tick = ch->last_tick,
+        .count = ch->n,
+        .min = ch->min,
+        .max = ch->max,
+        .mean = (int32_t)(ch->origin + offset),
+        .stddev = SWIN_Sqrt(SWIN_Div(spread, (uint32_t)(n * n)))
+    };
+
+    ch->n = 0;
+    ch->stats.windows++;
+
+    if (pipe->summary != NULL)
+        pipe->summary(channel, &summary);
+}
+
+static void SWIN_AddToWindow(SWIN_Channel_t *ch, int32_t value, uint32_t tick)
+{
+    if (ch->n == 0)
+    {
+        ch->origin = value;
+        ch->min = value;
+        ch->max = value;
+        ch->sum = 0;
+        ch->sum_sq = (SWIN_U128_t){ 0 };
+        ch->first_tick = tick;
+    }
+
+    int64_t d = (int64_t)value - ch->origin;
+    uint64_t d_abs = (uint64_t)((d >= 0) ? d : -d);
+    uint64_t square = d_abs * d_abs;   /* Below 2^64: |d| < 2^32 */
+
+    ch->n++;
+    ch->sum += d;
+    ch->sum_sq.lo += square;
+    if (ch->sum_sq.lo < square)
+        ch->sum_sq.hi++;
+    ch->last_tick = tick;
+
+    if (value < ch->min)
+        ch->min = value;
+    if (value > ch->max)
+        ch->max = value;
+}
+
+static void SWIN_EmitRaw(SWIN_Pipeline_t *pipe, uint8_t channel, const SWIN_Sample_t *sample,
+                         SWIN_RawReason_t reason)
+{
+    pipe->channel[channel].stats.raw_sent++;
+
+    if (pipe->raw != NULL)
+        pipe->raw(channel, sample, reason);
+}
+
+/* Decimation and bursts; runs before @p sample enters the history */
+static void SWIN_Raw(SWIN_Pipeline_t *pipe, uint8_t channel, const SWIN_Sample_t *sample)
+{
+    SWIN_Channel_t *ch = &pipe->channel[channel];
+    bool outside = sample->value < ch->cfg.trigger_low || sample->value > ch->cfg.trigger_high;
+    bool sent = false;
+
+    if (ch->burst_left != 0)
+    {
+        ch->burst_left--;
+        SWIN_EmitRaw(pipe, channel, sample, SWIN_RAW_BURST);
+        sent = true;
+    }
+    else if (ch->cfg.trigger && ch->armed && outside)
+    {
+        /* History back to burst_pre samples, but nothing sent before */
+        uint32_t unsent = ch->pushed - ch->raw_upto;
+        uint32_t pre = (unsent < ch->cfg.burst_pre) ? unsent : ch->cfg.burst_pre;
+
+        for (uint32_t i = ch->pushed - pre; i != ch->pushed; i++)
+            SWIN_EmitRaw(pipe, channel, &ch->history[i & SWIN_HISTORY_MASK], SWIN_RAW_BURST);
+
+        SWIN_EmitRaw(pipe, channel, sample, SWIN_RAW_BURST);
+        ch->burst_left = ch->cfg.burst_post;
+        ch->armed = false;
+        ch->stats.bursts++;
+        sent = true;
+    }
+
+    if (!outside)
+        ch->armed = true;
+
+    /* The cadence runs on through bursts; a sample is never sent twice */
+    if (ch->cfg.decimation != 0 && ++ch->decimate_count >= ch->cfg.decimation)
+    {
+        ch->decimate_count = 0;
+        if (!sent)
+        {
+            SWIN_EmitRaw(pipe, channel, sample, SWIN_RAW_DECIMATED);
+            sent = true;
+        }
+    }
+
+    if (sent)
+        ch->raw_upto = ch->pushed + 1U;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void SWIN_Init(SWIN_Pipeline_t *pipe, SWIN_SummaryOutput_t summary, SWIN_RawOutput_t raw)
+{
+    *pipe = (SWIN_Pipeline_t){ .summary = summary, .raw = raw };
+}
+
+void SWIN_ConfigureChannel(SWIN_Pipeline_t *pipe, uint8_t channel,
+                           const SWIN_ChannelConfig_t *cfg)
+{
+    if (channel >= SWIN_MAX_CHANNELS)
+        return;
+
+    SWIN_Channel_t *ch = &pipe->channel[channel];
+
+    ch->cfg = *cfg;
+    if (ch->cfg.window_samples > SWIN_MAX_WINDOW)
+        ch->cfg.window_samples = SWIN_MAX_WINDOW;
+    if (ch->cfg.burst_pre > SWIN_HISTORY - 1U)
+        ch->cfg.burst_pre = SWIN_HISTORY - 1U;
+
+    ch->n = 0;
+    ch->decimate_count = 0;
+    ch->burst_left = 0;
+    ch->armed = true;
+}
+
+void SWIN_Push(SWIN_Pipeline_t *pipe, uint8_t channel, int32_t value, uint32_t tick)
+{
+    if (channel >= SWIN_MAX_CHANNELS)
+        return;
+
+    SWIN_Channel_t *ch = &pipe->channel[channel];
+    SWIN_Sample_t sample = { .value = value, .tick = tick };
+
+    ch->stats.samples++;
+
+    if (SWIN_SummariesOn(ch))
+    {
+        uint32_t limit = (ch->cfg.window_samples != 0) ? ch->cfg.window_samples : SWIN_MAX_WINDOW;
+
+        if (ch->n != 0 && ch->cfg.window_ticks != 0 &&
+            tick - ch->first_tick >= ch->cfg.window_ticks)
+            SWIN_CloseWindow(pipe, channel);
+
+        SWIN_AddToWindow(ch, value, tick);
+
+        if (ch->n >= limit)
+            SWIN_CloseWindow(pipe, channel);
+    }
+
+    SWIN_Raw(pipe, channel, &sample);
+
+    ch->history[ch->pushed & SWIN_HISTORY_MASK] = sample;
+    ch->pushed++;
+}
+
+void SWIN_Flush(SWIN_Pipeline_t *pipe)
+{
+    for (uint8_t channel = 0; channel < SWIN_MAX_CHANNELS; channel++)
+        SWIN_CloseWindow(pipe, channel);
+}
+
+uint32_t SWIN_GetRecent(const SWIN_Pipeline_t *pipe, uint8_t channel, SWIN_Sample_t *out,
+                        uint32_t max)
+{
+    if (channel >= SWIN_MAX_CHANNELS)
+        return 0;
+
+    const SWIN_Channel_t *ch = &pipe->channel[channel];
+    uint32_t count = (ch->pushed < SWIN_HISTORY) ? ch->pushed : SWIN_HISTORY;
+
+    if (count > max)
+        count = max;
+
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = ch->history[(ch->pushed - count + i) & SWIN_HISTORY_MASK];
+
+    return count;
+}
+
+void SWIN_GetStats(const SWIN_Pipeline_t *pipe, uint8_t channel, SWIN_Stats_t *stats)
+{
+    *stats = (channel < SWIN_MAX_CHANNELS) ? pipe->channel[channel].stats : (SWIN_Stats_t){ 0 };
+}
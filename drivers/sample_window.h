@@ -0,0 +1,197 @@
+/**
+ * @file sample_window.h
+ * @brief Windowed aggregation of sensor samples before they leave the device.
+ *
+ * Sending every raw reading makes UART bandwidth grow with the sample rate.
+ * This stage sits between the I2C reads and the output and turns each
+ * channel's samples into:
+ *
+ *  - summaries: count, min, max, mean and standard deviation of a tumbling
+ *    window that closes after window_samples samples or window_ticks timer
+ *    ticks, whichever comes first
+ *  - decimated raw samples: every decimation-th sample, unchanged
+ *  - raw bursts: when a sample leaves [trigger_low, trigger_high], the
+ *    burst_pre samples before it (from the channel's history ring), the
+ *    trigger sample itself and the next burst_post samples. History that
+ *    was already sent is not repeated. The trigger re-arms once a sample is
+ *    back inside the range.
+ *
+ * Every sample is stored with its timestamp in a ring of the last
+ * SWIN_HISTORY samples (SWIN_GetRecent). All aggregates are updated
+ * incrementally, so SWIN_Push() costs O(1) per sample apart from emitting a
+ * burst's history.
+ *
+ * Sums are kept relative to the first sample of the window in integers
+ * (no floating point). The mean is exact (rounded) and the standard
+ * deviation exact (truncated) for any int32 samples. Windows hold at most
+ * SWIN_MAX_WINDOW samples.
+ *
+ * Like the sample encoder, a pipeline is caller-owned state handing its
+ * results to output callbacks; it does no I/O of its own.
+ */
+
+#ifndef SAMPLE_WINDOW_H
+#define SAMPLE_WINDOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define SWIN_MAX_CHANNELS    4U
+#define SWIN_HISTORY         64U      /* Samples kept per channel, power of two */
+#define SWIN_MAX_WINDOW      4096U    /* Samples per window */
+
+/**
+ * @brief One timestamped sample.
+ */
+typedef struct
+{
+    int32_t value;
+    uint32_t tick;      /**< HAL timer tick of the reading */
+} SWIN_Sample_t;
+
+/**
+ * @brief Aggregates of one closed window.
+ */
+typedef struct
+{
+    uint32_t first_tick;
+    uint32_t last_tick;
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;       /**< Rounded to the nearest integer */
+    uint32_t stddev;    /**< Population standard deviation, truncated */
+} SWIN_Summary_t;
+
+typedef enum
+{
+    SWIN_RAW_DECIMATED = 0,   /**< Regular every-Nth sample */
+    SWIN_RAW_BURST            /**< Part of a threshold-triggered burst */
+} SWIN_RawReason_t;
+
+typedef void (*SWIN_SummaryOutput_t)(uint8_t channel, const SWIN_Summary_t *summary);
+typedef void (*SWIN_RawOutput_t)(uint8_t channel, const SWIN_Sample_t *sample,
+                                 SWIN_RawReason_t reason);
+
+/**
+ * @brief Per-channel processing settings (all zero: summaries off, no raw output).
+ */
+typedef struct
+{
+    uint32_t window_samples;    /**< Close a window after this many samples (0: no limit) */
+    uint32_t window_ticks;      /**< ... or once it spans this many ticks (0: no limit) */
+    uint32_t decimation;        /**< Send every Nth raw sample (0: none) */
+    bool trigger;               /**< Enable threshold-triggered bursts */
+    int32_t trigger_low;
+    int32_t trigger_high;
+    uint32_t burst_pre;         /**< History samples sent before the trigger (<= SWIN_HISTORY - 1) */
+    uint32_t burst_post;        /**< Samples sent after the trigger */
+} SWIN_ChannelConfig_t;
+
+/**
+ * @brief Per-channel counters.
+ */
+typedef struct
+{
+    uint32_t samples;           /**< Samples pushed */
+    uint32_t windows;           /**< Summaries emitted */
+    uint32_t raw_sent;          /**< Raw samples emitted (decimated + burst) */
+    uint32_t bursts;            /**< Triggers fired */
+} SWIN_Stats_t;
+
+/**
+ * @brief Unsigned 128-bit integer; C11 has no portable 128-bit type.
+ */
+typedef struct
+{
+    uint64_t hi;
+    uint64_t lo;
+} SWIN_U128_t;
+
+/**
+ * @brief State of one channel.
+ */
+typedef struct
+{
+    SWIN_ChannelConfig_t cfg;
+    SWIN_Sample_t history[SWIN_HISTORY];
+    uint32_t pushed;            /**< Free-running history write index */
+
+    /* Current window, relative to its first sample */
+    uint32_t n;
+    int32_t origin;
+    int32_t min;
+    int32_t max;
+    int64_t sum;                /**< Offsets */
+    SWIN_U128_t sum_sq;         /**< Squared offsets, up to 2^76 */
+    uint32_t first_tick;
+    uint32_t last_tick;
+
+    uint32_t decimate_count;
+    uint32_t burst_left;        /**< Samples still to send after a trigger */
+    uint32_t raw_upto;          /**< History index after the last raw sample sent */
+    bool armed;
+
+    SWIN_Stats_t stats;
+} SWIN_Channel_t;
+
+/**
+ * @brief Aggregation pipeline for up to SWIN_MAX_CHANNELS channels.
+ */
+typedef struct
+{
+    SWIN_SummaryOutput_t summary;   /**< Window summaries (NULL: discard) */
+    SWIN_RawOutput_t raw;           /**< Decimated and burst samples (NULL: discard) */
+    SWIN_Channel_t channel[SWIN_MAX_CHANNELS];
+} SWIN_Pipeline_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Reset @p pipe; every channel starts with an all-zero configuration.
+ */
+void SWIN_Init(SWIN_Pipeline_t *pipe, SWIN_SummaryOutput_t summary, SWIN_RawOutput_t raw);
+
+/**
+ * @brief Set the processing of @p channel and start a new window.
+ *
+ * Out-of-range values are clamped (window_samples to SWIN_MAX_WINDOW,
+ * burst_pre to SWIN_HISTORY - 1). A window_samples of 0 with window_ticks
+ * also 0 turns summaries off.
+ */
+void SWIN_ConfigureChannel(SWIN_Pipeline_t *pipe, uint8_t channel,
+                           const SWIN_ChannelConfig_t *cfg);
+
+/**
+ * @brief Process one sample taken at @p tick.
+ *
+ * Summaries and raw samples are emitted from inside this call. Samples for
+ * channels >= SWIN_MAX_CHANNELS are ignored.
+ */
+void SWIN_Push(SWIN_Pipeline_t *pipe, uint8_t channel, int32_t value, uint32_t tick);
+
+/**
+ * @brief Emit the partially filled windows of all channels.
+ */
+void SWIN_Flush(SWIN_Pipeline_t *pipe);
+
+/**
+ * @brief Copy up to @p max of the latest samples of @p channel, oldest first.
+ *
+ * @return Number of samples copied
+ */
+uint32_t SWIN_GetRecent(const SWIN_Pipeline_t *pipe, uint8_t channel, SWIN_Sample_t *out,
+                        uint32_t max);
+
+/**
+ * @brief Copy the counters of @p channel.
+ */
+void SWIN_GetStats(const SWIN_Pipeline_t *pipe, uint8_t channel, SWIN_Stats_t *stats);
+
+#endif /* SAMPLE_WINDOW_H */
@@ -0,0 +1,315 @@
+/**
+ * @file sensor_cache.c
+ * @brief Shared TTL cache of sensor register values read over I2C.
+ *
+ * Each entry is written only by the caller that won its `fetching` flag, so
+ * there is a single writer at a time. The writer publishes the timestamp,
+ * status and value under a sequence counter (odd while writing); readers
+ * retry their copy if the counter moved. All shared fields are atomics so
+ * the concurrent copy is well-defined C11.
+ *
+ * The tick counter wraps every 2^32 ticks, after which an old stamp can look
+ * recent again. Callers therefore also count the half periods they see go
+ * by (bit 31 of the counter flipping); an entry stamped two or more half
+ * periods ago is older than any TTL and treated as stale. That holds while
+ * some entry is read at least once per half period.
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "sensor_cache.h"
+#include "../include/hal_timer.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define SCACHE_WORDS          ((SCACHE_MAX_VALUE + 3U) / 4U)
+#define SCACHE_TICKS_PER_US   (HAL_TIMER_TICK_HZ / 1000000U)
+
+typedef struct
+{
+    _Atomic uint32_t key;               /* ((addr << 8) | reg) + 1, 0 = free */
+    uint32_t ttl_ticks;
+    uint8_t len;
+    atomic_bool fetching;               /* Held by the leader of a bus read */
+    atomic_bool stale;                  /* Set by SCACHE_Invalidate */
+    _Atomic uint32_t seq;               /* Odd while being written, +2 per fetch */
+    _Atomic uint32_t stamp;             /* Tick of the last fetch */
+    _Atomic uint32_t epoch;             /* scache_epoch at that tick */
+    _Atomic uint32_t status;            /* I2C_Status_t of the last fetch */
+    _Atomic uint32_t data[SCACHE_WORDS];
+} SCACHE_Entry_t;
+
+/* Consistent copy of an entry's published fields */
+typedef struct
+{
+    uint32_t seq;
+    uint32_t stamp;
+    uint32_t epoch;
+    I2C_Status_t status;
+    uint8_t value[SCACHE_WORDS * 4U];
+} SCACHE_Snapshot_t;
+
+static SCACHE_Entry_t scache_entries[SCACHE_MAX_ENTRIES];
+static SCACHE_Hooks_t scache_hooks;
+static _Atomic uint32_t scache_half;    /* Bit 31 of the last tick seen */
+static _Atomic uint32_t scache_epoch;   /* Half periods seen go by */
+
+static _Atomic uint32_t scache_hits;
+static _Atomic uint32_t scache_misses;
+static _Atomic uint32_t scache_coalesced;
+static _Atomic uint32_t scache_errors;
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t SCACHE_Key(uint8_t dev_addr, uint8_t reg)
+{
+    return (((uint32_t)dev_addr << 8) | reg) + 1U;
+}
+
+static SCACHE_Entry_t *SCACHE_Find(uint32_t key)
+{
+    for (uint32_t i = 0; i < SCACHE_MAX_ENTRIES; i++)
+    {
+        if (atomic_load_explicit(&scache_entries[i].key, memory_order_acquire) == key)
+            return &scache_entries[i];
+    }
+    return NULL;
+}
+
+static void SCACHE_Count(_Atomic uint32_t *counter)
+{
+    atomic_fetch_add_explicit(counter, 1U, memory_order_relaxed);
+}
+
+/* Spurious bumps when callers race at a flip only make entries stale early */
+static uint32_t SCACHE_Epoch(uint32_t now)
+{
+    uint32_t half = now >> 31;
+
+    if (atomic_exchange_explicit(&scache_half, half, memory_order_relaxed) != half)
+        atomic_fetch_add_explicit(&scache_epoch, 1U, memory_order_relaxed);
+
+    return atomic_load_explicit(&scache_epoch, memory_order_relaxed);
+}
+
+static void SCACHE_Load(SCACHE_Entry_t *entry, SCACHE_Snapshot_t *snap)
+{
+    uint32_t again;
+
+    do
+    {
+        snap->seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+        snap->stamp = atomic_load_explicit(&entry->stamp, memory_order_relaxed);
+        snap->epoch = atomic_load_explicit(&entry->epoch, memory_order_relaxed);
+        snap->status = (I2C_Status_t)atomic_load_explicit(&entry->status, memory_order_relaxed);
+
+        for (uint32_t w = 0; w < SCACHE_WORDS; w++)
+        {
+            uint32_t word = atomic_load_explicit(&entry->data[w], memory_order_relaxed);
+            for (uint32_t b = 0; b < 4U; b++)
+                snap->value[w * 4U + b] = (uint8_t)(word >> (8U * b));
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        again = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+    } while ((snap->seq & 1U) || again != snap->seq);
+}
+
+static void SCACHE_Publish(SCACHE_Entry_t *entry, I2C_Status_t status, const uint8_t *value)
+{
+    uint32_t seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+    uint32_t now = HAL_TIMER_GetTicks();
+
+    atomic_store_explicit(&entry->seq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&entry->stamp, now, memory_order_relaxed);
+    atomic_store_explicit(&entry->epoch, SCACHE_Epoch(now), memory_order_relaxed);
+    atomic_store_explicit(&entry->status, (uint32_t)status, memory_order_relaxed);
+
+    for (uint32_t w = 0; w < SCACHE_WORDS; w++)
+    {
+        uint32_t word = 0;
+        for (uint32_t b = 0; b < 4U; b++)
+            word |= (uint32_t)value[w * 4U + b] << (8U * b);
+        atomic_store_explicit(&entry->data[w], word, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&entry->seq, seq + 2U, memory_order_release);
+}
+
+static bool SCACHE_IsFresh(const SCACHE_Entry_t *entry, const SCACHE_Snapshot_t *snap)
+{
+    uint32_t now = HAL_TIMER_GetTicks();
+
+    /* At most one epoch apart, the stamp is under a period old: no wrap */
+    return snap->seq != 0 && snap->status == I2C_STATUS_OK &&
+           !atomic_load_explicit(&entry->stale, memory_order_acquire) &&
+           SCACHE_Epoch(now) - snap->epoch <= 1U && now - snap->stamp < entry->ttl_ticks;
+}
+
+static I2C_Status_t SCACHE_Result(const SCACHE_Entry_t *entry, const SCACHE_Snapshot_t *snap,
+                                  uint8_t *value)
+{
+    if (snap->status == I2C_STATUS_OK)
+    {
+        for (uint32_t i = 0; i < entry->len; i++)
+            value[i] = snap->value[i];
+    }
+    return snap->status;
+}
+
+/**
+ * Leader path: one register read for everybody waiting on this entry.
+ */
+static void SCACHE_Fetch(SCACHE_Entry_t *entry, uint8_t dev_addr, uint8_t reg)
+{
+    uint8_t value[SCACHE_WORDS * 4U] = { 0 };
+    I2C_Msg_t msgs[] = {
+        { .addr = dev_addr, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = dev_addr, .flags = I2C_M_RD, .len = entry->len, .buf = value },
+    };
+
+    /* Invalidations from here on apply to the value being fetched now */
+    atomic_store_explicit(&entry->stale, false, memory_order_release);
+
+    if (scache_hooks.lock != NULL)
+        scache_hooks.lock();
+
+    I2C_Status_t status = I2C_Transfer(msgs, 2);
+
+    if (scache_hooks.unlock != NULL)
+        scache_hooks.unlock();
+
+    if (status != I2C_STATUS_OK)
+        SCACHE_Count(&scache_errors);
+
+    SCACHE_Publish(entry, status, value);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void SCACHE_Init(const SCACHE_Hooks_t *hooks)
+{
+    for (uint32_t i = 0; i < SCACHE_MAX_ENTRIES; i++)
+    {
+        SCACHE_Entry_t *entry = &scache_entries[i];
+
+        atomic_store(&entry->key, 0U);
+        atomic_store(&entry->fetching, false);
+        atomic_store(&entry->stale, false);
+        atomic_store(&entry->seq, 0U);
+    }
+
+    scache_hooks = (hooks != NULL) ? *hooks : (SCACHE_Hooks_t){ 0 };
+
+    atomic_store(&scache_hits, 0U);
+    atomic_store(&scache_misses, 0U);
+    atomic_store(&scache_coalesced, 0U);
+    atomic_store(&scache_errors, 0U);
+}
+
+bool SCACHE_Register(uint8_t dev_addr, uint8_t reg, uint8_t len, uint32_t ttl_us)
+{
+    uint32_t key = SCACHE_Key(dev_addr, reg);
+
+    if (len == 0 || len > SCACHE_MAX_VALUE)
+        return false;
+
+    SCACHE_Entry_t *entry = SCACHE_Find(key);
+    if (entry == NULL)
+        entry = SCACHE_Find(0U);
+    if (entry == NULL)
+        return false;
+
+    if (ttl_us > SCACHE_TTL_MAX_US)
+        ttl_us = SCACHE_TTL_MAX_US;
+
+    entry->ttl_ticks = ttl_us * SCACHE_TICKS_PER_US;
+    entry->len = len;
+    atomic_store(&entry->seq, 0U);
+    atomic_store(&entry->stale, false);
+    atomic_store_explicit(&entry->key, key, memory_order_release);
+    return true;
+}
+
+I2C_Status_t SCACHE_Read(uint8_t dev_addr, uint8_t reg, uint8_t *value)
+{
+    SCACHE_Entry_t *entry = SCACHE_Find(SCACHE_Key(dev_addr, reg));
+    SCACHE_Snapshot_t snap;
+
+    if (entry == NULL)
+        return I2C_STATUS_ERROR;
+
+    for (;;)
+    {
+        SCACHE_Load(entry, &snap);
+
+        if (SCACHE_IsFresh(entry, &snap))
+        {
+            SCACHE_Count(&scache_hits);
+            return SCACHE_Result(entry, &snap, value);
+        }
+
+        bool idle = false;
+        if (atomic_compare_exchange_strong(&entry->fetching, &idle, true))
+        {
+            /* Someone may have refreshed it between the check and the claim */
+            SCACHE_Load(entry, &snap);
+
+            if (SCACHE_IsFresh(entry, &snap))
+            {
+                atomic_store_explicit(&entry->fetching, false, memory_order_release);
+                SCACHE_Count(&scache_hits);
+                return SCACHE_Result(entry, &snap, value);
+            }
+
+            SCACHE_Count(&scache_misses);
+            SCACHE_Fetch(entry, dev_addr, reg);
+            atomic_store_explicit(&entry->fetching, false, memory_order_release);
+
+            SCACHE_Load(entry, &snap);
+            return SCACHE_Result(entry, &snap, value);
+        }
+
+        /* A fetch is in flight: share its result rather than repeat it */
+        uint32_t seen = snap.seq;
+
+        while (atomic_load_explicit(&entry->fetching, memory_order_acquire))
+        {
+            if (scache_hooks.wait != NULL)
+                scache_hooks.wait();
+        }
+
+        SCACHE_Load(entry, &snap);
+        if (snap.seq != seen)
+        {
+            SCACHE_Count(&scache_coalesced);
+            return SCACHE_Result(entry, &snap, value);
+        }
+        /* The leader found the value fresh without fetching: start over */
+    }
+}
+
+void SCACHE_Invalidate(uint8_t dev_addr, uint8_t reg)
+{
+    SCACHE_Entry_t *entry = SCACHE_Find(SCACHE_Key(dev_addr, reg));
+
+    if (entry != NULL)
+        atomic_store_explicit(&entry->stale, true, memory_order_release);
+}
+
+void SCACHE_GetStats(SCACHE_Stats_t *stats)
+{
+    stats->hits = atomic_load_explicit(&scache_hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&scache_misses, memory_order_relaxed);
+    stats->coalesced = atomic_load_explicit(&scache_coalesced, memory_order_relaxed);
+    stats->errors = atomic_load_explicit(&scache_errors, memory_order_relaxed);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file sensor_cache.h
+ * @brief Shared TTL cache of sensor register values read over I2C.
+ *
+ * Tasks that poll the same sensor register independently each pay for a
+ * full bus transaction, although the value only changes once per conversion
+ * period. The cache keeps the last value of every registered
+ * (address, register) pair for its TTL, normally the sensor's conversion
+ * time, and serves reads from memory until it expires:
+ *
+ *  - hit:       the value is younger than the TTL; no bus traffic
+ *  - miss:      the caller becomes the "leader", reads the register with one
+ *               I2C_Transfer (register write + repeated START + read) and
+ *               publishes the result
+ *  - coalesced: a miss while another caller's read of the same entry is in
+ *               flight waits for that read and shares its result (value or
+ *               error) instead of issuing its own
+ *
+ * The read path is lock-free (C11 atomics, values published with a sequence
+ * counter), so any number of tasks may call SCACHE_Read() concurrently. The
+ * I2C driver itself is not reentrant: if other code uses the bus at the same
+ * time, pass bus lock hooks to SCACHE_Init(); the leader holds the lock only
+ * for its transfer.
+ */
+
+#ifndef SENSOR_CACHE_H
+#define SENSOR_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c.h"
+#include "../include/hal_timer.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define SCACHE_MAX_ENTRIES   16U
+#define SCACHE_MAX_VALUE     8U    /* Bytes per cached register value */
+
+/* Longest TTL: half the tick counter's period (~44 s at 48 MHz) */
+#define SCACHE_TTL_MAX_US    ((1UL << 31) / (HAL_TIMER_TICK_HZ / 1000000U))
+
+/**
+ * @brief Optional callbacks for sharing the bus with other code.
+ */
+typedef struct
+{
+    void (*lock)(void);     /**< Take the bus before a fetch (NULL: none) */
+    void (*unlock)(void);   /**< Release it afterwards */
+    void (*wait)(void);     /**< Called while waiting for another caller's fetch,
+                                 e.g. an RTOS yield (NULL: spin) */
+} SCACHE_Hooks_t;
+
+/**
+ * @brief Cache counters (see SCACHE_GetStats).
+ */
+typedef struct
+{
+    uint32_t hits;        /**< Reads served from a fresh value */
+    uint32_t misses;      /**< Reads that fetched from the bus */
+    uint32_t coalesced;   /**< Reads that shared another caller's fetch */
+    uint32_t errors;      /**< Fetches that failed */
+} SCACHE_Stats_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Drop all entries and counters and set the bus hooks.
+ *
+ * @param hooks Bus lock/wait callbacks, or NULL if the cache is the only
+ *              user of the bus from concurrent contexts
+ */
+void SCACHE_Init(const SCACHE_Hooks_t *hooks);
+
+/**
+ * @brief Register a cached register.
+ *
+ * Call during start-up, before concurrent SCACHE_Read() calls. Registering
+ * an existing pair updates its length and TTL and drops the cached value.
+ *
+ * @param dev_addr I2C device address
+ * @param reg      Register (pointer byte written before the read)
+ * @param len      Value length in bytes (1..SCACHE_MAX_VALUE)
+ * @param ttl_us   Value lifetime, normally the conversion time (capped at
+ *                 SCACHE_TTL_MAX_US)
+ * @return false if @p len is out of range or the table is full
+ */
+bool SCACHE_Register(uint8_t dev_addr, uint8_t reg, uint8_t len, uint32_t ttl_us);
+
+/**
+ * @brief Read a registered register, from the cache if the value is fresh.
+ *
+ * @param dev_addr I2C device address
+ * @param reg      Register
+ * @param value    Destination, at least the registered length
+ * @return I2C_STATUS_OK, the status of the failed fetch, or I2C_STATUS_ERROR
+ *         if the pair is not registered
+ */
+I2C_Status_t SCACHE_Read(uint8_t dev_addr, uint8_t reg, uint8_t *value);
+
+/**
+ * @brief Force the next read of the pair to go to the bus (e.g. after a
+ *        write to the sensor's configuration).
+ */
+void SCACHE_Invalidate(uint8_t dev_addr, uint8_t reg);
+
+/**
+ * @brief Copy the cache counters.
+ */
+void SCACHE_GetStats(SCACHE_Stats_t *stats);
+
+#endif /* SENSOR_CACHE_H */
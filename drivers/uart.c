@@ -11,7 +11,9 @@
  */
 
 #include "../include/hal_uart.h"
+#include "../include/hal_nvic.h"
 #include "uart.h"
+#include "drv_latency.h"
 
 /* -------------------------------------------------------------------------- */
 /*                             Static UART Handle                              */
@@ -19,51 +21,551 @@
 
 static UART_Handle_t uart_handle;
 
+#if DRV_LATENCY_STATS
+static HIST_Histogram_t uart_latency[UART_LATENCY_COUNT];
+#define UART_LATENCY_HIST(op)   (&uart_latency[(op)])
+#else
+#define UART_LATENCY_HIST(op)   NULL
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                              RX Ring Buffer                                 */
+/* -------------------------------------------------------------------------- */
+
+#define UART_RX_MASK   (UART_RX_BUFFER_SIZE - 1U)
+
+/*
+ * Single producer (UART_PollRx or the RX interrupt), single consumer. The
+ * producer stores the byte before it advances head, the consumer reads it
+ * before it advances tail.
+ */
+static uint8_t uart_rx_buffer[UART_RX_BUFFER_SIZE];
+static _Atomic uint32_t uart_rx_head;   /* Free-running write index */
+static _Atomic uint32_t uart_rx_tail;   /* Free-running read index */
+static bool uart_rx_irq;                /* RX is drained by UART_IRQHandler */
+
+/* -------------------------------------------------------------------------- */
+/*                              Baud-rate Tables                               */
+/* -------------------------------------------------------------------------- */
+
+#define UART_SNAP_TOLERANCE_PCT   3U
+#define UART_NEG_RX_VALID         (1U << 16)
+
+static const uint32_t uart_neg_rates[UART_NEG_RATE_COUNT] = UART_NEG_RATES;
+
+static const uint32_t uart_standard_rates[] = {
+    1200U, 2400U, 4800U, 9600U, 19200U, 38400U, 57600U, 115200U,
+    230400U, 460800U, 921600U, 1000000U, 2000000U, 3000000U
+};
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t UART_RxCount(void)
+{
+    return uart_rx_head - uart_rx_tail;
+}
+
+static void UART_SendRaw(uint8_t byte)
+{
+    while (!HAL_UART_IsTxReady())
+        ;
+
+    HAL_UART_SendByte(byte);
+}
+
+static void UART_Throttle(bool throttle);
+
+/*
+ * Send from thread context if the transmitter can take the frame. With RX
+ * interrupts on, the handler may send XON/XOFF at any time, so the ready
+ * check and the write happen with it masked: nothing gets in between.
+ */
+static bool UART_TrySend(uint16_t frame)
+{
+    HAL_NVIC_EnterCritical();
+
+    bool sent = HAL_UART_IsTxReady();
+    if (sent && (frame & UART_DATA_ADDR_MARK))
+        HAL_UART_SendAddress((uint8_t)frame);
+    else if (sent)
+        HAL_UART_SendByte((uint8_t)frame);
+
+    HAL_NVIC_ExitCritical();
+    return sent;
+}
+
+static uint32_t UART_NsToTicks(uint32_t ns)
+{
+    return (uint32_t)(((uint64_t)ns * HAL_TIMER_TICK_HZ + 999999999U) / 1000000000U);
+}
+
+static void UART_DelayTicks(uint32_t ticks)
+{
+    uint32_t start = HAL_TIMER_GetTicks();
+
+    while (HAL_TIMER_GetTicks() - start < ticks)
+        ;
+}
+
+/* RS-485: take the bus for a transmission (nests, e.g. WriteBytes -> WriteChar) */
+static void UART_DriverEnable(void)
+{
+    if (!uart_handle.rs485 || uart_handle.de_depth++ != 0)
+        return;
+
+    HAL_UART_SetDriverEnable(true);
+    UART_DelayTicks(uart_handle.de_assert_ticks);
+}
+
+/* RS-485: hand the bus back once the last stop bit has left the shifter */
+static void UART_DriverRelease(void)
+{
+    if (!uart_handle.rs485 || --uart_handle.de_depth != 0)
+        return;
+
+    while (!HAL_UART_IsTxComplete())
+        ;
+
+    UART_DelayTicks(uart_handle.de_deassert_ticks);
+    HAL_UART_SetDriverEnable(false);
+}
+
+/* Append a received byte to the RX buffer and apply flow control */
+static void UART_RxStore(uint8_t byte)
+{
+    if (UART_RxCount() < UART_RX_BUFFER_SIZE)
+    {
+        uart_rx_buffer[uart_rx_head & UART_RX_MASK] = byte;
+        uart_rx_head++;
+    }
+    else
+    {
+        uart_handle.rx_dropped++;
+    }
+
+    if (uart_handle.flow_control != UART_FLOW_NONE &&
+        UART_RxCount() >= uart_handle.rx_high_watermark)
+    {
+        UART_Throttle(true);
+    }
+}
+
+/* Tell the sender to stop (throttle = true) or resume */
+static void UART_Throttle(bool throttle)
+{
+    if (uart_handle.rx_throttled == throttle)
+        return;
+
+    uart_handle.rx_throttled = throttle;
+
+    if (uart_handle.flow_control == UART_FLOW_RTS_CTS)
+        HAL_UART_SetRTS(!throttle);
+    else if (uart_handle.flow_control == UART_FLOW_XON_XOFF)
+        UART_SendRaw(throttle ? UART_XOFF : UART_XON);  /* Sent even while paused */
+}
+
+/* -------------------------------------------------------------------------- */
+/*                       Baud-rate Negotiation Helpers                         */
+/* -------------------------------------------------------------------------- */
+
+/* Capture negotiation frames while armed; returns true if @p byte was taken */
+static bool UART_NegFilter(uint8_t byte)
+{
+    uint8_t *frame = uart_handle.neg_frame;
+
+    if (!atomic_load(&uart_handle.neg_armed))
+        return false;
+
+    if (uart_handle.neg_len == 0 && byte != UART_NEG_MAGIC)
+        return false;
+
+    frame[uart_handle.neg_len++] = byte;
+    if (uart_handle.neg_len < sizeof(uart_handle.neg_frame))
+        return true;
+
+    uart_handle.neg_len = 0;
+
+    if ((uint8_t)(frame[0] ^ frame[1] ^ frame[2]) == frame[3])
+    {
+        atomic_store(&uart_handle.neg_rx,
+                     UART_NEG_RX_VALID | ((uint32_t)frame[1] << 8) | frame[2]);
+    }
+    else
+    {
+        /* Not a frame after all: the bytes belong to the application */
+        for (uint32_t i = 0; i < sizeof(uart_handle.neg_frame); i++)
+            UART_RxStore(frame[i]);
+    }
+
+    return true;
+}
+
+static void UART_NegArm(bool armed)
+{
+    HAL_NVIC_EnterCritical();
+    atomic_store(&uart_handle.neg_armed, armed);
+    uart_handle.neg_len = 0;
+    atomic_store(&uart_handle.neg_rx, 0U);
+    HAL_NVIC_ExitCritical();
+}
+
+static void UART_NegSend(uint8_t type, uint8_t arg)
+{
+    UART_WriteChar((char)UART_NEG_MAGIC);
+    UART_WriteChar((char)type);
+    UART_WriteChar((char)arg);
+    UART_WriteChar((char)(UART_NEG_MAGIC ^ type ^ arg));
+}
+
+static bool UART_NegReceive(uint8_t *type, uint8_t *arg, uint32_t timeout)
+{
+    uint32_t frame;
+
+    while (!((frame = atomic_exchange(&uart_handle.neg_rx, 0U)) & UART_NEG_RX_VALID))
+    {
+        UART_PollRx();
+
+        if (timeout-- == 0)
+            return false;
+    }
+
+    *type = (uint8_t)(frame >> 8);
+    *arg = (uint8_t)frame;
+    return true;
+}
+
+static uint8_t UART_NegHighestRate(uint32_t caps)
+{
+    uint8_t index = UART_NEG_RATE_COUNT - 1U;
+
+    while (index > 0 && !(caps & (1U << index)))
+        index--;
+
+    return index;
+}
+
+/* Negotiation rates the divisor reaches within the error budget */
+static uint32_t UART_ReachableCaps(uint32_t caps)
+{
+    for (uint32_t i = 0; i < UART_NEG_RATE_COUNT; i++)
+    {
+        if ((caps & (1U << i)) &&
+            UART_CheckBaudrate(uart_neg_rates[i], NULL, NULL) != UART_RESULT_OK)
+            caps &= ~(1U << i);
+    }
+
+    return caps;
+}
+
+/* Round a measured rate to the nearest standard rate within tolerance */
+static uint32_t UART_SnapBaudrate(uint32_t measured)
+{
+    for (uint32_t i = 0; i < sizeof(uart_standard_rates) / sizeof(uart_standard_rates[0]); i++)
+    {
+        uint32_t rate = uart_standard_rates[i];
+        uint32_t diff = (measured > rate) ? (measured - rate) : (rate - measured);
+
+        if ((uint64_t)diff * 100U <= (uint64_t)rate * UART_SNAP_TOLERANCE_PCT)
+            return rate;
+    }
+
+    return measured;
+}
+
+/*
+ * Reprogram the divisor once the last frame has left the shifter, so it
+ * goes out whole at the old rate. TX-ready only means DATA is empty. The
+ * final check runs with the RX handler masked, so it cannot start an
+ * XON/XOFF in between.
+ */
+static void UART_SwitchDivisor(const HAL_UART_BaudDivisor_t *div)
+{
+    for (;;)
+    {
+        while (!HAL_UART_IsTxComplete())
+            ;
+
+        HAL_NVIC_EnterCritical();
+        bool idle = HAL_UART_IsTxComplete();
+        if (idle)
+            HAL_UART_SetBaudDivisor(div);
+        HAL_NVIC_ExitCritical();
+
+        if (idle)
+            return;
+    }
+}
+
+/* Go back to a rate we were already running at, whatever the error budget */
+static void UART_RestoreBaudrate(uint32_t baudrate)
+{
+    HAL_UART_BaudDivisor_t div;
+
+    HAL_UART_ComputeBaud(baudrate, &div);
+    UART_SwitchDivisor(&div);
+    uart_handle.baudrate = baudrate;
+
+    HAL_NVIC_EnterCritical();
+    uart_handle.neg_len = 0;
+    HAL_NVIC_ExitCritical();
+}
+
 /* -------------------------------------------------------------------------- */
 /*                           Function Implementations                          */
 /* -------------------------------------------------------------------------- */
 
-void UART_Init(const UART_Config_t *config)
+UART_Result_t UART_Init(const UART_Config_t *config)
 {
+    uint32_t high = config->rx_high_watermark;
+    uint32_t low = config->rx_low_watermark;
+
+    /* A 2-wire bus has no RTS/CTS, and XOFF/XON would have to take the bus */
+    if (config->rs485 && config->flow_control != UART_FLOW_NONE)
+        return UART_RESULT_ERROR;
+
+    /* Bytes already in flight when the sender is stopped need room above high */
+    if (high == 0)
+        high = (UART_RX_BUFFER_SIZE * 3U) / 4U;
+    if (low == 0)
+        low = high / 3U;
+    if (high >= UART_RX_BUFFER_SIZE || low >= high)
+        return UART_RESULT_ERROR;
+
+    /* The handler must not run while its state is reset */
+    UART_EnableRxInterrupt(false);
+
     uart_handle.baudrate = config->baudrate;
+    uart_handle.baud_tolerance_ppm = config->baud_tolerance_ppm;
+    if (uart_handle.baud_tolerance_ppm == 0)
+        uart_handle.baud_tolerance_ppm = UART_BAUD_TOLERANCE_PPM;
     uart_handle.stop_bits = config->stop_bits;
     uart_handle.parity = config->parity;
+    uart_handle.flow_control = config->flow_control;
+
+    uart_handle.rx_high_watermark = high;
+    uart_handle.rx_low_watermark = low;
+
+    uart_handle.rx_throttled = false;
+    uart_handle.tx_paused = false;
+    uart_handle.rx_dropped = 0;
+    uart_handle.rx_framing_errors = 0;
+    uart_handle.rx_parity_errors = 0;
+    uart_handle.rx_overruns = 0;
+    uart_handle.data_bits = config->data_bits;
+    uart_handle.rs485 = config->rs485;
+    uart_handle.de_assert_ticks = UART_NsToTicks(config->de_assert_ns);
+    uart_handle.de_deassert_ticks = UART_NsToTicks(config->de_deassert_ns);
+    uart_handle.de_depth = 0;
+    uart_handle.rx_address_frames = 0;
+    UART_NegArm(false);
+    uart_rx_head = 0;
+    uart_rx_tail = 0;
+    UART_ResetLatency();
 
     /* Configure UART registers using HAL */
     HAL_UART_EnableClock();
     HAL_UART_ConfigurePins();
 
+    /* Collect the CTRL bits (OVER8 included) and write the register once */
+    HAL_UART_ConfigBegin();
     HAL_UART_SetBaudrate(config->baudrate);
     HAL_UART_SetStopBits(config->stop_bits);
     HAL_UART_SetParity(config->parity);
-
+    HAL_UART_SetHwFlowControl(config->flow_control == UART_FLOW_RTS_CTS);
+    HAL_UART_SetRTS(true);
+    HAL_UART_SetDataBits9(config->data_bits == UART_DATABITS_9);
+    HAL_UART_SetAddressMatch(config->address_match, config->node_address);
+    HAL_UART_SetDriverEnable(false);
     HAL_UART_Enable();
+    HAL_UART_ConfigCommit();
+    return UART_RESULT_OK;
 }
 
 void UART_WriteChar(char c)
 {
-    /* Wait until TX buffer is empty */
-    while (!HAL_UART_IsTxReady())
-        ;
+    uint32_t start = DRV_LatencyStart();
+
+    UART_DriverEnable();
 
-    HAL_UART_SendByte((uint8_t)c);
+    /* Wait until TX buffer is empty and the peer has not paused us */
+    while (uart_handle.tx_paused || !UART_TrySend((uint8_t)c))
+    {
+        /* XON can only arrive through the receive path */
+        if (uart_handle.flow_control == UART_FLOW_XON_XOFF)
+            UART_PollRx();
+    }
+
+    UART_DriverRelease();
+    DRV_LatencyRecord(UART_LATENCY_HIST(UART_LATENCY_TX_CHAR), start);
 }
 
 void UART_WriteString(const char *str)
 {
+    uint32_t start = DRV_LatencyStart();
+
+    UART_DriverEnable();
     while (*str)
     {
         UART_WriteChar(*str++);
     }
+    UART_DriverRelease();
+
+    DRV_LatencyRecord(UART_LATENCY_HIST(UART_LATENCY_WRITE), start);
+}
+
+void UART_WriteBytes(const uint8_t *data, uint32_t len)
+{
+    uint32_t start = DRV_LatencyStart();
+
+    UART_DriverEnable();
+    for (uint32_t i = 0; i < len; i++)
+    {
+        UART_WriteChar((char)data[i]);
+    }
+    UART_DriverRelease();
+
+    DRV_LatencyRecord(UART_LATENCY_HIST(UART_LATENCY_WRITE), start);
+}
+
+UART_Result_t UART_WriteAddressed(uint8_t address, const uint8_t *data, uint32_t len)
+{
+    if (uart_handle.data_bits != UART_DATABITS_9)
+        return UART_RESULT_ERROR;
+
+    UART_DriverEnable();
+
+    while (!UART_TrySend(UART_DATA_ADDR_MARK | address))
+        ;
+
+    UART_WriteBytes(data, len);
+    UART_DriverRelease();
+
+    return UART_RESULT_OK;
+}
+
+uint32_t UART_RxAddressFrames(void)
+{
+    return uart_handle.rx_address_frames;
 }
 
 char UART_ReadChar(void)
 {
+    uint32_t start = DRV_LatencyStart();
+
     /* Wait until RX buffer has data */
-    while (!HAL_UART_IsRxReady())
-        ;
+    while (UART_RxCount() == 0)
+        UART_PollRx();
+
+    uint8_t byte = uart_rx_buffer[uart_rx_tail & UART_RX_MASK];
+    UART_RxConsume(1);
+    DRV_LatencyRecord(UART_LATENCY_HIST(UART_LATENCY_READ), start);
+
+    return (char)byte;
+}
+
+/* Move everything the peripheral holds into the RX buffer */
+static void UART_DrainRx(void)
+{
+    while (HAL_UART_IsRxReady())
+    {
+        uint32_t errors = HAL_UART_GetRxErrors();
+        bool address = HAL_UART_IsAddressFrame();
+        uint8_t byte = HAL_UART_ReadByte();
+
+        if (errors & UART_STATUS_ORE)
+            uart_handle.rx_overruns++;   /* The byte in DATA itself is good */
+
+        if (errors & UART_STATUS_FE)
+        {
+            uart_handle.rx_framing_errors++;
+            continue;
+        }
+
+        if (errors & UART_STATUS_PE)
+        {
+            uart_handle.rx_parity_errors++;
+            continue;
+        }
+
+        /* Multidrop traffic for any node; data frames still follow */
+        if (address)
+        {
+            uart_handle.rx_address_frames++;
+            continue;
+        }
+
+        if (uart_handle.flow_control == UART_FLOW_XON_XOFF &&
+            (byte == UART_XON || byte == UART_XOFF))
+        {
+            uart_handle.tx_paused = (byte == UART_XOFF);
+            continue;
+        }
+
+        if (UART_NegFilter(byte))
+            continue;
+
+        UART_RxStore(byte);
+    }
+}
+
+void UART_PollRx(void)
+{
+    /* The handler owns the receive path; without the ISR thread, run it here */
+    if (uart_rx_irq)
+    {
+        HAL_NVIC_Poll();
+        return;
+    }
+
+    UART_DrainRx();
+}
 
-    return (char)HAL_UART_ReadByte();
+void UART_IRQHandler(void)
+{
+    UART_DrainRx();
+}
+
+void UART_EnableRxInterrupt(bool enable)
+{
+    if (enable == uart_rx_irq)
+        return;
+
+    if (enable)
+    {
+        HAL_NVIC_SetHandler(HAL_IRQ_UART1, UART_IRQHandler);
+        uart_rx_irq = true;
+        HAL_UART_SetRxInterrupt(true);
+        HAL_NVIC_EnableIRQ(HAL_IRQ_UART1);
+    }
+    else
+    {
+        HAL_NVIC_DisableIRQ(HAL_IRQ_UART1);
+        HAL_UART_SetRxInterrupt(false);
+        HAL_NVIC_ClearPendingIRQ(HAL_IRQ_UART1);
+        uart_rx_irq = false;
+    }
+}
+
+uint32_t UART_RxAvailable(void)
+{
+    return UART_RxCount();
+}
+
+uint32_t UART_RxDropped(void)
+{
+    return uart_handle.rx_dropped;
+}
+
+bool UART_IsTxPaused(void)
+{
+    return uart_handle.tx_paused;
+}
+
+bool UART_IsRxThrottled(void)
+{
+    return uart_handle.rx_throttled;
 }
 
 void UART_WriteHex(uint32_t value)
@@ -105,3 +607,249 @@ void UART_WriteDec(int value)
         UART_WriteChar(buffer[i]);
     }
 }
+
+uint32_t UART_RxFramingErrors(void)
+{
+    return uart_handle.rx_framing_errors;
+}
+
+uint32_t UART_RxPeek(UART_RxView_t *view)
+{
+    uint32_t count = UART_RxCount();
+    uint32_t start = uart_rx_tail & UART_RX_MASK;
+    uint32_t first = UART_RX_BUFFER_SIZE - start;
+
+    if (first > count)
+        first = count;
+
+    view->span[0].data = &uart_rx_buffer[start];
+    view->span[0].len = first;
+    view->span[1].data = uart_rx_buffer;
+    view->span[1].len = count - first;
+
+    view->overruns = uart_handle.rx_overruns;
+    view->dropped = uart_handle.rx_dropped;
+    view->framing_errors = uart_handle.rx_framing_errors;
+    view->parity_errors = uart_handle.rx_parity_errors;
+
+    return count;
+}
+
+void UART_RxConsume(uint32_t count)
+{
+    uint32_t available = UART_RxCount();
+
+    if (count > available)
+        count = available;
+
+    uart_rx_tail += count;
+
+    /* The handler may throttle at the same time */
+    HAL_NVIC_EnterCritical();
+    if (uart_handle.rx_throttled && UART_RxCount() <= uart_handle.rx_low_watermark)
+        UART_Throttle(false);
+    HAL_NVIC_ExitCritical();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Baud Rate                                   */
+/* -------------------------------------------------------------------------- */
+
+UART_Result_t UART_CheckBaudrate(uint32_t baudrate, uint32_t *actual, int32_t *error_ppm)
+{
+    HAL_UART_BaudDivisor_t div;
+
+    HAL_UART_ComputeBaud(baudrate, &div);
+
+    if (actual != NULL)
+        *actual = div.actual;
+    if (error_ppm != NULL)
+        *error_ppm = div.error_ppm;
+
+    uint32_t magnitude = (div.error_ppm < 0) ? (uint32_t)-div.error_ppm : (uint32_t)div.error_ppm;
+
+    return (baudrate != 0 && magnitude <= uart_handle.baud_tolerance_ppm) ? UART_RESULT_OK
+                                                                          : UART_RESULT_BAUD_ERROR;
+}
+
+UART_Result_t UART_SetBaudrate(uint32_t baudrate)
+{
+    HAL_UART_BaudDivisor_t div;
+
+    if (UART_CheckBaudrate(baudrate, NULL, NULL) != UART_RESULT_OK)
+        return UART_RESULT_BAUD_ERROR;
+
+    HAL_UART_ComputeBaud(baudrate, &div);
+    UART_SwitchDivisor(&div);
+    uart_handle.baudrate = baudrate;
+
+    HAL_NVIC_EnterCritical();
+    uart_handle.neg_len = 0;
+    HAL_NVIC_ExitCritical();
+    return UART_RESULT_OK;
+}
+
+uint32_t UART_GetBaudrate(void)
+{
+    return uart_handle.baudrate;
+}
+
+uint32_t UART_GetActualBaudrate(void)
+{
+    return HAL_UART_GetBaudrate();
+}
+
+int32_t UART_GetBaudError(void)
+{
+    int64_t nominal = (uart_handle.baudrate != 0) ? uart_handle.baudrate : 1;
+
+    return (int32_t)(((int64_t)HAL_UART_GetBaudrate() - nominal) * 1000000 / nominal);
+}
+
+UART_Result_t UART_AutoBaud(uint8_t sync_char, uint32_t timeout)
+{
+    /* Bytes already in the RX buffer are kept; the next start bit is timed */
+    HAL_UART_StartAutoBaud();
+
+    while (!HAL_UART_IsAutoBaudDone())
+    {
+        if (timeout-- == 0)
+        {
+            HAL_UART_CancelAutoBaud();
+            return UART_RESULT_TIMEOUT;
+        }
+    }
+
+    bool failed = HAL_UART_IsAutoBaudError();
+    uint8_t byte = HAL_UART_ReadByte();
+
+    if (failed || byte != sync_char)
+    {
+        HAL_UART_SetBaudrate(uart_handle.baudrate);
+        return UART_RESULT_NO_SYNC;
+    }
+
+    if (UART_SetBaudrate(UART_SnapBaudrate(HAL_UART_GetBaudrate())) != UART_RESULT_OK)
+    {
+        HAL_UART_SetBaudrate(uart_handle.baudrate);
+        return UART_RESULT_BAUD_ERROR;
+    }
+    return UART_RESULT_OK;
+}
+
+UART_Result_t UART_NegotiateBaud(uint32_t caps)
+{
+    uint32_t original = uart_handle.baudrate;
+    UART_Result_t result = UART_RESULT_REJECTED;
+    uint8_t type, arg, index;
+
+    caps = UART_ReachableCaps(caps & UART_CAP_ALL);
+    UART_NegArm(true);
+
+    while (caps != 0)
+    {
+        UART_NegSend(UART_NEG_REQUEST, (uint8_t)caps);
+
+        if (!UART_NegReceive(&type, &index, UART_TIMEOUT))
+        {
+            result = UART_RESULT_TIMEOUT;
+            break;
+        }
+
+        if (type != UART_NEG_ACCEPT || index >= UART_NEG_RATE_COUNT || !(caps & (1U << index)))
+        {
+            result = UART_RESULT_REJECTED;
+            break;
+        }
+
+        if (UART_SetBaudrate(uart_neg_rates[index]) != UART_RESULT_OK)
+        {
+            result = UART_RESULT_BAUD_ERROR;   /* The peer times out and reverts */
+            break;
+        }
+        UART_NegSend(UART_NEG_VERIFY, index);
+
+        if (UART_NegReceive(&type, &arg, UART_TIMEOUT) &&
+            type == UART_NEG_VERIFY_ACK && arg == index)
+        {
+            result = UART_RESULT_OK;
+            break;
+        }
+
+        /* The link cannot carry this rate: both ends fall back, retry lower */
+        UART_RestoreBaudrate(original);
+        caps &= ~(1U << index);
+    }
+
+    UART_NegArm(false);
+    return result;
+}
+
+UART_Result_t UART_RespondBaudNegotiation(uint32_t caps, uint32_t timeout)
+{
+    uint32_t original = uart_handle.baudrate;
+    UART_Result_t result = UART_RESULT_TIMEOUT;
+    uint8_t type, arg;
+
+    UART_NegArm(true);
+
+    while (UART_NegReceive(&type, &arg, timeout))
+    {
+        if (type != UART_NEG_REQUEST)
+            continue;
+
+        uint32_t common = arg & UART_ReachableCaps(caps & UART_CAP_ALL);
+        if (common == 0)
+        {
+            UART_NegSend(UART_NEG_REJECT, 0);
+            result = UART_RESULT_REJECTED;
+            break;
+        }
+
+        uint8_t index = UART_NegHighestRate(common);
+        UART_NegSend(UART_NEG_ACCEPT, index);
+        if (UART_SetBaudrate(uart_neg_rates[index]) != UART_RESULT_OK)
+        {
+            result = UART_RESULT_BAUD_ERROR;   /* The initiator's VERIFY times out */
+            break;
+        }
+
+        if (UART_NegReceive(&type, &arg, timeout) &&
+            type == UART_NEG_VERIFY && arg == index)
+        {
+            UART_NegSend(UART_NEG_VERIFY_ACK, index);
+            result = UART_RESULT_OK;
+            break;
+        }
+
+        /* Verification failed: revert and wait for the initiator's retry */
+        UART_RestoreBaudrate(original);
+        result = UART_RESULT_TIMEOUT;
+    }
+
+    UART_NegArm(false);
+    return result;
+}
+
+bool UART_GetLatency(UART_LatencyOp_t op, HIST_Snapshot_t *snap)
+{
+#if DRV_LATENCY_STATS
+    if (op >= UART_LATENCY_COUNT)
+        return false;
+
+    HIST_Snapshot(&uart_latency[op], snap);
+    return true;
+#else
+    (void)op;
+    (void)snap;
+    return false;
+#endif
+}
+
+void UART_ResetLatency(void)
+{
+#if DRV_LATENCY_STATS
+    for (uint32_t op = 0; op < UART_LATENCY_COUNT; op++)
+        HIST_Reset(&uart_latency[op]);
+#endif
+}
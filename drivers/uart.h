@@ -11,6 +11,45 @@
 #define UART_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "histogram.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define UART_RX_BUFFER_SIZE   256U   /* Must be a power of two */
+
+/* Software flow control characters */
+#define UART_XON              0x11U
+#define UART_XOFF             0x13U
+
+/* Poll-count timeouts (same convention as I2C_TIMEOUT) */
+#define UART_TIMEOUT          50000U
+
+/* Default divisor error budget (see UART_CheckBaudrate) */
+#define UART_BAUD_TOLERANCE_PPM   20000U   /* 2 % */
+
+/* Baud-rate negotiation: capability bits index UART_NEG_RATES */
+#define UART_NEG_RATES        { 115200U, 230400U, 460800U, 921600U, 2000000U, 3000000U }
+#define UART_NEG_RATE_COUNT   6U
+#define UART_CAP_115200       (1U << 0)
+#define UART_CAP_230400       (1U << 1)
+#define UART_CAP_460800       (1U << 2)
+#define UART_CAP_921600       (1U << 3)
+#define UART_CAP_2M           (1U << 4)
+#define UART_CAP_3M           (1U << 5)
+#define UART_CAP_ALL          ((1U << UART_NEG_RATE_COUNT) - 1U)
+
+/* Negotiation frame: [UART_NEG_MAGIC][type][arg][MAGIC ^ type ^ arg] */
+#define UART_NEG_MAGIC        0xA5U
+#define UART_NEG_REQUEST      'B'    /* arg: capability mask */
+#define UART_NEG_ACCEPT       'b'    /* arg: chosen rate index */
+#define UART_NEG_REJECT       'n'    /* arg: 0, no common rate */
+#define UART_NEG_VERIFY       'V'    /* arg: rate index, sent at the new rate */
+#define UART_NEG_VERIFY_ACK   'v'    /* arg: rate index, sent at the new rate */
 
 /* -------------------------------------------------------------------------- */
 /*                               UART Data Types                               */
@@ -29,14 +68,102 @@ typedef enum
     UART_STOPBITS_2
 } UART_StopBits_t;
 
+typedef enum
+{
+    UART_DATABITS_8 = 0,
+    UART_DATABITS_9        /**< 9th bit marks multidrop address frames */
+} UART_DataBits_t;
+
+typedef enum
+{
+    UART_FLOW_NONE = 0,
+    UART_FLOW_RTS_CTS,     /**< Hardware: RTS driven from RX watermarks, TX gated by CTS */
+    UART_FLOW_XON_XOFF     /**< Software: in-band XOFF/XON from RX watermarks */
+} UART_FlowControl_t;
+
+typedef enum
+{
+    UART_RESULT_OK = 0,
+    UART_RESULT_TIMEOUT,
+    UART_RESULT_NO_SYNC,       /**< Auto-baud saw no valid sync character */
+    UART_RESULT_REJECTED,      /**< Peer shares no faster rate */
+    UART_RESULT_BAUD_ERROR,    /**< Rate not reachable within the error budget */
+    UART_RESULT_ERROR
+} UART_Result_t;
+
+/* Latency histogram selector (see drv_latency.h) */
+typedef enum
+{
+    UART_LATENCY_TX_CHAR = 0,  /**< One byte: waiting for TX ready / flow control */
+    UART_LATENCY_WRITE,        /**< UART_WriteString / UART_WriteBytes call */
+    UART_LATENCY_READ,         /**< UART_ReadChar wait */
+    UART_LATENCY_COUNT
+} UART_LatencyOp_t;
+
+/**
+ * @brief Contiguous run of received bytes inside the driver's RX buffer.
+ */
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t len;
+} UART_RxSpan_t;
+
+/**
+ * @brief Zero-copy view of the RX buffer plus receive error counters.
+ *
+ * Data wraps around the ring at most once, so it is always described by at
+ * most two spans (span[1].len is 0 when it does not wrap). Counters are
+ * cumulative since UART_Init().
+ */
+typedef struct
+{
+    UART_RxSpan_t span[2];
+    uint32_t overruns;         /**< Hardware overruns (bytes lost in the peripheral) */
+    uint32_t dropped;          /**< Bytes lost because the RX buffer was full */
+    uint32_t framing_errors;   /**< Bytes discarded with a framing error */
+    uint32_t parity_errors;    /**< Bytes discarded with a parity error */
+} UART_RxView_t;
+
 /**
  * @brief UART Configuration Structure
+ *
+ * Watermarks are RX buffer fill levels in bytes; 0 selects the default
+ * (3/4 of UART_RX_BUFFER_SIZE for high, a third of high for low). High
+ * must stay below UART_RX_BUFFER_SIZE to leave room for the bytes that
+ * arrive after the sender is told to stop, and low below high.
+ *
+ * RS-485: with `rs485` set the driver asserts DE before every transmission
+ * and releases it de_deassert_ns after the transmission-complete event, so
+ * the bus is handed back as soon as the last stop bit is out. With 9 data
+ * bits and `address_match`, the receiver ignores all traffic until an
+ * address frame carrying `node_address` arrives (see UART_WriteAddressed).
+ * Zero-initialized fields keep the plain 8-bit point-to-point behaviour.
+ * `rs485` needs UART_FLOW_NONE: the 2-wire bus has no RTS/CTS lines, and
+ * an XOFF/XON sent from the RX path would drive DE in the middle of the
+ * peer's transmission.
+ *
+ * The UART clock cannot divide down to every rate exactly;
+ * `baud_tolerance_ppm` is how far the achieved rate may be off (0 selects
+ * UART_BAUD_TOLERANCE_PPM). UART_Init() programs the closest setting even
+ * beyond it, so check UART_CheckBaudrate() first or UART_GetBaudError()
+ * afterwards.
  */
 typedef struct
 {
     uint32_t baudrate;
     UART_StopBits_t stop_bits;
     UART_Parity_t parity;
+    UART_FlowControl_t flow_control;
+    uint32_t rx_high_watermark;   /**< Throttle the sender at or above this level */
+    uint32_t rx_low_watermark;    /**< Release the sender at or below this level */
+    UART_DataBits_t data_bits;
+    bool rs485;                   /**< Drive DE around transmissions (half duplex) */
+    uint32_t de_assert_ns;        /**< DE asserted -> first start bit */
+    uint32_t de_deassert_ns;      /**< Last stop bit -> DE released */
+    bool address_match;           /**< Multidrop node: receive only when addressed */
+    uint8_t node_address;         /**< Our address for address_match */
+    uint32_t baud_tolerance_ppm;  /**< Divisor error budget */
 } UART_Config_t;
 
 /**
@@ -45,8 +172,29 @@ typedef struct
 typedef struct
 {
     uint32_t baudrate;
+    uint32_t baud_tolerance_ppm;
     UART_StopBits_t stop_bits;
     UART_Parity_t parity;
+    UART_FlowControl_t flow_control;
+    uint32_t rx_high_watermark;
+    uint32_t rx_low_watermark;
+    /* Written by the RX path, which may be the interrupt handler */
+    atomic_bool rx_throttled;     /**< Sender told to stop (RTS low / XOFF sent) */
+    atomic_bool tx_paused;        /**< Peer sent XOFF */
+    _Atomic uint32_t rx_dropped;          /**< Bytes lost because the RX buffer was full */
+    _Atomic uint32_t rx_framing_errors;   /**< Bytes discarded with a framing error */
+    _Atomic uint32_t rx_parity_errors;    /**< Bytes discarded with a parity error */
+    _Atomic uint32_t rx_overruns;         /**< Hardware overrun events */
+    atomic_bool neg_armed;        /**< Negotiation frames are being filtered */
+    uint8_t neg_frame[4];         /**< Partial frame (RX path only, or IRQ masked) */
+    uint8_t neg_len;
+    _Atomic uint32_t neg_rx;      /**< Latched frame: UART_NEG_RX_VALID | type << 8 | arg */
+    UART_DataBits_t data_bits;
+    bool rs485;
+    uint32_t de_assert_ticks;
+    uint32_t de_deassert_ticks;
+    uint32_t de_depth;            /**< Nested transmissions holding DE */
+    _Atomic uint32_t rx_address_frames;   /**< Address frames seen without address matching */
 } UART_Handle_t;
 
 /* -------------------------------------------------------------------------- */
@@ -55,8 +203,11 @@ typedef struct
 
 /**
  * @brief Initialize UART peripheral with given configuration.
+ *
+ * @return UART_RESULT_ERROR, leaving the port untouched, if `rs485` is
+ *         combined with flow control or the watermarks are out of range
  */
-void UART_Init(const UART_Config_t *config);
+UART_Result_t UART_Init(const UART_Config_t *config);
 
 /**
  * @brief Send a single character.
@@ -68,11 +219,182 @@ void UART_WriteChar(char c);
  */
 void UART_WriteString(const char *str);
 
+/**
+ * @brief Send @p len raw bytes (binary safe).
+ */
+void UART_WriteBytes(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Send one multidrop message: an address frame, then @p len data bytes.
+ *
+ * Requires UART_DATABITS_9. The whole message goes out in one DE window, so
+ * the turnaround after it is a single TC + de_deassert_ns.
+ *
+ * @return UART_RESULT_ERROR if the port is not in 9-bit mode
+ */
+UART_Result_t UART_WriteAddressed(uint8_t address, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Address frames received while address matching is off.
+ *
+ * They are not stored in the RX buffer.
+ */
+uint32_t UART_RxAddressFrames(void);
+
 /**
  * @brief Read a single received character (blocking).
  */
 char UART_ReadChar(void);
 
+/**
+ * @brief Move received bytes from the peripheral into the RX buffer.
+ *
+ * Call from the main loop. Applies flow control when the buffer crosses
+ * the high watermark and consumes XON/XOFF when software flow control is
+ * enabled. With the RX interrupt enabled this only runs pending handlers
+ * (HAL_NVIC_Poll), which does nothing while the ISR thread is running.
+ */
+void UART_PollRx(void);
+
+/**
+ * @brief UART1 interrupt handler: drains the peripheral like UART_PollRx().
+ */
+void UART_IRQHandler(void);
+
+/**
+ * @brief Receive through the UART1 interrupt instead of polling.
+ *
+ * Installs UART_IRQHandler, sets UART_CTRL_RXNEIE and enables the NVIC
+ * line; the caller picks the priority and starts dispatching
+ * (HAL_NVIC_StartDispatcher or HAL_NVIC_Poll). Disabling waits for a
+ * running handler to return. UART_Init() starts with the interrupt off.
+ */
+void UART_EnableRxInterrupt(bool enable);
+
+/**
+ * @brief Number of bytes waiting in the RX buffer.
+ */
+uint32_t UART_RxAvailable(void);
+
+/**
+ * @brief Number of received bytes dropped because the RX buffer was full.
+ */
+uint32_t UART_RxDropped(void);
+
+/**
+ * @brief True while the peer has paused our transmitter with XOFF.
+ */
+bool UART_IsTxPaused(void);
+
+/**
+ * @brief True while we have told the peer to stop sending (RTS low / XOFF).
+ */
+bool UART_IsRxThrottled(void);
+
+/**
+ * @brief Number of received bytes discarded because of framing errors.
+ */
+uint32_t UART_RxFramingErrors(void);
+
+/**
+ * @brief Lend the buffered RX data to the caller without copying.
+ *
+ * The spans stay valid until UART_RxConsume() releases them; new data is
+ * only appended behind them. Call UART_PollRx() (or let the RX interrupt do
+ * it) beforehand to pick up bytes still in the peripheral.
+ *
+ * @param view Filled with up to two spans and the error counters
+ * @return Total number of readable bytes (span[0].len + span[1].len)
+ */
+uint32_t UART_RxPeek(UART_RxView_t *view);
+
+/**
+ * @brief Release @p count bytes from the front of the RX buffer.
+ *
+ * Values larger than UART_RxAvailable() are clamped.
+ */
+void UART_RxConsume(uint32_t count);
+
+/* ------------------------------ Baud rate --------------------------------- */
+
+/**
+ * @brief Switch baud rate live.
+ *
+ * Waits for the transmitter to go idle, then reprograms the divider. The RX
+ * buffer and all driver state are kept.
+ *
+ * @return UART_RESULT_BAUD_ERROR, with the old rate kept, if the closest
+ *         divisor misses @p baudrate by more than the error budget
+ */
+UART_Result_t UART_SetBaudrate(uint32_t baudrate);
+
+/**
+ * @brief Currently programmed (nominal) baud rate.
+ */
+uint32_t UART_GetBaudrate(void);
+
+/**
+ * @brief Rate the divisor really produces for the current setting.
+ */
+uint32_t UART_GetActualBaudrate(void);
+
+/**
+ * @brief Error of the current setting in ppm of the nominal rate.
+ */
+int32_t UART_GetBaudError(void);
+
+/**
+ * @brief Check whether @p baudrate is reachable within the error budget.
+ *
+ * Nothing is programmed. The best divisor uses 16x or 8x oversampling,
+ * whichever is closer; 8x extends the range to BOARD_UART_CLOCK_HZ / 8
+ * (6 Mbaud at 48 MHz).
+ *
+ * @param actual    Achieved rate (may be NULL)
+ * @param error_ppm Its error in ppm (may be NULL)
+ * @return UART_RESULT_OK or UART_RESULT_BAUD_ERROR
+ */
+UART_Result_t UART_CheckBaudrate(uint32_t baudrate, uint32_t *actual, int32_t *error_ppm);
+
+/**
+ * @brief Detect the peer's baud rate from a sync character and adopt it.
+ *
+ * The peer must send @p sync_char (LSB set, e.g. 0x55 'U' or 0x7F). The
+ * measured rate is snapped to the nearest standard rate within 3 %.
+ * The previous rate stays in effect if the sync character is wrong
+ * (UART_RESULT_NO_SYNC) or the snapped rate is outside the error budget
+ * (UART_RESULT_BAUD_ERROR).
+ *
+ * @param sync_char Expected sync character (consumed, not buffered)
+ * @param timeout   Poll iterations to wait for the sync character
+ */
+UART_Result_t UART_AutoBaud(uint8_t sync_char, uint32_t timeout);
+
+/**
+ * @brief Step up to the highest rate both ends support (initiator side).
+ *
+ * Sends our capability mask at the current rate, switches to the rate the
+ * peer accepts and verifies the link with a VERIFY/VERIFY_ACK exchange at
+ * the new rate. A rate that fails verification is dropped from the mask and
+ * negotiation falls back to the next lower common rate.
+ *
+ * @param caps Capability mask (UART_CAP_*); rates the divisor cannot reach
+ *             within the error budget are dropped before it is sent
+ */
+UART_Result_t UART_NegotiateBaud(uint32_t caps);
+
+/**
+ * @brief Answer one negotiation request from the peer (responder side).
+ *
+ * Waits up to @p timeout polls for a REQUEST, accepts the highest common
+ * rate and switches to it. Reverts to the current rate if VERIFY does not
+ * arrive intact.
+ *
+ * @param caps    Capability mask (UART_CAP_*), reduced like UART_NegotiateBaud's
+ * @param timeout Poll iterations to wait for each frame
+ */
+UART_Result_t UART_RespondBaudNegotiation(uint32_t caps, uint32_t timeout);
+
 /**
  * @brief Send a 32-bit value as hex string.
  */
@@ -83,4 +405,18 @@ void UART_WriteHex(uint32_t value);
  */
 void UART_WriteDec(int value);
 
+/* ---------------------------- Latency stats ------------------------------- */
+
+/**
+ * @brief Snapshot the latency histogram for @p op (timer ticks).
+ *
+ * @return false if latency statistics are compiled out
+ */
+bool UART_GetLatency(UART_LatencyOp_t op, HIST_Snapshot_t *snap);
+
+/**
+ * @brief Clear all UART latency histograms.
+ */
+void UART_ResetLatency(void);
+
 #endif /* UART_H */
@@ -0,0 +1,53 @@
+/**
+ * @file uart_log.c
+ * @brief Tokenized deferred logging over the UART driver.
+ *
+ * A tokenized message costs one frame of a few bytes written with a single
+ * UART_WriteBytes() call, instead of formatting and sending every character
+ * of the text.
+ */
+
+#include "uart_log.h"
+#include "uart.h"
+
+/* -------------------------------------------------------------------------- */
+/*                               Static State                                  */
+/* -------------------------------------------------------------------------- */
+
+static UART_LogMode_t log_mode = UART_LOG_TEXT;
+static const char *const *log_formats = NULL;
+static uint32_t log_format_count = 0;
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static void UART_LogPutChar(char c)
+{
+    UART_WriteChar(c);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void UART_LogInit(UART_LogMode_t mode, const char *const *formats, uint32_t count)
+{
+    log_mode = mode;
+    log_formats = formats;
+    log_format_count = (formats != NULL) ? count : 0;
+}
+
+void UART_Log(uint16_t id, const int32_t *args, uint32_t argc)
+{
+    if (log_mode == UART_LOG_TEXT && id < log_format_count)
+    {
+        LOG_Format(log_formats[id], args, argc, UART_LogPutChar);
+        return;
+    }
+
+    uint8_t frame[LOG_MAX_FRAME];
+    uint32_t len = LOG_EncodeFrame(id, args, argc, frame);
+
+    UART_WriteBytes(frame, len);
+}
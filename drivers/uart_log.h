@@ -0,0 +1,64 @@
+/**
+ * @file uart_log.h
+ * @brief Tokenized deferred logging over the UART driver.
+ *
+ * Call sites name a message by its ID from the build-time string table
+ * (src/log_strings.def) and pass up to LOG_MAX_ARGS integer arguments:
+ *
+ *   UART_LOG1(LOG_SENSOR_VALUE, temp_value);
+ *
+ * In UART_LOG_TOKENIZED mode only the ID and the binary arguments are sent
+ * (see log_token.h); tools/log_decode expands them on the host. In
+ * UART_LOG_TEXT mode the message is formatted on the target from the table,
+ * which is convenient when no decoder is at hand.
+ */
+
+#ifndef UART_LOG_H
+#define UART_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "log_token.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+typedef enum
+{
+    UART_LOG_TEXT = 0,     /**< Format on the target (needs the string table) */
+    UART_LOG_TOKENIZED     /**< Send ID + arguments only */
+} UART_LogMode_t;
+
+/* Call-site helpers: arguments are converted to int32_t */
+#define UART_LOG0(id)                UART_Log((id), NULL, 0)
+#define UART_LOG1(id, a)             UART_Log((id), (const int32_t[]){ (int32_t)(a) }, 1)
+#define UART_LOG2(id, a, b)          UART_Log((id), (const int32_t[]){ (int32_t)(a), (int32_t)(b) }, 2)
+#define UART_LOG3(id, a, b, c)       UART_Log((id), (const int32_t[]){ (int32_t)(a), (int32_t)(b), \
+                                                                      (int32_t)(c) }, 3)
+#define UART_LOG4(id, a, b, c, d)    UART_Log((id), (const int32_t[]){ (int32_t)(a), (int32_t)(b), \
+                                                                      (int32_t)(c), (int32_t)(d) }, 4)
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Select the log output mode.
+ *
+ * @param mode    Text or tokenized output
+ * @param formats Format string table indexed by ID (may be NULL in
+ *                tokenized mode so the strings are not linked in)
+ * @param count   Number of entries in @p formats
+ */
+void UART_LogInit(UART_LogMode_t mode, const char *const *formats, uint32_t count);
+
+/**
+ * @brief Emit log message @p id with @p argc integer arguments.
+ *
+ * IDs without a table entry are always sent tokenized.
+ */
+void UART_Log(uint16_t id, const int32_t *args, uint32_t argc);
+
+#endif /* UART_LOG_H */
@@ -0,0 +1,262 @@
+/**
+ * @file uart_mux.c
+ * @brief Prioritized virtual channels multiplexed over UART1.
+ *
+ * Each channel queue is a single-producer/single-consumer ring indexed by
+ * free-running byte counters: the writer only advances `head`, the poller
+ * only advances `tail`. Writes are timed through a second ring of
+ * (end offset, enqueue tick) slots, filled before the bytes are published so
+ * the poller never sees bytes whose slot is missing. When all slots are in
+ * use a write joins the newest slot and is timed from that slot's tick.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "uart_mux.h"
+#include "uart.h"
+#include "drv_latency.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    _Atomic uint32_t end;   /* head after the write */
+    uint32_t tick;          /* HAL tick of the write */
+} UART_MuxWriteSlot_t;
+
+typedef struct
+{
+    atomic_bool open;
+    uint8_t priority;
+    uint8_t weight;
+    int32_t credit;                     /* Smooth weighted round-robin state */
+    uint8_t seq;
+    uint8_t queue[UART_MUX_QUEUE_SIZE];
+    _Atomic uint32_t head;              /* Bytes ever queued (writer) */
+    _Atomic uint32_t tail;              /* Bytes ever sent (poller) */
+    UART_MuxWriteSlot_t slots[UART_MUX_WRITE_SLOTS];
+    _Atomic uint32_t slot_head;
+    _Atomic uint32_t slot_tail;
+    _Atomic uint32_t max_depth;
+    _Atomic uint32_t dropped;
+    uint32_t chunks;
+    HIST_Histogram_t latency;
+} UART_MuxChannel_t;
+
+static UART_MuxChannel_t uart_mux[MUX_MAX_CHANNELS];
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t UART_MuxPending(UART_MuxChannel_t *ch)
+{
+    return atomic_load_explicit(&ch->head, memory_order_acquire) -
+           atomic_load_explicit(&ch->tail, memory_order_relaxed);
+}
+
+/* Most urgent non-empty priority level, then the heaviest credit in it */
+static int32_t UART_MuxPick(void)
+{
+    int32_t best = -1;
+    uint32_t level = UINT32_MAX;
+    int32_t total = 0;
+
+    for (uint32_t i = 0; i < MUX_MAX_CHANNELS; i++)
+    {
+        if (atomic_load(&uart_mux[i].open) && UART_MuxPending(&uart_mux[i]) != 0 &&
+            uart_mux[i].priority < level)
+            level = uart_mux[i].priority;
+    }
+
+    if (level == UINT32_MAX)
+        return -1;
+
+    for (uint32_t i = 0; i < MUX_MAX_CHANNELS; i++)
+    {
+        UART_MuxChannel_t *ch = &uart_mux[i];
+
+        if (!atomic_load(&ch->open) || ch->priority != level || UART_MuxPending(ch) == 0)
+            continue;
+
+        ch->credit += ch->weight;
+        total += ch->weight;
+        if (best < 0 || ch->credit > uart_mux[best].credit)
+            best = (int32_t)i;
+    }
+
+    uart_mux[best].credit -= total;
+    return best;
+}
+
+/* Time every write whose last byte has now been sent */
+static void UART_MuxRetire(UART_MuxChannel_t *ch, uint32_t tail)
+{
+    uint32_t slot = atomic_load_explicit(&ch->slot_tail, memory_order_relaxed);
+
+    while (slot != atomic_load_explicit(&ch->slot_head, memory_order_acquire))
+    {
+        UART_MuxWriteSlot_t *w = &ch->slots[slot % UART_MUX_WRITE_SLOTS];
+
+        if ((int32_t)(tail - atomic_load_explicit(&w->end, memory_order_relaxed)) < 0)
+            break;
+
+        DRV_LatencyRecord(&ch->latency, w->tick);
+        slot++;
+        atomic_store_explicit(&ch->slot_tail, slot, memory_order_release);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void UART_MuxInit(void)
+{
+    for (uint32_t i = 0; i < MUX_MAX_CHANNELS; i++)
+    {
+        UART_MuxChannel_t *ch = &uart_mux[i];
+
+        atomic_store(&ch->open, false);
+        ch->credit = 0;
+        ch->seq = 0;
+        atomic_store(&ch->head, 0);
+        atomic_store(&ch->tail, 0);
+        atomic_store(&ch->slot_head, 0);
+        atomic_store(&ch->slot_tail, 0);
+        atomic_store(&ch->max_depth, 0);
+        atomic_store(&ch->dropped, 0);
+        ch->chunks = 0;
+        HIST_Reset(&ch->latency);
+    }
+}
+
+bool UART_MuxOpen(uint8_t channel, const UART_MuxChannelConfig_t *config)
+{
+    if (channel >= MUX_MAX_CHANNELS)
+        return false;
+
+    UART_MuxChannel_t *ch = &uart_mux[channel];
+
+    ch->priority = config->priority;
+    ch->weight = (config->weight != 0) ? config->weight : 1U;
+    ch->credit = 0;
+    atomic_store(&ch->open, true);
+    return true;
+}
+
+uint32_t UART_MuxWrite(uint8_t channel, const uint8_t *data, uint32_t len)
+{
+    if (channel >= MUX_MAX_CHANNELS || !atomic_load(&uart_mux[channel].open))
+        return 0;
+
+    UART_MuxChannel_t *ch = &uart_mux[channel];
+    uint32_t head = atomic_load_explicit(&ch->head, memory_order_relaxed);
+    uint32_t room = UART_MUX_QUEUE_SIZE -
+                    (head - atomic_load_explicit(&ch->tail, memory_order_acquire));
+    uint32_t accepted = (len < room) ? len : room;
+
+    if (accepted < len)
+        atomic_fetch_add_explicit(&ch->dropped, len - accepted, memory_order_relaxed);
+    if (accepted == 0)
+        return 0;
+
+    /* Slot first, then the bytes: the poller retires only published slots */
+    uint32_t end = head + accepted;
+    uint32_t slot = atomic_load_explicit(&ch->slot_head, memory_order_relaxed);
+
+    if (slot - atomic_load_explicit(&ch->slot_tail, memory_order_acquire) < UART_MUX_WRITE_SLOTS)
+    {
+        UART_MuxWriteSlot_t *w = &ch->slots[slot % UART_MUX_WRITE_SLOTS];
+
+        atomic_store_explicit(&w->end, end, memory_order_relaxed);
+        w->tick = DRV_LatencyStart();
+        atomic_store_explicit(&ch->slot_head, slot + 1U, memory_order_release);
+    }
+    else
+    {
+        atomic_store_explicit(&ch->slots[(slot - 1U) % UART_MUX_WRITE_SLOTS].end, end,
+                              memory_order_relaxed);
+    }
+
+    uint32_t at = head % UART_MUX_QUEUE_SIZE;
+    uint32_t first = UART_MUX_QUEUE_SIZE - at;
+
+    if (first > accepted)
+        first = accepted;
+    memcpy(&ch->queue[at], data, first);
+    memcpy(&ch->queue[0], data + first, accepted - first);
+    atomic_store_explicit(&ch->head, end, memory_order_release);
+
+    uint32_t depth = end - atomic_load_explicit(&ch->tail, memory_order_relaxed);
+    if (depth > atomic_load_explicit(&ch->max_depth, memory_order_relaxed))
+        atomic_store_explicit(&ch->max_depth, depth, memory_order_relaxed);
+
+    return accepted;
+}
+
+bool UART_MuxPoll(void)
+{
+    int32_t index = UART_MuxPick();
+    if (index < 0)
+        return false;
+
+    UART_MuxChannel_t *ch = &uart_mux[index];
+    uint32_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+    uint32_t len = UART_MuxPending(ch);
+    uint8_t chunk[MUX_MAX_CHUNK];
+    uint8_t frame[MUX_MAX_FRAME];
+
+    if (len > MUX_MAX_CHUNK)
+        len = MUX_MAX_CHUNK;
+
+    for (uint32_t i = 0; i < len; i++)
+        chunk[i] = ch->queue[(tail + i) % UART_MUX_QUEUE_SIZE];
+
+    UART_WriteBytes(frame, MUX_EncodeFrame((uint8_t)index, ch->seq++, chunk, len, frame));
+
+    tail += len;
+    atomic_store_explicit(&ch->tail, tail, memory_order_release);
+    ch->chunks++;
+    UART_MuxRetire(ch, tail);
+    return true;
+}
+
+void UART_MuxFlush(void)
+{
+    while (UART_MuxPoll())
+        ;
+}
+
+void UART_MuxGetStats(uint8_t channel, UART_MuxStats_t *stats)
+{
+    *stats = (UART_MuxStats_t){ 0 };
+    if (channel >= MUX_MAX_CHANNELS)
+        return;
+
+    UART_MuxChannel_t *ch = &uart_mux[channel];
+
+    stats->bytes_sent = atomic_load(&ch->tail);
+    stats->depth = atomic_load(&ch->head) - stats->bytes_sent;
+    stats->max_depth = atomic_load(&ch->max_depth);
+    stats->chunks_sent = ch->chunks;
+    stats->dropped = atomic_load(&ch->dropped);
+}
+
+bool UART_MuxGetLatency(uint8_t channel, HIST_Snapshot_t *snap)
+{
+#if DRV_LATENCY_STATS
+    if (channel >= MUX_MAX_CHANNELS)
+        return false;
+
+    HIST_Snapshot(&uart_mux[channel].latency, snap);
+    return true;
+#else
+    (void)channel;
+    (void)snap;
+    return false;
+#endif
+}
@@ -0,0 +1,111 @@
+/**
+ * @file uart_mux.h
+ * @brief Prioritized virtual channels multiplexed over UART1.
+ *
+ * Console text, telemetry and bulk transfers can share one UART without the
+ * bulk traffic holding up the rest. Each channel has its own TX queue.
+ * UART_MuxPoll() sends one chunk of at most MUX_MAX_CHUNK bytes, framed as
+ * in mux_frame.h, from the channel the scheduler picks:
+ *
+ *  - strict priority: a channel only sends while every channel with a
+ *    lower priority number has nothing queued
+ *  - weighted: channels with the same priority share the UART in chunks in
+ *    proportion to their weights (smooth weighted round-robin)
+ *
+ * Data written to an urgent channel therefore waits at most for the chunk
+ * already on the wire, not for a whole UART_WriteString() of debug text.
+ *
+ * UART_MuxWrite() only queues; call UART_MuxPoll() from the main loop or
+ * the TX interrupt. Writer and poller may run in different contexts (one
+ * writer per channel). Each channel keeps queue depth counters and a
+ * histogram of write latency: the time from UART_MuxWrite() until its last
+ * byte has been handed to the UART. tools/mux_decode splits a captured
+ * stream back into channels on the host.
+ */
+
+#ifndef UART_MUX_H
+#define UART_MUX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mux_frame.h"
+#include "histogram.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define UART_MUX_QUEUE_SIZE     512U   /* Bytes per channel, power of two */
+#define UART_MUX_WRITE_SLOTS    16U    /* Writes timed per channel at once */
+
+/**
+ * @brief Channel scheduling parameters.
+ */
+typedef struct
+{
+    uint8_t priority;   /**< 0 = most urgent */
+    uint8_t weight;     /**< Share among channels of equal priority (0: 1) */
+} UART_MuxChannelConfig_t;
+
+/**
+ * @brief Per-channel counters (see UART_MuxGetStats).
+ */
+typedef struct
+{
+    uint32_t depth;         /**< Bytes queued now */
+    uint32_t max_depth;     /**< Highest depth seen */
+    uint32_t bytes_sent;
+    uint32_t chunks_sent;
+    uint32_t dropped;       /**< Bytes refused because the queue was full */
+} UART_MuxStats_t;
+
+/* -------------------------------------------------------------------------- */
+/*                           Public API Function Prototypes                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Close all channels and clear their queues and statistics.
+ */
+void UART_MuxInit(void);
+
+/**
+ * @brief Open (or reconfigure) channel @p channel.
+ *
+ * @return false if @p channel >= MUX_MAX_CHANNELS
+ */
+bool UART_MuxOpen(uint8_t channel, const UART_MuxChannelConfig_t *config);
+
+/**
+ * @brief Queue @p len bytes on @p channel.
+ *
+ * @return Bytes queued; the rest did not fit and is counted as dropped
+ */
+uint32_t UART_MuxWrite(uint8_t channel, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Send the next chunk, if any channel has data.
+ *
+ * @return true if a chunk was sent
+ */
+bool UART_MuxPoll(void);
+
+/**
+ * @brief Send until every queue is empty.
+ */
+void UART_MuxFlush(void);
+
+/**
+ * @brief Copy the counters of @p channel.
+ */
+void UART_MuxGetStats(uint8_t channel, UART_MuxStats_t *stats);
+
+/**
+ * @brief Snapshot the write latency histogram of @p channel (timer ticks).
+ *
+ * @return false if @p channel is out of range or latency statistics are
+ *         compiled out
+ */
+bool UART_MuxGetLatency(uint8_t channel, HIST_Snapshot_t *snap);
+
+#endif /* UART_MUX_H */
@@ -0,0 +1,78 @@
+/**
+ * @file varint.h
+ * @brief LEB128-style variable-length integers and zig-zag mapping.
+ *
+ * Small unsigned values take one byte per 7 bits (1..5 bytes for 32 bits).
+ * Zig-zag maps signed values so that small magnitudes of either sign stay
+ * small: 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+ *
+ * Shared by the binary wire formats (tokenized logging, sample streams).
+ */
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stdint.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                  Definitions                                */
+/* -------------------------------------------------------------------------- */
+
+#define VARINT_MAX_BYTES   5U   /* Longest encoding of a uint32_t */
+
+/* -------------------------------------------------------------------------- */
+/*                                   Helpers                                   */
+/* -------------------------------------------------------------------------- */
+
+static inline uint32_t VARINT_ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)-(int32_t)((uint32_t)value >> 31);
+}
+
+static inline int32_t VARINT_UnZigZag(uint32_t value)
+{
+    return (int32_t)((value >> 1) ^ (uint32_t)-(int32_t)(value & 1U));
+}
+
+/**
+ * @brief Encode @p value into @p out (at least VARINT_MAX_BYTES long).
+ * @return Number of bytes written
+ */
+static inline uint32_t VARINT_Encode(uint32_t value, uint8_t *out)
+{
+    uint32_t len = 0;
+
+    while (value >= 0x80U)
+    {
+        out[len++] = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+
+    return len;
+}
+
+/**
+ * @brief Decode one varint from @p in.
+ * @return Bytes consumed, or 0 if @p len is too short or the encoding is
+ *         longer than VARINT_MAX_BYTES
+ */
+static inline uint32_t VARINT_Decode(const uint8_t *in, uint32_t len, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < len && i < VARINT_MAX_BYTES; i++)
+    {
+        result |= (uint32_t)(in[i] & 0x7FU) << (7U * i);
+
+        if (!(in[i] & 0x80U))
+        {
+            *value = result;
+            return i + 1U;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* VARINT_H */
@@ -0,0 +1,434 @@
+/**
+ * @file hal_capture.c
+ * @brief Capture and replay of simulated bus traffic.
+ *
+ * Capture goes through a large stdio buffer so recording costs a few bytes
+ * of memcpy per event. Replay maps the whole file read-only and walks it
+ * with two independent cursors: one for time-driven UART input and one for
+ * demand-driven I2C responses. Each cursor skips the records that belong to
+ * the other.
+ *
+ * Events arrive from the driver's thread (I2C, UART TX) and from the
+ * interrupt controller's (UART RX, see hal_nvic.h), so writing a record and
+ * the stats it updates is serialized with a spin lock. Replay is not
+ * thread-safe; it is driven from the polling thread only.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hal_capture.h"
+#include "hal_timer.h"
+#include "hal_uart.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define CAPTURE_HEADER_SIZE   16U
+#define CAPTURE_BUFFER_SIZE   (64U * 1024U)
+#define CAPTURE_VARINT_MAX    5U
+
+typedef struct
+{
+    size_t pos;            /* Offset of the next record */
+    uint64_t time;         /* Ticks since the last MARK, up to the next record */
+} CAPTURE_Cursor_t;
+
+typedef struct
+{
+    HAL_CAPTURE_Event_t type;
+    uint8_t data;
+    uint32_t dt;
+    size_t next;           /* Offset after the record */
+} CAPTURE_Record_t;
+
+static FILE *capture_file;
+static char capture_buffer[CAPTURE_BUFFER_SIZE];
+static uint32_t capture_last;
+
+static const uint8_t *replay_map;
+static size_t replay_size;
+static uint32_t replay_speed;
+static uint32_t replay_last_now;
+static uint64_t replay_elapsed;      /* Scaled ticks since the UART cursor's last MARK */
+static CAPTURE_Cursor_t replay_uart;
+static CAPTURE_Cursor_t replay_i2c;
+
+static HAL_CAPTURE_Stats_t capture_stats;
+static atomic_flag capture_lock = ATOMIC_FLAG_INIT;
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+/* Guards capture_file, capture_last and the write counters */
+static void CAPTURE_Lock(void)
+{
+    while (atomic_flag_test_and_set_explicit(&capture_lock, memory_order_acquire))
+        ;
+}
+
+static void CAPTURE_Unlock(void)
+{
+    atomic_flag_clear_explicit(&capture_lock, memory_order_release);
+}
+
+static bool CAPTURE_HasData(HAL_CAPTURE_Event_t type)
+{
+    return type != HAL_CAPTURE_MARK && type != HAL_CAPTURE_I2C_START &&
+           type != HAL_CAPTURE_I2C_STOP && type != HAL_CAPTURE_I2C_NACK;
+}
+
+static void CAPTURE_Put32(uint8_t *out, uint32_t value)
+{
+    for (uint32_t i = 0; i < 4U; i++)
+        out[i] = (uint8_t)(value >> (8U * i));
+}
+
+static uint32_t CAPTURE_Get32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+static void CAPTURE_Write(const uint8_t *data, uint32_t len)
+{
+    fwrite(data, 1, len, capture_file);
+    capture_stats.bytes_written += len;
+}
+
+/* Decode the record at @p pos; false at the end of the file or on a torn tail */
+static bool CAPTURE_Parse(size_t pos, CAPTURE_Record_t *rec)
+{
+    if (pos >= replay_size)
+        return false;
+
+    rec->type = (HAL_CAPTURE_Event_t)replay_map[pos++];
+    rec->dt = 0;
+
+    for (uint32_t shift = 0;; shift += 7U)
+    {
+        if (pos >= replay_size || shift >= 7U * CAPTURE_VARINT_MAX)
+            return false;
+
+        uint8_t byte = replay_map[pos++];
+        rec->dt |= (uint32_t)(byte & 0x7FU) << shift;
+        if (!(byte & 0x80U))
+            break;
+    }
+
+    rec->data = 0;
+    if (CAPTURE_HasData(rec->type))
+    {
+        if (pos >= replay_size)
+            return false;
+        rec->data = replay_map[pos++];
+    }
+
+    rec->next = pos;
+    return rec->type < HAL_CAPTURE_EVENT_COUNT;
+}
+
+/* Next record of the I2C stream (everything but UART and MARK records) */
+static bool CAPTURE_NextI2C(CAPTURE_Record_t *rec)
+{
+    while (CAPTURE_Parse(replay_i2c.pos, rec))
+    {
+        if (rec->type >= HAL_CAPTURE_I2C_START)
+            return true;
+        replay_i2c.pos = rec->next;
+    }
+    return false;
+}
+
+/* The UART cursor only ever stops on a pending RX byte; the I2C cursor is
+ * moved past bus conditions (replay ignores them) to its next response */
+static void CAPTURE_CheckDone(void)
+{
+    CAPTURE_Record_t rec;
+
+    while (CAPTURE_NextI2C(&rec) &&
+           (rec.type == HAL_CAPTURE_I2C_START || rec.type == HAL_CAPTURE_I2C_STOP))
+        replay_i2c.pos = rec.next;
+
+    capture_stats.replay_done = !CAPTURE_Parse(replay_uart.pos, &rec) && !CAPTURE_NextI2C(&rec);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+bool HAL_CAPTURE_Start(const char *path)
+{
+    uint8_t header[CAPTURE_HEADER_SIZE] = { 0 };
+
+    HAL_CAPTURE_Stop();
+
+    FILE *file = fopen(path, "a+b");
+    if (file == NULL)
+        return false;
+
+    setvbuf(file, capture_buffer, _IOFBF, sizeof(capture_buffer));
+
+    /* Appending to an existing capture: it must be one of ours */
+    if (fread(header, 1, sizeof(header), file) != 0 &&
+        CAPTURE_Get32(header) != HAL_CAPTURE_MAGIC)
+    {
+        fclose(file);
+        return false;
+    }
+
+    CAPTURE_Lock();
+    capture_stats.records_written = 0;
+    capture_stats.bytes_written = 0;
+    capture_file = file;
+    fseek(capture_file, 0, SEEK_END);
+
+    if (ftell(capture_file) == 0)
+    {
+        CAPTURE_Put32(&header[0], HAL_CAPTURE_MAGIC);
+        header[4] = (uint8_t)HAL_CAPTURE_VERSION;
+        header[5] = (uint8_t)(HAL_CAPTURE_VERSION >> 8);
+        header[6] = 0;
+        header[7] = 0;
+        CAPTURE_Put32(&header[8], HAL_TIMER_TICK_HZ);
+        CAPTURE_Put32(&header[12], 0);
+        CAPTURE_Write(header, sizeof(header));
+    }
+
+    capture_last = HAL_TIMER_GetTicks();
+    CAPTURE_Unlock();
+
+    HAL_CAPTURE_Record(HAL_CAPTURE_MARK, 0);
+    return true;
+}
+
+void HAL_CAPTURE_Stop(void)
+{
+    CAPTURE_Lock();
+    if (capture_file != NULL)
+    {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+    CAPTURE_Unlock();
+}
+
+void HAL_CAPTURE_Record(HAL_CAPTURE_Event_t type, uint8_t data)
+{
+    uint8_t record[2U + CAPTURE_VARINT_MAX];
+    uint32_t len = 0;
+
+    CAPTURE_Lock();
+    if (capture_file == NULL)
+    {
+        CAPTURE_Unlock();
+        return;
+    }
+
+    uint32_t now = HAL_TIMER_GetTicks();
+    uint32_t dt = now - capture_last;
+    capture_last = now;
+
+    record[len++] = (uint8_t)type;
+    do
+    {
+        record[len] = (uint8_t)(dt & 0x7FU);
+        dt >>= 7;
+        if (dt != 0)
+            record[len] |= 0x80U;
+        len++;
+    } while (dt != 0);
+
+    if (CAPTURE_HasData(type))
+        record[len++] = data;
+
+    CAPTURE_Write(record, len);
+    capture_stats.records_written++;
+    CAPTURE_Unlock();
+}
+
+bool HAL_CAPTURE_Replay(const char *path, uint32_t speed)
+{
+    struct stat st;
+
+    HAL_CAPTURE_ReplayStop();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)CAPTURE_HEADER_SIZE)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const uint8_t *bytes = map;
+    if (CAPTURE_Get32(bytes) != HAL_CAPTURE_MAGIC ||
+        (uint32_t)(bytes[4] | (bytes[5] << 8)) != HAL_CAPTURE_VERSION)
+    {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    /* Both cursors stream front to back */
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    replay_map = bytes;
+    replay_size = (size_t)st.st_size;
+    replay_speed = speed;
+    replay_last_now = HAL_TIMER_GetTicks();
+    replay_elapsed = 0;
+    replay_uart = (CAPTURE_Cursor_t){ .pos = CAPTURE_HEADER_SIZE, .time = 0 };
+
+    /* The first session starts now, not at the first poll */
+    CAPTURE_Record_t rec;
+    if (CAPTURE_Parse(replay_uart.pos, &rec) && rec.type == HAL_CAPTURE_MARK)
+        replay_uart.pos = rec.next;
+    replay_i2c = replay_uart;
+
+    capture_stats.uart_fed = 0;
+    capture_stats.i2c_read = 0;
+    capture_stats.i2c_nacks = 0;
+    capture_stats.i2c_mismatches = 0;
+    CAPTURE_CheckDone();
+    return true;
+}
+
+void HAL_CAPTURE_ReplayStop(void)
+{
+    if (replay_map == NULL)
+        return;
+
+    munmap((void *)(uintptr_t)replay_map, replay_size);
+    replay_map = NULL;
+    replay_size = 0;
+}
+
+bool HAL_CAPTURE_IsReplaying(void)
+{
+    return replay_map != NULL;
+}
+
+void HAL_CAPTURE_GetStats(HAL_CAPTURE_Stats_t *stats)
+{
+    CAPTURE_Lock();
+    if (capture_file != NULL)
+        fflush(capture_file);
+
+    *stats = capture_stats;
+    CAPTURE_Unlock();
+}
+
+void HAL_CAPTURE_ReplayUart(void)
+{
+    CAPTURE_Record_t rec;
+
+    if (replay_map == NULL)
+        return;
+
+    uint32_t now = HAL_TIMER_GetTicks();
+    replay_elapsed += (uint64_t)(now - replay_last_now) * replay_speed;
+    replay_last_now = now;
+
+    while (CAPTURE_Parse(replay_uart.pos, &rec))
+    {
+        if (rec.type == HAL_CAPTURE_MARK)
+        {
+            /* New session: restart the time base, skipping the gap before it */
+            replay_uart.time = 0;
+            replay_elapsed = 0;
+            replay_uart.pos = rec.next;
+            continue;
+        }
+
+        uint64_t due = replay_uart.time + rec.dt;
+
+        if (rec.type == HAL_CAPTURE_UART_RX)
+        {
+            if (replay_speed != 0 && due > replay_elapsed)
+                return;
+            if (HAL_UART_SimFeed(&rec.data, 1) == 0)
+                return;   /* Peer FIFO full: retry on the next poll */
+
+            capture_stats.uart_fed++;
+        }
+
+        replay_uart.time = due;
+        replay_uart.pos = rec.next;
+    }
+
+    CAPTURE_CheckDone();
+}
+
+bool HAL_CAPTURE_ReplayI2CWrite(HAL_CAPTURE_Event_t type, uint8_t sent)
+{
+    CAPTURE_Record_t rec;
+
+    if (replay_map == NULL)
+        return false;
+
+    /* Skip to the matching byte; bus conditions and unread responses the
+     * firmware did not ask for this time are passed over */
+    while (CAPTURE_NextI2C(&rec))
+    {
+        replay_i2c.pos = rec.next;
+
+        if (rec.type != type)
+            continue;
+
+        if (rec.data != sent)
+            capture_stats.i2c_mismatches++;
+
+        bool nack = CAPTURE_NextI2C(&rec) && rec.type == HAL_CAPTURE_I2C_NACK;
+        if (nack)
+        {
+            replay_i2c.pos = rec.next;
+            capture_stats.i2c_nacks++;
+        }
+        CAPTURE_CheckDone();
+        return nack;
+    }
+
+    capture_stats.replay_done = true;
+    return false;
+}
+
+bool HAL_CAPTURE_ReplayI2CRead(uint8_t *data)
+{
+    CAPTURE_Record_t rec;
+
+    if (replay_map == NULL)
+        return false;
+
+    /* A read longer than the recorded one gets no data rather than the
+     * responses of the next recorded transaction */
+    while (CAPTURE_NextI2C(&rec) && rec.type != HAL_CAPTURE_I2C_ADDR &&
+           rec.type != HAL_CAPTURE_I2C_TX)
+    {
+        replay_i2c.pos = rec.next;
+
+        if (rec.type == HAL_CAPTURE_I2C_RX)
+        {
+            *data = rec.data;
+            capture_stats.i2c_read++;
+            return true;
+        }
+    }
+
+    CAPTURE_CheckDone();
+    return false;
+}
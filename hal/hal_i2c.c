@@ -9,19 +9,256 @@
  *  - Start condition sets the START bit and clears STOP
  *  - Address phase always succeeds (ADDR flag set)
  *  - TXE is always ready after writing DR
- *  - RXNE becomes ready with DR containing a pseudo-random value
+ *  - Reads are clocked through a double-buffered receiver (DR + shift
+ *    register, see hal_i2c.h) from a slave that sends a fixed pattern
+ *  - If the target (I2C2) is enabled and owns the address, it is the slave:
+ *    each bus event sets its flags and runs its event handler at once, as
+ *    its interrupt would preempt the controller's busy-wait. As a
+ *    transmitter it preloads the next byte while the current one is on the
+ *    wire
+ *
+ * When an external device simulator is online (hal_sim.h), the address and
+ * data phases are left to the device: the HAL clears the relevant flag, rings
+ * the I2C1 doorbell and the driver waits for the device to set it again.
+ *
+ * The local simulation can also inject bus faults (stuck SDA, clock
+ * stretching, NACKs, corrupted data; see hal_i2c.h) to exercise the
+ * driver's error handling and bus recovery. Its bus events can be captured
+ * to a file, and a captured file can play the slave (hal_capture.h).
  *
  * For real microcontrollers, replace ALL logic with actual register accesses.
  */
 
+#include <stddef.h>
+
 #include "hal_i2c.h"
+#include "hal_sim.h"
+#include "hal_timer.h"
+#include "hal_capture.h"
 #include "board.h"
 
+/* CR changes collected between HAL_I2C_ControlBegin() and _ControlCommit() */
+static HAL_REG_Shadow_t i2c_cr_shadow;
+
 /* -------------------------------------------------------------------------- */
-/*                          Simulated Peripheral Instance                      */
+/*                            Simulated Bus Faults                             */
 /* -------------------------------------------------------------------------- */
 
-I2C_Registers_t I2C1 = {0};
+static uint32_t i2c_sim_sda_stuck;        /* Pulses until SDA is released, 0 = free */
+static uint32_t i2c_sim_pulses;
+static uint32_t i2c_sim_stretch_ticks;
+static uint32_t i2c_sim_stretch_count;
+static uint32_t i2c_sim_stretch_start;
+static bool i2c_sim_stretching;
+static uint32_t i2c_sim_nack_count[2];    /* Indexed by HAL_I2C_SimPhase_t */
+static uint8_t i2c_sim_corrupt_mask;
+static uint32_t i2c_sim_corrupt_count;
+static uint32_t i2c_sim_starts;
+static uint32_t i2c_sim_stops;
+
+#define I2C_SIM_READ_DATA_MAX   64U
+
+static uint8_t i2c_sim_read_data[I2C_SIM_READ_DATA_MAX] = { 0x33 };
+static uint32_t i2c_sim_read_len = 1;
+static uint32_t i2c_sim_read_pos;
+static bool i2c_sim_wire_timing;
+static HAL_I2C_SimRxStats_t i2c_sim_rx_stats;
+
+/* Receiver state between HAL_I2C_ClearAddress() and the end of the read */
+static struct
+{
+    bool reading;          /* Last address phase was a read */
+    bool shifting;         /* A byte is being clocked in */
+    uint32_t shift_start;
+    bool shift_full;       /* Completed byte waiting behind DR (BTF) */
+    uint8_t shift_data;
+    uint32_t stall_start;
+    bool pos_ack;          /* (N)ACK for the next byte when POS is set */
+    bool last_ack;         /* (N)ACK given to the last completed byte */
+    bool ending;           /* STOP or repeated START requested */
+} i2c_sim_rx;
+
+static HAL_I2C_SimIrqHandler_t i2c_sim_target_irq;
+static bool i2c_sim_target_selected;      /* Last address phase matched the target */
+
+static void HAL_I2C_SimBeginPhase(void)
+{
+    if (i2c_sim_stretch_count == 0)
+        return;
+
+    i2c_sim_stretch_count--;
+    i2c_sim_stretching = true;
+    i2c_sim_stretch_start = HAL_TIMER_GetTicks();
+}
+
+static bool HAL_I2C_SimTakeNack(HAL_I2C_SimPhase_t phase)
+{
+    if (i2c_sim_nack_count[phase] == 0)
+        return false;
+
+    i2c_sim_nack_count[phase]--;
+    return true;
+}
+
+/* Raise a target event and run its interrupt handler */
+static void HAL_I2C_SimTargetEvent(uint32_t flag)
+{
+    I2C2.SR |= flag;
+    if (i2c_sim_target_irq != NULL)
+        i2c_sim_target_irq();
+}
+
+/* Address phase on the bus: false if the target NACKs its own address */
+static bool HAL_I2C_SimTargetAddress(uint8_t byte)
+{
+    i2c_sim_target_selected = (I2C2.CR & I2C_CR_ENABLE) && (I2C2.OAR & I2C_OAR_EN) &&
+                              (I2C2.OAR & I2C_OAR_ADDR_MASK) == (uint32_t)(byte >> 1);
+    if (!i2c_sim_target_selected)
+        return true;   /* Not ours: the local slave answers */
+
+    if (!(I2C2.CR & I2C_CR_ACK))
+    {
+        i2c_sim_target_selected = false;
+        return false;
+    }
+
+    /* A transmitter loads its first byte as soon as it is addressed */
+    if (byte & 0x01U)
+        I2C2.SR |= I2C_SR_TRA | I2C_SR_TXE;
+    else
+        I2C2.SR &= ~(I2C_SR_TRA | I2C_SR_TXE);
+
+    HAL_I2C_SimTargetEvent(I2C_SR_ADDR);
+    return true;
+}
+
+/* Controller write: false if the target NACKs the byte. ACK is sampled
+ * before the byte lands; a NACKed byte still reaches DR */
+static bool HAL_I2C_SimTargetWrite(uint8_t data)
+{
+    bool ack = (I2C2.CR & I2C_CR_ACK) != 0;
+
+    I2C2.DR = data;
+    HAL_I2C_SimTargetEvent(I2C_SR_RXNE);
+    return ack;
+}
+
+/* Controller read: DR moves to the shift register and TXE asks for the next
+ * byte at once, so the target has preloaded one byte past the last the
+ * controller reads */
+static uint8_t HAL_I2C_SimTargetRead(void)
+{
+    uint8_t data = 0xFF;   /* Nothing loaded: SDA stays released */
+
+    if (!(I2C2.SR & I2C_SR_TXE))
+        data = (uint8_t)I2C2.DR;
+
+    HAL_I2C_SimTargetEvent(I2C_SR_TXE);
+    return data;
+}
+
+/* Ticks for one byte plus its ACK bit at the configured speed */
+static uint32_t HAL_I2C_SimByteTicks(void)
+{
+    if (!i2c_sim_wire_timing || I2C1.CCR == 0)
+        return 0;
+
+    return (uint32_t)(9ULL * HAL_TIMER_TICK_HZ / I2C1.CCR);
+}
+
+static void HAL_I2C_SimStartByte(uint32_t now)
+{
+    i2c_sim_rx.shifting = true;
+    i2c_sim_rx.shift_start = now;
+    HAL_I2C_SimBeginPhase();
+}
+
+/**
+ * Bring the receiver up to date: complete every byte whose time on the wire
+ * has passed, moving it to DR or, if DR is still full, parking it in the
+ * shift register with BTF set.
+ */
+static void HAL_I2C_SimAdvanceRx(void)
+{
+    uint32_t byte_ticks = HAL_I2C_SimByteTicks();
+
+    while (i2c_sim_rx.shifting && !HAL_I2C_IsClockStretched())
+    {
+        uint32_t done = i2c_sim_rx.shift_start + byte_ticks;
+
+        if (HAL_TIMER_GetTicks() - i2c_sim_rx.shift_start < byte_ticks)
+            return;
+
+        bool ack = (I2C1.CR & I2C_CR_POS) ? i2c_sim_rx.pos_ack : (I2C1.CR & I2C_CR_ACK) != 0;
+        uint8_t data;
+
+        if (i2c_sim_target_selected)
+        {
+            data = HAL_I2C_SimTargetRead();
+            if (!ack)
+                HAL_I2C_SimTargetEvent(I2C_SR_AF);
+        }
+        else if (!HAL_CAPTURE_ReplayI2CRead(&data))
+        {
+            data = i2c_sim_read_data[i2c_sim_read_pos];
+            i2c_sim_read_pos = (i2c_sim_read_pos + 1U) % i2c_sim_read_len;
+        }
+        HAL_CAPTURE_Record(HAL_CAPTURE_I2C_RX, data);
+
+        i2c_sim_rx.pos_ack = (I2C1.CR & I2C_CR_ACK) != 0;
+        i2c_sim_rx.last_ack = ack;
+        i2c_sim_rx.shifting = false;
+        i2c_sim_rx_stats.bytes++;
+
+        if (ack && i2c_sim_rx.ending)
+            i2c_sim_rx_stats.acked_last++;
+
+        if (I2C1.SR & I2C_SR_RXNE)
+        {
+            i2c_sim_rx.shift_data = data;
+            i2c_sim_rx.shift_full = true;
+            i2c_sim_rx.stall_start = done;
+            I2C1.SR |= I2C_SR_BTF;
+            return;
+        }
+
+        I2C1.DR = data;
+        I2C1.SR |= I2C_SR_RXNE;
+
+        if (ack && !i2c_sim_rx.ending)
+            HAL_I2C_SimStartByte(done);
+    }
+}
+
+/* The read is over (STOP or repeated START): nothing more is clocked in */
+static void HAL_I2C_SimEndRx(void)
+{
+    HAL_I2C_SimAdvanceRx();
+
+    if (i2c_sim_rx.reading && !i2c_sim_rx.ending && !i2c_sim_rx.shifting &&
+        i2c_sim_rx.last_ack)
+        i2c_sim_rx_stats.acked_last++;   /* The slave is already driving the next byte */
+
+    i2c_sim_rx.ending = true;
+}
+
+/* New address phase: whatever the last read left behind is lost */
+static void HAL_I2C_SimResetRx(bool reading)
+{
+    HAL_I2C_SimAdvanceRx();
+
+    if (I2C1.SR & I2C_SR_RXNE)
+        i2c_sim_rx_stats.unread++;
+    if (i2c_sim_rx.shift_full)
+        i2c_sim_rx_stats.unread++;
+
+    i2c_sim_rx.reading = reading;
+    i2c_sim_rx.shifting = false;
+    i2c_sim_rx.shift_full = false;
+    i2c_sim_rx.last_ack = false;
+    i2c_sim_rx.ending = false;
+    I2C1.SR &= ~(I2C_SR_RXNE | I2C_SR_BTF);
+}
 
 /* -------------------------------------------------------------------------- */
 /*                        Clock & Pin Configuration (Simulated)               */
@@ -43,13 +280,13 @@ void HAL_I2C_ConfigurePins(void)
 
 void HAL_I2C_Enable(void)
 {
-    I2C1.CR |= I2C_CR_ENABLE;
+    HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, 0, I2C_CR_ENABLE);
 }
 
 void HAL_I2C_SetSpeed(uint32_t speed_hz)
 {
     /* In real hardware, CCR depends on CPU clock and required I2C speed. */
-    I2C1.CCR = speed_hz;
+    HAL_REG_Write(&I2C1.CCR, speed_hz);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -58,26 +295,88 @@ void HAL_I2C_SetSpeed(uint32_t speed_hz)
 
 void HAL_I2C_GenerateStart(void)
 {
-    I2C1.CR |= I2C_CR_START;
-    I2C1.CR &= ~I2C_CR_STOP;
+    /* A slave holding SDA low makes a START impossible (arbitration lost) */
+    if (i2c_sim_sda_stuck != 0)
+    {
+        I2C1.CR &= ~I2C_CR_START;
+        return;
+    }
+
+    if (!HAL_SIM_IsDeviceOnline())
+        HAL_I2C_SimEndRx();
+    i2c_sim_target_selected = false;   /* Until the next address matches */
+
+    HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, I2C_CR_STOP, I2C_CR_START);
     I2C1.SR |= I2C_SR_BUSY;
+    i2c_sim_starts++;
+    HAL_CAPTURE_Record(HAL_CAPTURE_I2C_START, 0);
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
 }
 
 void HAL_I2C_GenerateStop(void)
 {
-    I2C1.CR |= I2C_CR_STOP;
-    I2C1.CR &= ~I2C_CR_START;
-    I2C1.SR &= ~I2C_SR_BUSY;
+    bool pending = false;
+
+    if (!HAL_SIM_IsDeviceOnline())
+        HAL_I2C_SimEndRx();
+    else
+        pending = i2c_sim_rx.reading && (I2C1.SR & I2C_SR_RXNE);
+
+    HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, I2C_CR_START, I2C_CR_STOP);
+
+    /* During a read an external device still sends the byte in flight and
+     * then releases the bus itself */
+    if (!pending)
+        I2C1.SR &= ~I2C_SR_BUSY;
+    i2c_sim_stops++;
+    HAL_CAPTURE_Record(HAL_CAPTURE_I2C_STOP, 0);
+
+    if (i2c_sim_target_selected)
+    {
+        i2c_sim_target_selected = false;
+        I2C2.SR &= ~I2C_SR_TXE;   /* A preloaded byte is never sent */
+        HAL_I2C_SimTargetEvent(I2C_SR_STOPF);
+    }
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
 }
 
+/* ACK/POS changes only affect bytes completing after them */
+
 void HAL_I2C_SendACK(void)
 {
-    I2C1.CR |= I2C_CR_ACK;
+    HAL_I2C_SimAdvanceRx();
+    HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, 0, I2C_CR_ACK);
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
 }
 
 void HAL_I2C_SendNACK(void)
 {
-    I2C1.CR &= ~I2C_CR_ACK;
+    HAL_I2C_SimAdvanceRx();
+    HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, I2C_CR_ACK, 0);
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+}
+
+void HAL_I2C_SetAckPosition(bool next)
+{
+    HAL_I2C_SimAdvanceRx();
+
+    if (next)
+        HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, 0, I2C_CR_POS);
+    else
+        HAL_REG_ShadowModify(&i2c_cr_shadow, &I2C1.CR, I2C_CR_POS, 0);
+
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+}
+
+void HAL_I2C_ControlBegin(void)
+{
+    HAL_REG_ShadowBegin(&i2c_cr_shadow, &I2C1.CR);
+}
+
+void HAL_I2C_ControlCommit(void)
+{
+    if (HAL_REG_ShadowCommit(&i2c_cr_shadow))
+        HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -86,8 +385,35 @@ void HAL_I2C_SendNACK(void)
 
 void HAL_I2C_SendAddress(uint8_t address, I2C_Direction_t direction)
 {
+    if (HAL_SIM_IsDeviceOnline())
+    {
+        i2c_sim_rx.reading = (direction == I2C_READ);
+
+        /* Device sets ADDR (and TXE) once it has ACKed the address */
+        I2C1.SR &= ~(I2C_SR_ADDR | I2C_SR_TXE | I2C_SR_RXNE);
+        HAL_REG_Write(&I2C1.DR, (uint32_t)((address << 1) | (direction & 0x01)));
+        HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+        return;
+    }
+
+    HAL_I2C_SimResetRx(direction == I2C_READ);
+
+    uint8_t byte = (uint8_t)((address << 1) | (direction & 0x01));
+
+    HAL_REG_Write(&I2C1.DR, byte);
+    I2C1.SR &= ~(I2C_SR_ADDR | I2C_SR_AF);
+    HAL_I2C_SimBeginPhase();
+    HAL_CAPTURE_Record(HAL_CAPTURE_I2C_ADDR, byte);
+
+    if (HAL_CAPTURE_ReplayI2CWrite(HAL_CAPTURE_I2C_ADDR, byte) ||
+        HAL_I2C_SimTakeNack(HAL_I2C_SIM_PHASE_ADDRESS) || !HAL_I2C_SimTargetAddress(byte))
+    {
+        HAL_CAPTURE_Record(HAL_CAPTURE_I2C_NACK, 0);
+        I2C1.SR |= I2C_SR_AF;
+        return;
+    }
+
     /* Simulate address match */
-    I2C1.DR = (address << 1) | (direction & 0x01);
     I2C1.SR |= I2C_SR_ADDR;
 
     /* TX ready after address sent */
@@ -96,14 +422,81 @@ void HAL_I2C_SendAddress(uint8_t address, I2C_Direction_t direction)
 
 void HAL_I2C_SendData(uint8_t data)
 {
-    I2C1.DR = data;
+    if (HAL_SIM_IsDeviceOnline())
+    {
+        I2C1.SR &= ~I2C_SR_TXE;
+        HAL_REG_Write(&I2C1.DR, data);
+        HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+        return;
+    }
+
+    HAL_REG_Write(&I2C1.DR, data);
+    HAL_I2C_SimBeginPhase();
+    HAL_CAPTURE_Record(HAL_CAPTURE_I2C_TX, data);
+
+    if (HAL_CAPTURE_ReplayI2CWrite(HAL_CAPTURE_I2C_TX, data) ||
+        HAL_I2C_SimTakeNack(HAL_I2C_SIM_PHASE_DATA) ||
+        (i2c_sim_target_selected && !HAL_I2C_SimTargetWrite(data)))
+    {
+        HAL_CAPTURE_Record(HAL_CAPTURE_I2C_NACK, 0);
+        I2C1.SR &= ~I2C_SR_TXE;
+        I2C1.SR |= I2C_SR_AF;
+        return;
+    }
+
     I2C1.SR |= I2C_SR_TXE; /* TX done */
 }
 
 uint8_t HAL_I2C_ReadData(void)
 {
-    /* In simulation, always return DR */
-    return (uint8_t)I2C1.DR;
+    if (HAL_SIM_IsDeviceOnline())
+    {
+        uint8_t data = (uint8_t)HAL_REG_Read(&I2C1.DR);
+        I2C1.SR &= ~I2C_SR_RXNE;
+        HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+        return data;
+    }
+
+    HAL_I2C_SimAdvanceRx();
+
+    uint8_t data = (uint8_t)HAL_REG_Read(&I2C1.DR);
+
+    if (i2c_sim_corrupt_count != 0)
+    {
+        i2c_sim_corrupt_count--;
+        data ^= i2c_sim_corrupt_mask;
+    }
+
+    if (i2c_sim_rx.shift_full)
+    {
+        /* The parked byte moves up and SCL is released */
+        uint32_t now = HAL_TIMER_GetTicks();
+
+        I2C1.DR = i2c_sim_rx.shift_data;
+        I2C1.SR &= ~I2C_SR_BTF;
+        i2c_sim_rx.shift_full = false;
+        i2c_sim_rx_stats.stalls++;
+        i2c_sim_rx_stats.stall_ticks += now - i2c_sim_rx.stall_start;
+
+        if (i2c_sim_rx.last_ack && !i2c_sim_rx.ending)
+            HAL_I2C_SimStartByte(now);
+    }
+    else
+    {
+        I2C1.SR &= ~I2C_SR_RXNE;
+    }
+
+    return data;
+}
+
+void HAL_I2C_ClearAddress(void)
+{
+    if (HAL_SIM_IsDeviceOnline() || !i2c_sim_rx.reading || i2c_sim_rx.ending)
+        return;
+
+    /* The first byte after the address is ACKed when POS is set */
+    i2c_sim_rx.pos_ack = true;
+    HAL_I2C_SimStartByte(HAL_TIMER_GetTicks());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -112,23 +505,283 @@ uint8_t HAL_I2C_ReadData(void)
 
 bool HAL_I2C_IsStartGenerated(void)
 {
-    return (I2C1.CR & I2C_CR_START);
+    return (HAL_REG_ShadowRead(&i2c_cr_shadow, &I2C1.CR) & I2C_CR_START);
 }
 
 bool HAL_I2C_IsAddressSent(void)
 {
-    return (I2C1.SR & I2C_SR_ADDR);
+    if (HAL_I2C_IsClockStretched())
+        return false;
+
+    return HAL_SIM_Poll(HAL_REG_Read(&I2C1.SR) & I2C_SR_ADDR);
 }
 
 bool HAL_I2C_IsTxComplete(void)
 {
-    return (I2C1.SR & I2C_SR_TXE);
+    if (HAL_I2C_IsClockStretched())
+        return false;
+
+    return HAL_SIM_Poll(HAL_REG_Read(&I2C1.SR) & I2C_SR_TXE);
 }
 
 bool HAL_I2C_IsRxReady(void)
 {
-    /* Simulate data ready */
-    I2C1.SR |= I2C_SR_RXNE;
-    I2C1.DR = 0x33;  /* Fake sensor data */
+    if (HAL_SIM_IsDeviceOnline())
+        return HAL_SIM_Poll(HAL_REG_Read(&I2C1.SR) & I2C_SR_RXNE);
+
+    HAL_I2C_SimAdvanceRx();
+    return (HAL_REG_Read(&I2C1.SR) & I2C_SR_RXNE) != 0;
+}
+
+bool HAL_I2C_IsByteTransferFinished(void)
+{
+    /* An external device fills DR one byte at a time: no second buffer */
+    if (HAL_SIM_IsDeviceOnline())
+        return HAL_SIM_Poll(HAL_REG_Read(&I2C1.SR) & I2C_SR_RXNE);
+
+    HAL_I2C_SimAdvanceRx();
+    return (HAL_REG_Read(&I2C1.SR) & I2C_SR_BTF) != 0;
+}
+
+bool HAL_I2C_IsAckFailure(void)
+{
+    return (HAL_REG_Read(&I2C1.SR) & I2C_SR_AF) != 0;
+}
+
+void HAL_I2C_ClearAckFailure(void)
+{
+    HAL_REG_Modify(&I2C1.SR, I2C_SR_AF, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Bus Line State & Recovery                          */
+/* -------------------------------------------------------------------------- */
+
+bool HAL_I2C_IsSDALow(void)
+{
+    return i2c_sim_sda_stuck != 0;
+}
+
+bool HAL_I2C_IsClockStretched(void)
+{
+    if (!i2c_sim_stretching)
+        return false;
+
+    if (HAL_TIMER_GetTicks() - i2c_sim_stretch_start >= i2c_sim_stretch_ticks)
+    {
+        i2c_sim_stretching = false;
+        return false;
+    }
     return true;
 }
+
+void HAL_I2C_RecoveryBegin(void)
+{
+    /* Real hardware: disable the peripheral, SCL/SDA -> open-drain GPIO high */
+    HAL_REG_Modify(&I2C1.CR, I2C_CR_ENABLE, 0);
+}
+
+void HAL_I2C_RecoveryPulseSCL(void)
+{
+    i2c_sim_pulses++;
+
+    /* Each clock lets the stuck slave shift out one more bit */
+    if (i2c_sim_sda_stuck != 0 && i2c_sim_sda_stuck != HAL_I2C_SIM_STUCK_FOREVER)
+        i2c_sim_sda_stuck--;
+}
+
+void HAL_I2C_RecoveryStop(void)
+{
+    if (i2c_sim_sda_stuck == 0)
+        I2C1.SR &= ~I2C_SR_BUSY;
+}
+
+void HAL_I2C_RecoveryEnd(void)
+{
+    /* Real hardware: give SCL/SDA back to the peripheral (alternate function) */
+}
+
+void HAL_I2C_Reset(void)
+{
+    HAL_REG_Write(&I2C1.CR, I2C_CR_SWRST);
+    HAL_REG_Write(&I2C1.CR, 0);
+    I2C1.SR = 0;
+    i2c_sim_stretching = false;
+    i2c_sim_rx.reading = false;
+    i2c_sim_rx.shifting = false;
+    i2c_sim_rx.shift_full = false;
+    i2c_sim_target_selected = false;
+    HAL_SIM_RingDoorbell(SIM_PERIPH_I2C1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Target Mode (I2C2)                             */
+/* -------------------------------------------------------------------------- */
+
+void HAL_I2C_TargetEnable(uint8_t own_address)
+{
+    I2C2.SR = 0;
+    HAL_REG_Write(&I2C2.OAR, (own_address & I2C_OAR_ADDR_MASK) | I2C_OAR_EN);
+    HAL_REG_Write(&I2C2.CR, I2C_CR_ENABLE | I2C_CR_ACK);
+}
+
+void HAL_I2C_TargetDisable(void)
+{
+    HAL_REG_Write(&I2C2.CR, 0);
+    HAL_REG_Write(&I2C2.OAR, 0);
+    I2C2.SR = 0;
+}
+
+void HAL_I2C_TargetSetAck(bool ack)
+{
+    if (ack)
+        HAL_REG_Modify(&I2C2.CR, 0, I2C_CR_ACK);
+    else
+        HAL_REG_Modify(&I2C2.CR, I2C_CR_ACK, 0);
+}
+
+bool HAL_I2C_TargetIsAddressed(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_ADDR) != 0;
+}
+
+bool HAL_I2C_TargetIsTransmitter(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_TRA) != 0;
+}
+
+void HAL_I2C_TargetClearAddress(void)
+{
+    HAL_REG_Modify(&I2C2.SR, I2C_SR_ADDR, 0);
+}
+
+bool HAL_I2C_TargetIsRxReady(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_RXNE) != 0;
+}
+
+uint8_t HAL_I2C_TargetReadData(void)
+{
+    I2C2.SR &= ~I2C_SR_RXNE;
+    return (uint8_t)HAL_REG_Read(&I2C2.DR);
+}
+
+bool HAL_I2C_TargetIsTxEmpty(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_TXE) != 0;
+}
+
+void HAL_I2C_TargetWriteData(uint8_t data)
+{
+    HAL_REG_Write(&I2C2.DR, data);
+    I2C2.SR &= ~I2C_SR_TXE;
+}
+
+bool HAL_I2C_TargetIsNacked(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_AF) != 0;
+}
+
+void HAL_I2C_TargetClearNack(void)
+{
+    HAL_REG_Modify(&I2C2.SR, I2C_SR_AF, 0);
+}
+
+bool HAL_I2C_TargetIsStopDetected(void)
+{
+    return (HAL_REG_Read(&I2C2.SR) & I2C_SR_STOPF) != 0;
+}
+
+void HAL_I2C_TargetClearStop(void)
+{
+    HAL_REG_Modify(&I2C2.SR, I2C_SR_STOPF, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                         Simulated Fault Injection                           */
+/* -------------------------------------------------------------------------- */
+
+void HAL_I2C_SimStickSDA(uint32_t pulses)
+{
+    i2c_sim_sda_stuck = pulses;
+}
+
+void HAL_I2C_SimStretchClock(uint32_t ticks, uint32_t count)
+{
+    i2c_sim_stretch_ticks = ticks;
+    i2c_sim_stretch_count = count;
+}
+
+void HAL_I2C_SimInjectNack(HAL_I2C_SimPhase_t phase, uint32_t count)
+{
+    i2c_sim_nack_count[phase] = count;
+}
+
+void HAL_I2C_SimCorruptData(uint8_t mask, uint32_t count)
+{
+    i2c_sim_corrupt_mask = mask;
+    i2c_sim_corrupt_count = count;
+}
+
+void HAL_I2C_SimSetReadData(const uint8_t *data, uint32_t len)
+{
+    if (len > I2C_SIM_READ_DATA_MAX)
+        len = I2C_SIM_READ_DATA_MAX;
+
+    for (uint32_t i = 0; i < len; i++)
+        i2c_sim_read_data[i] = data[i];
+
+    i2c_sim_read_len = (len != 0) ? len : 1U;
+    i2c_sim_read_pos = 0;
+}
+
+void HAL_I2C_SimSetWireTiming(bool enable)
+{
+    i2c_sim_wire_timing = enable;
+}
+
+void HAL_I2C_SimClearFaults(void)
+{
+    i2c_sim_sda_stuck = 0;
+    i2c_sim_pulses = 0;
+    i2c_sim_stretch_count = 0;
+    i2c_sim_stretching = false;
+    i2c_sim_nack_count[HAL_I2C_SIM_PHASE_ADDRESS] = 0;
+    i2c_sim_nack_count[HAL_I2C_SIM_PHASE_DATA] = 0;
+    i2c_sim_corrupt_count = 0;
+    i2c_sim_starts = 0;
+    i2c_sim_stops = 0;
+    i2c_sim_read_data[0] = 0x33;
+    i2c_sim_read_len = 1;
+    i2c_sim_read_pos = 0;
+    i2c_sim_wire_timing = false;
+    i2c_sim_rx_stats = (HAL_I2C_SimRxStats_t){ 0 };
+    i2c_sim_rx.shifting = false;
+    i2c_sim_rx.shift_full = false;
+    I2C1.SR &= ~(I2C_SR_RXNE | I2C_SR_BTF);
+}
+
+uint32_t HAL_I2C_SimGetRecoveryPulses(void)
+{
+    return i2c_sim_pulses;
+}
+
+uint32_t HAL_I2C_SimGetStartCount(void)
+{
+    return i2c_sim_starts;
+}
+
+uint32_t HAL_I2C_SimGetStopCount(void)
+{
+    return i2c_sim_stops;
+}
+
+void HAL_I2C_SimGetRxStats(HAL_I2C_SimRxStats_t *stats)
+{
+    *stats = i2c_sim_rx_stats;
+}
+
+void HAL_I2C_SimSetTargetIrq(HAL_I2C_SimIrqHandler_t handler)
+{
+    i2c_sim_target_irq = handler;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file hal_nvic.c
+ * @brief Simulated NVIC-style interrupt controller (see hal_nvic.h).
+ *
+ * Enable, pending and active bits are atomic bit masks, so any thread may
+ * change them. A dispatch marks the line active before it checks PRIMASK,
+ * and EnterCritical() raises PRIMASK before it checks the active mask: with
+ * sequentially consistent atomics at least one side sees the other, so a
+ * handler never runs inside a critical section.
+ *
+ * Level-triggered lines are sampled before every dispatch decision, which
+ * is also when the simulated peripheral advances (a byte queued by the UART
+ * peer reaches DATA), just as hardware would without any driver call.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "hal_nvic.h"
+#include "hal_uart.h"
+
+/* -------------------------------------------------------------------------- */
+/*                              Controller State                               */
+/* -------------------------------------------------------------------------- */
+
+static _Atomic uint32_t nvic_enabled;
+static _Atomic uint32_t nvic_pending;
+static _Atomic uint32_t nvic_active;
+static _Atomic uint32_t nvic_primask;           /* Critical section nesting depth */
+static _Atomic uint32_t nvic_priority[HAL_IRQ_COUNT];
+static _Atomic uint32_t nvic_dispatched[HAL_IRQ_COUNT];
+static _Atomic(HAL_NVIC_Handler_t) nvic_handler[HAL_IRQ_COUNT];
+
+static _Thread_local bool nvic_in_handler;
+
+static atomic_bool nvic_running;
+static bool nvic_thread_started;
+static pthread_t nvic_thread;
+
+/* Peripheral interrupt outputs; NULL lines are only pended by software */
+static bool (*const nvic_level[HAL_IRQ_COUNT])(void) = {
+    [HAL_IRQ_UART1] = HAL_UART_SimIrqLevel
+};
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static void HAL_NVIC_SampleLines(void)
+{
+    for (uint32_t irq = 0; irq < HAL_IRQ_COUNT; irq++)
+    {
+        if (nvic_level[irq] != NULL && nvic_level[irq]())
+            atomic_fetch_or(&nvic_pending, 1U << irq);
+    }
+}
+
+/* Most urgent enabled, pending line, or -1 */
+static int32_t HAL_NVIC_Next(void)
+{
+    uint32_t ready = atomic_load(&nvic_pending) & atomic_load(&nvic_enabled);
+    int32_t best = -1;
+    uint32_t best_priority = UINT32_MAX;
+
+    for (uint32_t irq = 0; irq < HAL_IRQ_COUNT; irq++)
+    {
+        uint32_t priority = atomic_load(&nvic_priority[irq]);
+
+        if ((ready & (1U << irq)) && priority < best_priority)
+        {
+            best = (int32_t)irq;
+            best_priority = priority;
+        }
+    }
+    return best;
+}
+
+static bool HAL_NVIC_DispatchOne(void)
+{
+    HAL_NVIC_SampleLines();
+
+    int32_t irq = HAL_NVIC_Next();
+    if (irq < 0)
+        return false;
+
+    uint32_t bit = 1U << irq;
+
+    atomic_fetch_or(&nvic_active, bit);
+    if (atomic_load(&nvic_primask) != 0)
+    {
+        atomic_fetch_and(&nvic_active, ~bit);
+        return false;
+    }
+
+    atomic_fetch_and(&nvic_pending, ~bit);
+
+    HAL_NVIC_Handler_t handler = atomic_load(&nvic_handler[irq]);
+
+    nvic_in_handler = true;
+    if (handler != NULL)
+        handler();
+    nvic_in_handler = false;
+
+    atomic_fetch_add(&nvic_dispatched[irq], 1U);
+    atomic_fetch_and(&nvic_active, ~bit);
+    return true;
+}
+
+static void HAL_NVIC_WaitInactive(uint32_t mask)
+{
+    while (atomic_load(&nvic_active) & mask)
+        sched_yield();
+}
+
+static void *HAL_NVIC_Thread(void *arg)
+{
+    (void)arg;
+
+    while (atomic_load(&nvic_running))
+    {
+        if (!HAL_NVIC_DispatchOne())
+            sched_yield();
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+void HAL_NVIC_SetHandler(HAL_IRQn_t irq, HAL_NVIC_Handler_t handler)
+{
+    atomic_store(&nvic_handler[irq], handler);
+}
+
+void HAL_NVIC_SetPriority(HAL_IRQn_t irq, uint8_t priority)
+{
+    if (priority > HAL_NVIC_PRIO_LOWEST)
+        priority = HAL_NVIC_PRIO_LOWEST;
+
+    atomic_store(&nvic_priority[irq], priority);
+}
+
+void HAL_NVIC_EnableIRQ(HAL_IRQn_t irq)
+{
+    atomic_fetch_or(&nvic_enabled, 1U << irq);
+}
+
+void HAL_NVIC_DisableIRQ(HAL_IRQn_t irq)
+{
+    atomic_fetch_and(&nvic_enabled, ~(1U << irq));
+
+    if (!nvic_in_handler)
+        HAL_NVIC_WaitInactive(1U << irq);
+}
+
+void HAL_NVIC_SetPendingIRQ(HAL_IRQn_t irq)
+{
+    atomic_fetch_or(&nvic_pending, 1U << irq);
+}
+
+void HAL_NVIC_ClearPendingIRQ(HAL_IRQn_t irq)
+{
+    atomic_fetch_and(&nvic_pending, ~(1U << irq));
+}
+
+bool HAL_NVIC_IsPending(HAL_IRQn_t irq)
+{
+    return (atomic_load(&nvic_pending) & (1U << irq)) != 0;
+}
+
+bool HAL_NVIC_IsActive(HAL_IRQn_t irq)
+{
+    return (atomic_load(&nvic_active) & (1U << irq)) != 0;
+}
+
+bool HAL_NVIC_InHandler(void)
+{
+    return nvic_in_handler;
+}
+
+uint32_t HAL_NVIC_GetDispatchCount(HAL_IRQn_t irq)
+{
+    return atomic_load(&nvic_dispatched[irq]);
+}
+
+void HAL_NVIC_EnterCritical(void)
+{
+    if (nvic_in_handler)
+        return;
+
+    atomic_fetch_add(&nvic_primask, 1U);
+    HAL_NVIC_WaitInactive(UINT32_MAX);
+}
+
+void HAL_NVIC_ExitCritical(void)
+{
+    if (nvic_in_handler)
+        return;
+
+    atomic_fetch_sub(&nvic_primask, 1U);
+}
+
+uint32_t HAL_NVIC_Poll(void)
+{
+    uint32_t count = 0;
+
+    if (atomic_load(&nvic_running))
+        return 0;
+
+    while (HAL_NVIC_DispatchOne())
+        count++;
+
+    return count;
+}
+
+bool HAL_NVIC_StartDispatcher(void)
+{
+    if (nvic_thread_started)
+        return true;
+
+    atomic_store(&nvic_running, true);
+    if (pthread_create(&nvic_thread, NULL, HAL_NVIC_Thread, NULL) != 0)
+    {
+        atomic_store(&nvic_running, false);
+        return false;
+    }
+
+    nvic_thread_started = true;
+    return true;
+}
+
+void HAL_NVIC_StopDispatcher(void)
+{
+    if (!nvic_thread_started)
+        return;
+
+    atomic_store(&nvic_running, false);
+    pthread_join(nvic_thread, NULL);
+    nvic_thread_started = false;
+}
+
+void HAL_NVIC_Reset(void)
+{
+    HAL_NVIC_StopDispatcher();
+
+    atomic_store(&nvic_enabled, 0);
+    atomic_store(&nvic_pending, 0);
+    atomic_store(&nvic_primask, 0);
+
+    for (uint32_t irq = 0; irq < HAL_IRQ_COUNT; irq++)
+    {
+        atomic_store(&nvic_priority[irq], 0);
+        atomic_store(&nvic_dispatched[irq], 0);
+        atomic_store(&nvic_handler[irq], NULL);
+    }
+}
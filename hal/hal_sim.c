@@ -0,0 +1,309 @@
+/**
+ * @file hal_sim.c
+ * @brief Simulated register file and shared-memory co-simulation link.
+ *
+ * Owns the process-local register blocks used by default and, on request,
+ * maps a POSIX shared-memory segment so that the registers can be driven by
+ * an external device-simulator process (see hal_sim.h for the protocol).
+ *
+ * This file only exists in the simulator; real targets use fixed addresses.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hal_sim.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define SIM_FORMATTING           0xFFFFFFFFU  /* Segment magic while formatting */
+#define SIM_DETACH_DRAIN_SPINS   10000000U
+
+/* -------------------------------------------------------------------------- */
+/*                         Process-local Register File                         */
+/* -------------------------------------------------------------------------- */
+
+static SIM_RegisterFile_t sim_local = {
+    .uart1 = {
+        .STATUS = UART_STATUS_TX_READY | UART_STATUS_TC | UART_STATUS_CTS, /* TX idle at start */
+        .BAUD = UART_BAUD_RESET
+    }
+};
+
+static SIM_RegisterFile_t *sim_active = &sim_local;
+static SIM_SharedSegment_t *sim_segment = NULL;
+
+I2C_Registers_t *HAL_I2C1_Regs = &sim_local.i2c1;
+I2C_Registers_t *HAL_I2C2_Regs = &sim_local.i2c2;
+UART_Registers_t *HAL_UART1_Regs = &sim_local.uart1;
+
+/* Firmware register accesses (see hal_reg.h) */
+_Atomic uint32_t hal_reg_reads;
+_Atomic uint32_t hal_reg_writes;
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static void SIM_ResetRegisters(SIM_RegisterFile_t *file)
+{
+    file->i2c1.CR = 0;
+    file->i2c1.SR = 0;
+    file->i2c1.DR = 0;
+    file->i2c1.CCR = 0;
+    file->i2c1.OAR = 0;
+    file->i2c2.CR = 0;
+    file->i2c2.SR = 0;
+    file->i2c2.DR = 0;
+    file->i2c2.CCR = 0;
+    file->i2c2.OAR = 0;
+
+    file->uart1.STATUS = UART_STATUS_TX_READY | UART_STATUS_TC | UART_STATUS_CTS;
+    file->uart1.DATA = 0;
+    file->uart1.CTRL = 0;
+    file->uart1.BAUD = UART_BAUD_RESET;
+
+    for (uint32_t p = 0; p < SIM_PERIPH_COUNT; p++)
+    {
+        file->doorbell[p].to_dev = 0;
+        file->doorbell[p].to_fw = 0;
+    }
+}
+
+static bool SIM_ClaimSlot(SIM_RegisterFile_t *file)
+{
+    uint32_t flags = atomic_load(&file->flags);
+
+    while (!(flags & SIM_FLAG_CLAIMED))
+    {
+        if (atomic_compare_exchange_weak(&file->flags, &flags, flags | SIM_FLAG_CLAIMED))
+            return true;
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Segment Mapping                                   */
+/* -------------------------------------------------------------------------- */
+
+SIM_SharedSegment_t *HAL_SIM_MapShared(const char *name, bool create)
+{
+    int fd = shm_open(name, O_RDWR | (create ? O_CREAT : 0), 0600);
+    if (fd < 0)
+        return NULL;
+
+    if (create && ftruncate(fd, (off_t)sizeof(SIM_SharedSegment_t)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *mem = mmap(NULL, sizeof(SIM_SharedSegment_t), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mem == MAP_FAILED)
+        return NULL;
+
+    SIM_SharedSegment_t *segment = mem;
+
+    /* A freshly truncated object is all zeroes; the first mapper formats it. */
+    uint32_t expected = 0;
+    if (atomic_compare_exchange_strong(&segment->magic, &expected, SIM_FORMATTING))
+    {
+        segment->version = SIM_SHM_VERSION;
+        for (uint32_t i = 0; i < SIM_MAX_INSTANCES; i++)
+            SIM_ResetRegisters(&segment->slot[i]);
+        atomic_store(&segment->magic, SIM_SHM_MAGIC);
+    }
+
+    /* Another mapper may still be formatting. */
+    while (atomic_load(&segment->magic) != SIM_SHM_MAGIC)
+    {
+        if (atomic_load(&segment->magic) != SIM_FORMATTING)
+        {
+            munmap(mem, sizeof(SIM_SharedSegment_t));
+            return NULL;
+        }
+    }
+
+    if (segment->version != SIM_SHM_VERSION)
+    {
+        munmap(mem, sizeof(SIM_SharedSegment_t));
+        return NULL;
+    }
+
+    return segment;
+}
+
+void HAL_SIM_UnmapShared(SIM_SharedSegment_t *segment)
+{
+    if (segment != NULL)
+        munmap(segment, sizeof(SIM_SharedSegment_t));
+}
+
+void HAL_SIM_UnlinkShared(const char *name)
+{
+    shm_unlink(name);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          Firmware-side Functions                            */
+/* -------------------------------------------------------------------------- */
+
+bool HAL_SIM_AttachShared(const char *name, uint32_t slot)
+{
+    if (sim_segment != NULL)
+        return false;
+
+    SIM_SharedSegment_t *segment = HAL_SIM_MapShared(name, true);
+    if (segment == NULL)
+        return false;
+
+    SIM_RegisterFile_t *file = NULL;
+
+    if (slot == SIM_SLOT_ANY)
+    {
+        for (uint32_t i = 0; i < SIM_MAX_INSTANCES && file == NULL; i++)
+        {
+            if (SIM_ClaimSlot(&segment->slot[i]))
+                file = &segment->slot[i];
+        }
+    }
+    else if (slot < SIM_MAX_INSTANCES && SIM_ClaimSlot(&segment->slot[slot]))
+    {
+        file = &segment->slot[slot];
+    }
+
+    if (file == NULL)
+    {
+        HAL_SIM_UnmapShared(segment);
+        return false;
+    }
+
+    SIM_ResetRegisters(file);
+
+    sim_segment = segment;
+    sim_active = file;
+    HAL_I2C1_Regs = &file->i2c1;
+    HAL_I2C2_Regs = &file->i2c2;
+    HAL_UART1_Regs = &file->uart1;
+    return true;
+}
+
+void HAL_SIM_Detach(void)
+{
+    if (sim_segment == NULL)
+        return;
+
+    /* Give the device a chance to drain the last posted byte */
+    for (uint32_t spin = 0; spin < SIM_DETACH_DRAIN_SPINS; spin++)
+    {
+        if (!(atomic_load(&sim_active->doorbell[SIM_PERIPH_UART1].to_dev) & SIM_MBOX_FULL))
+            break;
+    }
+
+    atomic_fetch_and(&sim_active->flags, ~SIM_FLAG_CLAIMED);
+
+    HAL_I2C1_Regs = &sim_local.i2c1;
+    HAL_I2C2_Regs = &sim_local.i2c2;
+    HAL_UART1_Regs = &sim_local.uart1;
+    sim_active = &sim_local;
+
+    HAL_SIM_UnmapShared(sim_segment);
+    sim_segment = NULL;
+}
+
+SIM_RegisterFile_t *HAL_SIM_GetRegisterFile(void)
+{
+    return sim_active;
+}
+
+bool HAL_SIM_IsDeviceOnline(void)
+{
+    return (sim_active->flags & SIM_FLAG_DEVICE_ONLINE) != 0;
+}
+
+void HAL_SIM_RingDoorbell(SIM_Periph_t periph)
+{
+    atomic_fetch_add(&sim_active->doorbell[periph].ring, 1U);
+}
+
+bool HAL_SIM_Poll(bool flag_set)
+{
+    if (!flag_set && HAL_SIM_IsDeviceOnline())
+        sched_yield();
+
+    return flag_set;
+}
+
+void HAL_SIM_PostToDevice(SIM_Periph_t periph, uint8_t byte)
+{
+    atomic_store(&sim_active->doorbell[periph].to_dev, SIM_MBOX_FULL | byte);
+}
+
+bool HAL_SIM_TakeFromDevice(SIM_Periph_t periph, uint8_t *byte)
+{
+    uint32_t word = atomic_exchange(&sim_active->doorbell[periph].to_fw, 0U);
+    if (!(word & SIM_MBOX_FULL))
+        return false;
+
+    *byte = (uint8_t)word;
+    return true;
+}
+
+void HAL_REG_GetAccessStats(HAL_REG_AccessStats_t *stats)
+{
+    stats->reads = atomic_load(&hal_reg_reads);
+    stats->writes = atomic_load(&hal_reg_writes);
+}
+
+void HAL_REG_ResetAccessStats(void)
+{
+    atomic_store(&hal_reg_reads, 0);
+    atomic_store(&hal_reg_writes, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Device-side Functions                             */
+/* -------------------------------------------------------------------------- */
+
+bool HAL_SIM_PollDoorbell(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint32_t *seen)
+{
+    uint32_t ring = atomic_load(&file->doorbell[periph].ring);
+    if (ring == *seen)
+        return false;
+
+    *seen = ring;
+    return true;
+}
+
+void HAL_SIM_AckDoorbell(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint32_t seen)
+{
+    atomic_store(&file->doorbell[periph].ack, seen);
+}
+
+bool HAL_SIM_TakeFromFirmware(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint8_t *byte)
+{
+    uint32_t word = atomic_exchange(&file->doorbell[periph].to_dev, 0U);
+    if (!(word & SIM_MBOX_FULL))
+        return false;
+
+    *byte = (uint8_t)word;
+    return true;
+}
+
+bool HAL_SIM_PostToFirmware(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint8_t byte)
+{
+    uint32_t empty = 0;
+    return atomic_compare_exchange_strong(&file->doorbell[periph].to_fw, &empty,
+                                          SIM_MBOX_FULL | byte);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file hal_timer.c
+ * @brief Simulated free-running cycle counter.
+ *
+ * Emulates a cycle counter at HAL_TIMER_TICK_HZ from CLOCK_MONOTONIC plus an
+ * offset that HAL_TIMER_SimAdvance() can push forward.
+ *
+ * For real microcontrollers, enable DWT->CYCCNT once and return it here.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hal_timer.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+/* -------------------------------------------------------------------------- */
+/*                               Simulated State                               */
+/* -------------------------------------------------------------------------- */
+
+static _Atomic uint32_t timer_sim_offset;
+
+/* -------------------------------------------------------------------------- */
+/*                          Public API Implementations                         */
+/* -------------------------------------------------------------------------- */
+
+uint32_t HAL_TIMER_GetTicks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    uint64_t ticks = ns * (HAL_TIMER_TICK_HZ / 1000000U) / 1000U;
+
+    return (uint32_t)ticks + atomic_load_explicit(&timer_sim_offset, memory_order_relaxed);
+}
+
+uint32_t HAL_TIMER_TicksToNs(uint32_t ticks)
+{
+    uint64_t ns = (uint64_t)ticks * 1000000000ULL / HAL_TIMER_TICK_HZ;
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+void HAL_TIMER_SimAdvance(uint32_t ticks)
+{
+    atomic_fetch_add_explicit(&timer_sim_offset, ticks, memory_order_relaxed);
+}
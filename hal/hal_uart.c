@@ -7,26 +7,309 @@
  *   - UART TX ready state
  *   - UART RX ready state
  *   - DATA register behavior
- *   - Baudrate, stop-bit, parity configuration (stored but not functional)
+ *   - Baud-rate divisor (fractional, 16x/8x oversampling) and the rate it
+ *     actually achieves; stop-bit and parity configuration
+ *   - A remote peer that feeds RX data and honours RTS/CTS and XON/XOFF
+ *   - Frame timing on the wire (TC), 9-bit address frames with receiver
+ *     address matching, and the RS-485 driver-enable line
+ *
+ * When an external device simulator is online (hal_sim.h), transmitted bytes
+ * are posted to the device mailbox instead of stdout and received bytes are
+ * taken from the device mailbox into DATA.
+ *
+ * Bytes in both directions can be captured to a file, and a captured file
+ * can play the peer (hal_capture.h).
  *
  * For real embedded systems, replace the simulated registers with actual MCU
  * register accesses.
  */
 
 #include "hal_uart.h"
+#include "hal_sim.h"
+#include "hal_timer.h"
+#include "hal_capture.h"
 #include "board.h"
 #include "stdio.h"
 
+/* CTRL changes collected between HAL_UART_ConfigBegin() and _ConfigCommit() */
+static HAL_REG_Shadow_t uart_ctrl_shadow;
+
 /* -------------------------------------------------------------------------- */
-/*                      Simulated Peripheral Register Instance                 */
+/*                          Simulated Remote Peer State                        */
 /* -------------------------------------------------------------------------- */
 
-UART_Registers_t UART1 = {
-    .STATUS = UART_STATUS_TX_READY, /* TX ready at start */
-    .DATA = 0,
-    .CTRL = 0,
-    .BAUD = 115200
-};
+static uint16_t sim_fifo[HAL_UART_SIM_FIFO_SIZE];     /* Bit 8: address mark */
+static uint32_t sim_fifo_baud[HAL_UART_SIM_FIFO_SIZE];   /* Peer rate at send time */
+static uint32_t sim_fifo_head;            /* Next byte the peer will send */
+static uint32_t sim_fifo_count;
+static bool sim_peer_sw_flow;             /* Peer obeys our XON/XOFF */
+static bool sim_peer_xoff;                /* Peer received XOFF */
+static uint32_t sim_peer_skid;            /* Bytes still in flight after a stop */
+static HAL_UART_SimTxHook_t sim_tx_hook;
+static uint32_t sim_peer_baud;            /* 0: peer follows our rate */
+static uint32_t sim_link_max_baud;        /* 0: unlimited */
+static uint32_t sim_rx_error;             /* Error flags for the next byte */
+static bool sim_rx_muted;                 /* Address matching: not addressed */
+static bool sim_tx_active;                /* Frames still on the wire */
+static uint32_t sim_tx_done_at;           /* Tick the last queued frame completes */
+static uint32_t sim_de_asserted_at;
+static bool sim_de_first_frame;           /* Next frame is the first since DE rose */
+static HAL_UART_SimRs485Stats_t sim_rs485;
+static atomic_flag sim_peer_lock = ATOMIC_FLAG_INIT;
+
+/* The peer model and the transmitter timing are advanced by the driver's
+ * thread and by the interrupt controller's (hal_nvic.h, e.g. an XOFF sent
+ * from the RX handler); their state is only touched under this lock */
+static void HAL_UART_SimLock(void)
+{
+    while (atomic_flag_test_and_set_explicit(&sim_peer_lock, memory_order_acquire))
+        ;
+}
+
+static void HAL_UART_SimUnlock(void)
+{
+    atomic_flag_clear_explicit(&sim_peer_lock, memory_order_release);
+}
+
+/* Divisor limits in clock cycles per bit (see UART_BAUD_*) */
+#define UART_BIT_CLOCKS_MIN(over)   (over)
+#define UART_BIT_CLOCKS_MAX(over)   (UART_BAUD_MANT_MAX * (over) + (over) - 1U)
+
+static uint32_t HAL_UART_ClocksToBaud(uint32_t clocks)
+{
+    return (clocks != 0) ? (BOARD_UART_CLOCK_HZ + clocks / 2U) / clocks : 0;
+}
+
+/* Bit time in clock cycles of a BAUD value */
+static uint32_t HAL_UART_BitClocks(uint32_t baud_reg, bool over8)
+{
+    uint32_t mant = (baud_reg >> UART_BAUD_MANT_SHIFT) & UART_BAUD_MANT_MAX;
+
+    if (over8)
+        return mant * 8U + (baud_reg & 0x7U);
+
+    return mant * 16U + (baud_reg & UART_BAUD_FRAC_MASK);
+}
+
+static uint32_t HAL_UART_EncodeDivisor(uint32_t clocks, bool over8)
+{
+    uint32_t over = over8 ? 8U : 16U;
+
+    return ((clocks / over) << UART_BAUD_MANT_SHIFT) | (clocks % over);
+}
+
+static uint32_t HAL_UART_BaudError(uint32_t actual, uint32_t requested)
+{
+    return (actual > requested) ? (actual - requested) : (requested - actual);
+}
+
+/* Bit time closest to @p baudrate that oversampling @p over can set */
+static uint32_t HAL_UART_BestClocks(uint32_t baudrate, uint32_t over)
+{
+    uint32_t lo = BOARD_UART_CLOCK_HZ / baudrate;
+    uint32_t hi = lo + 1U;
+
+    if (lo < UART_BIT_CLOCKS_MIN(over))
+        lo = UART_BIT_CLOCKS_MIN(over);
+    if (lo > UART_BIT_CLOCKS_MAX(over))
+        lo = UART_BIT_CLOCKS_MAX(over);
+    if (hi < UART_BIT_CLOCKS_MIN(over))
+        hi = UART_BIT_CLOCKS_MIN(over);
+    if (hi > UART_BIT_CLOCKS_MAX(over))
+        hi = UART_BIT_CLOCKS_MAX(over);
+
+    /* Rounding the divisor is not rounding the rate: compare both */
+    if (HAL_UART_BaudError(HAL_UART_ClocksToBaud(hi), baudrate) <
+        HAL_UART_BaudError(HAL_UART_ClocksToBaud(lo), baudrate))
+        return hi;
+
+    return lo;
+}
+
+/* Rate our receiver and transmitter run at (model side, uncounted) */
+static uint32_t HAL_UART_SimOurBaud(void)
+{
+    return HAL_UART_ClocksToBaud(HAL_UART_BitClocks(UART1.BAUD, UART1.CTRL & UART_CTRL_OVER8));
+}
+
+static bool HAL_UART_SimPeerStopped(void)
+{
+    bool rts_low = (UART1.CTRL & UART_CTRL_HWFLOW) && !(UART1.CTRL & UART_CTRL_RTS);
+    return rts_low || sim_peer_xoff;
+}
+
+/* True if a byte sent by the peer at @p peer_baud (0: our rate) is corrupted */
+static bool HAL_UART_SimLinkGarbled(uint32_t peer_baud)
+{
+    uint32_t ours = HAL_UART_SimOurBaud();
+    uint32_t peer = (peer_baud != 0) ? peer_baud : ours;
+    uint32_t diff = (ours > peer) ? (ours - peer) : (peer - ours);
+
+    if ((uint64_t)diff * 100U > (uint64_t)ours * HAL_UART_SIM_BAUD_TOLERANCE_PCT)
+        return true;
+
+    return (sim_link_max_baud != 0 && ours > sim_link_max_baud);
+}
+
+/* Auto-baud: time the sync byte's start bit against the UART clock */
+static bool HAL_UART_SimMeasureBaud(uint8_t byte, uint32_t peer_baud)
+{
+    uint32_t peer = (peer_baud != 0) ? peer_baud : HAL_UART_SimOurBaud();
+
+    UART1.CTRL &= ~UART_CTRL_ABREN;
+
+    /* Start bit + first data bit must form a single low pulse */
+    if (!(byte & 0x01U) || peer == 0)
+    {
+        UART1.STATUS |= UART_STATUS_ABRE;
+        return false;
+    }
+
+    /* The pulse is counted in clock cycles and becomes the divisor */
+    uint32_t clocks = (BOARD_UART_CLOCK_HZ + peer / 2U) / peer;
+    bool over8 = clocks < UART_BIT_CLOCKS_MIN(16U);
+
+    if (clocks < UART_BIT_CLOCKS_MIN(8U) || clocks > UART_BIT_CLOCKS_MAX(16U))
+    {
+        UART1.STATUS |= UART_STATUS_ABRE;
+        return false;
+    }
+
+    UART1.BAUD = HAL_UART_EncodeDivisor(clocks, over8);
+    if (over8)
+        UART1.CTRL |= UART_CTRL_OVER8;
+    else
+        UART1.CTRL &= ~UART_CTRL_OVER8;
+    UART1.STATUS |= UART_STATUS_ABRF;
+    return true;
+}
+
+/* Wire time of one frame: start + data (+ parity) + stop bits */
+static uint32_t HAL_UART_SimFrameTicks(void)
+{
+    uint32_t ctrl = UART1.CTRL;
+    uint32_t bits = 1U + ((ctrl & UART_CTRL_M9) ? 9U : 8U) + ((ctrl & UART_CTRL_STOP_2) ? 2U : 1U);
+
+    if (ctrl & (UART_CTRL_PARITY_EVEN | UART_CTRL_PARITY_ODD))
+        bits++;
+
+    uint32_t baud = HAL_UART_SimOurBaud();
+
+    if (baud == 0)
+        baud = 1U;
+    return (uint32_t)(((uint64_t)HAL_TIMER_TICK_HZ * bits + baud - 1U) / baud);
+}
+
+/* Put one frame on the wire behind the frames still being shifted out */
+static void HAL_UART_SimTransmit(void)
+{
+    uint32_t frame_ticks = HAL_UART_SimFrameTicks();
+
+    HAL_UART_SimLock();
+
+    uint32_t now = HAL_TIMER_GetTicks();
+    uint32_t start = (sim_tx_active && (int32_t)(sim_tx_done_at - now) > 0) ? sim_tx_done_at : now;
+
+    if (sim_de_first_frame)
+    {
+        sim_de_first_frame = false;
+        sim_rs485.de_lead_ticks = start - sim_de_asserted_at;
+    }
+
+    sim_tx_done_at = start + frame_ticks;
+    sim_tx_active = true;
+    UART1.STATUS &= ~UART_STATUS_TC;
+    HAL_UART_SimUnlock();
+}
+
+/* Address matching: consume address frames, drop frames while muted */
+static bool HAL_UART_SimFiltered(uint16_t frame)
+{
+    if (!(UART1.CTRL & UART_CTRL_MME))
+        return false;
+
+    if (frame & UART_DATA_ADDR_MARK)
+    {
+        uint8_t own = (uint8_t)((UART1.CTRL & UART_CTRL_ADD_MASK) >> UART_CTRL_ADD_SHIFT);
+        sim_rx_muted = ((uint8_t)frame != own);
+        if (sim_rx_muted)
+            sim_rs485.muted_frames++;
+        return true;
+    }
+
+    if (sim_rx_muted)
+        sim_rs485.muted_frames++;
+    return sim_rx_muted;
+}
+
+/* Deliver the peer's next byte into DATA if the wire is allowed to carry it */
+static void HAL_UART_SimDeliverLocked(void)
+{
+    /* Half duplex: the receiver is off while we drive the bus */
+    if (UART1.CTRL & UART_CTRL_DE)
+        return;
+
+    /* Frames the receiver filters never raise RX_READY */
+    while (sim_fifo_count != 0 && !HAL_UART_SimPeerStopped() &&
+           HAL_UART_SimFiltered(sim_fifo[sim_fifo_head]))
+    {
+        sim_fifo_head = (sim_fifo_head + 1U) % HAL_UART_SIM_FIFO_SIZE;
+        sim_fifo_count--;
+    }
+
+    if (sim_fifo_count == 0 || (UART1.STATUS & UART_STATUS_RX_READY))
+        return;
+
+    if (HAL_UART_SimPeerStopped())
+    {
+        if (sim_peer_skid == 0)
+            return;
+        sim_peer_skid--;
+    }
+
+    uint16_t frame = sim_fifo[sim_fifo_head];
+    uint8_t byte = (uint8_t)frame;
+    uint32_t peer_baud = sim_fifo_baud[sim_fifo_head];
+    sim_fifo_head = (sim_fifo_head + 1U) % HAL_UART_SIM_FIFO_SIZE;
+    sim_fifo_count--;
+
+    bool garbled;
+    if (UART1.CTRL & UART_CTRL_ABREN)
+        garbled = !HAL_UART_SimMeasureBaud(byte, peer_baud);
+    else
+        garbled = HAL_UART_SimLinkGarbled(peer_baud);
+
+    UART1.DATA = (UART1.CTRL & UART_CTRL_M9) ? frame : byte;
+    HAL_CAPTURE_Record(HAL_CAPTURE_UART_RX, byte);
+    if (garbled)
+        UART1.STATUS |= UART_STATUS_FE;
+    UART1.STATUS |= sim_rx_error | UART_STATUS_RX_READY;
+    sim_rx_error = 0;
+}
+
+static void HAL_UART_SimDeliver(void)
+{
+    HAL_UART_SimLock();
+    HAL_UART_SimDeliverLocked();
+    HAL_UART_SimUnlock();
+}
+
+/* Latch the next byte from an external device, if one is waiting */
+static void HAL_UART_SimTakeFromDevice(void)
+{
+    uint8_t byte;
+
+    HAL_UART_SimLock();
+    if (!(UART1.STATUS & UART_STATUS_RX_READY) &&
+        HAL_SIM_TakeFromDevice(SIM_PERIPH_UART1, &byte))
+    {
+        UART1.DATA = byte;
+        UART1.STATUS |= UART_STATUS_RX_READY;
+        HAL_CAPTURE_Record(HAL_CAPTURE_UART_RX, byte);
+        HAL_SIM_RingDoorbell(SIM_PERIPH_UART1);
+    }
+    HAL_UART_SimUnlock();
+}
 
 /* -------------------------------------------------------------------------- */
 /*                           Clock & Pin Configuration                         */
@@ -48,30 +331,196 @@ void HAL_UART_ConfigurePins(void)
 
 void HAL_UART_Enable(void)
 {
-    UART1.CTRL |= UART_CTRL_ENABLE;
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, 0, UART_CTRL_ENABLE);
+}
+
+void HAL_UART_ComputeBaud(uint32_t baudrate, HAL_UART_BaudDivisor_t *div)
+{
+    if (baudrate == 0)
+        baudrate = 1U;
+
+    uint32_t clocks16 = HAL_UART_BestClocks(baudrate, 16U);
+    uint32_t clocks8 = HAL_UART_BestClocks(baudrate, 8U);
+    uint32_t error16 = HAL_UART_BaudError(HAL_UART_ClocksToBaud(clocks16), baudrate);
+    uint32_t error8 = HAL_UART_BaudError(HAL_UART_ClocksToBaud(clocks8), baudrate);
+
+    div->over8 = error8 < error16;
+
+    uint32_t clocks = div->over8 ? clocks8 : clocks16;
+
+    div->divisor = HAL_UART_EncodeDivisor(clocks, div->over8);
+    div->actual = HAL_UART_ClocksToBaud(clocks);
+    div->error_ppm = (int32_t)(((int64_t)div->actual - (int64_t)baudrate) * 1000000 /
+                               (int64_t)baudrate);
+}
+
+void HAL_UART_SetBaudDivisor(const HAL_UART_BaudDivisor_t *div)
+{
+    HAL_REG_Write(&UART1.BAUD, div->divisor);
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_OVER8,
+                         div->over8 ? UART_CTRL_OVER8 : 0);
 }
 
 void HAL_UART_SetBaudrate(uint32_t baudrate)
 {
-    UART1.BAUD = baudrate;
+    HAL_UART_BaudDivisor_t div;
+
+    HAL_UART_ComputeBaud(baudrate, &div);
+    HAL_UART_SetBaudDivisor(&div);
+}
+
+uint32_t HAL_UART_GetBaudrate(void)
+{
+    uint32_t baud_reg = HAL_REG_Read(&UART1.BAUD);
+    bool over8 = HAL_REG_ShadowRead(&uart_ctrl_shadow, &UART1.CTRL) & UART_CTRL_OVER8;
+
+    return HAL_UART_ClocksToBaud(HAL_UART_BitClocks(baud_reg, over8));
 }
 
 void HAL_UART_SetParity(uint32_t parity)
 {
-    UART1.CTRL &= ~(UART_CTRL_PARITY_EVEN | UART_CTRL_PARITY_ODD);
+    uint32_t set = 0;
 
     if (parity == 1)
-        UART1.CTRL |= UART_CTRL_PARITY_EVEN;
+        set = UART_CTRL_PARITY_EVEN;
     else if (parity == 2)
-        UART1.CTRL |= UART_CTRL_PARITY_ODD;
+        set = UART_CTRL_PARITY_ODD;
+
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_PARITY_EVEN | UART_CTRL_PARITY_ODD, set);
 }
 
 void HAL_UART_SetStopBits(uint32_t stop_bits)
 {
-    if (stop_bits == 2)
-        UART1.CTRL |= UART_CTRL_STOP_2;
-    else
-        UART1.CTRL &= ~UART_CTRL_STOP_2;
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_STOP_2, (stop_bits == 2) ? UART_CTRL_STOP_2 : 0);
+}
+
+void HAL_UART_SetHwFlowControl(bool enable)
+{
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_HWFLOW, enable ? UART_CTRL_HWFLOW : 0);
+}
+
+void HAL_UART_ConfigBegin(void)
+{
+    HAL_REG_ShadowBegin(&uart_ctrl_shadow, &UART1.CTRL);
+}
+
+void HAL_UART_ConfigCommit(void)
+{
+    if (HAL_REG_ShadowCommit(&uart_ctrl_shadow))
+        HAL_SIM_RingDoorbell(SIM_PERIPH_UART1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              RS-485 Multidrop                               */
+/* -------------------------------------------------------------------------- */
+
+void HAL_UART_SetDataBits9(bool enable)
+{
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_M9, enable ? UART_CTRL_M9 : 0);
+}
+
+void HAL_UART_SetAddressMatch(bool enable, uint8_t address)
+{
+    uint32_t set = (uint32_t)address << UART_CTRL_ADD_SHIFT;
+
+    if (enable)
+        set |= UART_CTRL_MME;
+
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_MME | UART_CTRL_ADD_MASK, set);
+
+    /* Muted until the first address frame for us */
+    sim_rx_muted = enable;
+}
+
+void HAL_UART_SetDriverEnable(bool asserted)
+{
+    bool de = (HAL_REG_ShadowRead(&uart_ctrl_shadow, &UART1.CTRL) & UART_CTRL_DE) != 0;
+
+    HAL_UART_SimLock();
+    if (asserted && !de)
+    {
+        HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, 0, UART_CTRL_DE);
+        sim_de_asserted_at = HAL_TIMER_GetTicks();
+        sim_de_first_frame = true;
+    }
+    else if (!asserted && de)
+    {
+        HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_DE, 0);
+        if (!sim_de_first_frame)
+            sim_rs485.de_lag_ticks = HAL_TIMER_GetTicks() - sim_tx_done_at;
+    }
+    HAL_UART_SimUnlock();
+
+    HAL_SIM_RingDoorbell(SIM_PERIPH_UART1);
+}
+
+bool HAL_UART_IsTxComplete(void)
+{
+    if (HAL_SIM_IsDeviceOnline())
+        return HAL_SIM_Poll(HAL_REG_Read(&UART1.STATUS) & UART_STATUS_TX_READY);
+
+    HAL_UART_SimLock();
+    if (sim_tx_active && (int32_t)(HAL_TIMER_GetTicks() - sim_tx_done_at) >= 0)
+    {
+        sim_tx_active = false;
+        UART1.STATUS |= UART_STATUS_TC;
+    }
+
+    bool complete = !sim_tx_active;
+    HAL_UART_SimUnlock();
+    return complete;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                            Flow Control Lines                               */
+/* -------------------------------------------------------------------------- */
+
+void HAL_UART_SetRTS(bool asserted)
+{
+    if (asserted)
+    {
+        HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, 0, UART_CTRL_RTS);
+    }
+    else if (HAL_REG_ShadowRead(&uart_ctrl_shadow, &UART1.CTRL) & UART_CTRL_RTS)
+    {
+        HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_RTS, 0);
+        HAL_UART_SimLock();
+        sim_peer_skid = HAL_UART_SIM_RTS_SKID;
+        HAL_UART_SimUnlock();
+    }
+
+    HAL_SIM_RingDoorbell(SIM_PERIPH_UART1);
+}
+
+bool HAL_UART_IsCTSAsserted(void)
+{
+    return (HAL_REG_Read(&UART1.STATUS) & UART_STATUS_CTS);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                            Auto-baud Detection                              */
+/* -------------------------------------------------------------------------- */
+
+void HAL_UART_StartAutoBaud(void)
+{
+    HAL_REG_Modify(&UART1.STATUS, UART_STATUS_ABRF | UART_STATUS_ABRE, 0);
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, 0, UART_CTRL_ABREN);
+}
+
+bool HAL_UART_IsAutoBaudDone(void)
+{
+    HAL_UART_SimDeliver();
+    return (HAL_REG_Read(&UART1.STATUS) & (UART_STATUS_ABRF | UART_STATUS_ABRE));
+}
+
+void HAL_UART_CancelAutoBaud(void)
+{
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_ABREN, 0);
+}
+
+bool HAL_UART_IsAutoBaudError(void)
+{
+    return (HAL_REG_Read(&UART1.STATUS) & UART_STATUS_ABRE);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -80,16 +529,78 @@ void HAL_UART_SetStopBits(uint32_t stop_bits)
 
 void HAL_UART_SendByte(uint8_t byte)
 {
-    UART1.DATA = byte;
-    putchar(byte);
-    fflush(stdout);
+    HAL_CAPTURE_Record(HAL_CAPTURE_UART_TX, byte);
+
+    if (HAL_SIM_IsDeviceOnline())
+    {
+        /* Device takes the byte from its mailbox and sets TX_READY again */
+        UART1.STATUS &= ~UART_STATUS_TX_READY;
+        HAL_REG_Write(&UART1.DATA, byte);
+        HAL_SIM_PostToDevice(SIM_PERIPH_UART1, byte);
+        HAL_SIM_RingDoorbell(SIM_PERIPH_UART1);
+        return;
+    }
+
+    HAL_REG_Write(&UART1.DATA, byte);
+    HAL_UART_SimTransmit();
+
+    HAL_UART_SimLock();
+    if (sim_peer_sw_flow && byte == HAL_UART_SIM_XOFF)
+    {
+        sim_peer_xoff = true;
+        sim_peer_skid = HAL_UART_SIM_XOFF_SKID;
+    }
+    else if (sim_peer_sw_flow && byte == HAL_UART_SIM_XON)
+    {
+        sim_peer_xoff = false;
+    }
+    HAL_UART_SimUnlock();
+
+    if (sim_tx_hook != NULL)
+    {
+        sim_tx_hook(byte, HAL_UART_SimLinkGarbled(sim_peer_baud));
+    }
+    else
+    {
+        putchar(byte);
+        fflush(stdout);
+    }
+
+    UART1.STATUS |= UART_STATUS_TX_READY;
+}
+
+void HAL_UART_SendAddress(uint8_t address)
+{
+    if (HAL_SIM_IsDeviceOnline())
+    {
+        /* The mailbox carries 8 bits; the device sees the address as data */
+        HAL_UART_SendByte(address);
+        return;
+    }
+
+    HAL_REG_Write(&UART1.DATA, UART_DATA_ADDR_MARK | address);
+    HAL_UART_SimTransmit();
+    HAL_UART_SimLock();
+    sim_rs485.address_frames_sent++;
+    sim_rs485.last_address_sent = address;
+    HAL_UART_SimUnlock();
+
+    if (sim_tx_hook != NULL)
+        sim_tx_hook(address, HAL_UART_SimLinkGarbled(sim_peer_baud));
+
     UART1.STATUS |= UART_STATUS_TX_READY;
 }
 
+bool HAL_UART_IsAddressFrame(void)
+{
+    return (HAL_REG_ShadowRead(&uart_ctrl_shadow, &UART1.CTRL) & UART_CTRL_M9) &&
+           (HAL_REG_Read(&UART1.DATA) & UART_DATA_ADDR_MARK);
+}
+
 uint8_t HAL_UART_ReadByte(void)
 {
-    UART1.STATUS &= ~UART_STATUS_RX_READY; /* Clear flag */
-    return (uint8_t)UART1.DATA;
+    UART1.STATUS &= ~(UART_STATUS_RX_READY | UART_STATUS_RX_ERRORS); /* Clear flags */
+    return (uint8_t)HAL_REG_Read(&UART1.DATA);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -98,12 +609,159 @@ uint8_t HAL_UART_ReadByte(void)
 
 bool HAL_UART_IsTxReady(void)
 {
-    /* Always ready in simulation */
-    return (UART1.STATUS & UART_STATUS_TX_READY);
+    /* Always ready in simulation, unless CTS holds the transmitter off */
+    uint32_t status = HAL_REG_Read(&UART1.STATUS);
+    bool cts_ok = !(HAL_REG_ShadowRead(&uart_ctrl_shadow, &UART1.CTRL) & UART_CTRL_HWFLOW) ||
+                  (status & UART_STATUS_CTS);
+    return HAL_SIM_Poll((status & UART_STATUS_TX_READY) && cts_ok);
 }
 
 bool HAL_UART_IsRxReady(void)
 {
+    HAL_UART_SimTakeFromDevice();
+    HAL_CAPTURE_ReplayUart();
+    HAL_UART_SimDeliver();
+
     /* Simulate RX ready by manually toggling in tests or main loop */
-    return (UART1.STATUS & UART_STATUS_RX_READY);
+    return (HAL_REG_Read(&UART1.STATUS) & UART_STATUS_RX_READY);
+}
+
+uint32_t HAL_UART_GetRxErrors(void)
+{
+    return HAL_REG_Read(&UART1.STATUS) & UART_STATUS_RX_ERRORS;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Interrupts                                  */
+/* -------------------------------------------------------------------------- */
+
+void HAL_UART_SetRxInterrupt(bool enable)
+{
+    HAL_REG_ShadowModify(&uart_ctrl_shadow, &UART1.CTRL, UART_CTRL_RXNEIE,
+                         enable ? UART_CTRL_RXNEIE : 0);
+}
+
+bool HAL_UART_SimIrqLevel(void)
+{
+    if (!(UART1.CTRL & UART_CTRL_RXNEIE))
+        return false;
+
+    /* The receiver runs on its own; no driver call needed */
+    HAL_UART_SimTakeFromDevice();
+    HAL_UART_SimDeliver();
+
+    return (UART1.STATUS & UART_STATUS_RX_READY) != 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Simulated Remote Peer                             */
+/* -------------------------------------------------------------------------- */
+
+uint32_t HAL_UART_SimFeed(const uint8_t *data, uint32_t len)
+{
+    uint32_t queued = 0;
+
+    HAL_UART_SimLock();
+    while (queued < len && sim_fifo_count < HAL_UART_SIM_FIFO_SIZE)
+    {
+        uint32_t tail = (sim_fifo_head + sim_fifo_count) % HAL_UART_SIM_FIFO_SIZE;
+        sim_fifo[tail] = data[queued++];
+        sim_fifo_baud[tail] = sim_peer_baud;
+        sim_fifo_count++;
+    }
+    HAL_UART_SimUnlock();
+
+    return queued;
+}
+
+uint32_t HAL_UART_SimPending(void)
+{
+    HAL_UART_SimLock();
+    uint32_t pending = sim_fifo_count;
+    HAL_UART_SimUnlock();
+
+    return pending;
+}
+
+void HAL_UART_SimReset(void)
+{
+    HAL_UART_SimLock();
+    sim_fifo_head = 0;
+    sim_fifo_count = 0;
+    sim_peer_sw_flow = false;
+    sim_peer_xoff = false;
+    sim_peer_skid = 0;
+    sim_tx_hook = NULL;
+    sim_peer_baud = 0;
+    sim_link_max_baud = 0;
+    sim_rx_error = 0;
+    sim_rx_muted = (UART1.CTRL & UART_CTRL_MME) != 0;
+    sim_tx_active = false;
+    sim_de_first_frame = false;
+    sim_rs485 = (HAL_UART_SimRs485Stats_t){ 0 };
+    HAL_UART_SimUnlock();
+}
+
+void HAL_UART_SimSetCTS(bool asserted)
+{
+    if (asserted)
+        UART1.STATUS |= UART_STATUS_CTS;
+    else
+        UART1.STATUS &= ~UART_STATUS_CTS;
+}
+
+void HAL_UART_SimSetPeerSwFlow(bool enable)
+{
+    HAL_UART_SimLock();
+    sim_peer_sw_flow = enable;
+    sim_peer_xoff = false;
+    HAL_UART_SimUnlock();
+}
+
+void HAL_UART_SimSetTxHook(HAL_UART_SimTxHook_t hook)
+{
+    sim_tx_hook = hook;
+}
+
+void HAL_UART_SimSetPeerBaud(uint32_t baudrate)
+{
+    sim_peer_baud = baudrate;
+}
+
+void HAL_UART_SimSetLinkMaxBaud(uint32_t baudrate)
+{
+    sim_link_max_baud = baudrate;
+}
+
+void HAL_UART_SimInjectRxError(uint32_t status_bits)
+{
+    HAL_UART_SimLock();
+    sim_rx_error = status_bits & (UART_STATUS_PE | UART_STATUS_ORE);
+    HAL_UART_SimUnlock();
+}
+
+bool HAL_UART_SimFeedAddress(uint8_t address)
+{
+    uint16_t frame = UART_DATA_ADDR_MARK | address;
+    bool queued = false;
+
+    HAL_UART_SimLock();
+    if (sim_fifo_count < HAL_UART_SIM_FIFO_SIZE)
+    {
+        uint32_t tail = (sim_fifo_head + sim_fifo_count) % HAL_UART_SIM_FIFO_SIZE;
+        sim_fifo[tail] = frame;
+        sim_fifo_baud[tail] = sim_peer_baud;
+        sim_fifo_count++;
+        queued = true;
+    }
+    HAL_UART_SimUnlock();
+
+    return queued;
+}
+
+void HAL_UART_SimGetRs485Stats(HAL_UART_SimRs485Stats_t *stats)
+{
+    HAL_UART_SimLock();
+    *stats = sim_rs485;
+    HAL_UART_SimUnlock();
 }
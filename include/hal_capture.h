@@ -0,0 +1,142 @@
+/**
+ * @file hal_capture.h
+ * @brief Capture and replay of simulated bus traffic (host builds only).
+ *
+ * Capture appends every UART byte and every I2C bus event seen by the
+ * simulated HAL to a binary file, each stamped with the HAL timer. Replay
+ * memory-maps such a file and plays the peripheral side back to the
+ * drivers, so benchmarks and regression tests can run on recorded traffic
+ * instead of hand-poked registers:
+ *
+ *  - UART RX bytes are fed to the simulated peer (HAL_UART_SimFeed) when
+ *    their recorded time comes up, scaled by the replay speed (0: as fast
+ *    as the RX path accepts them). Nothing is dropped: if the peer FIFO is
+ *    full, replay waits.
+ *  - I2C responses are handed out on demand, in order: each address or
+ *    write byte the firmware sends takes the next recorded one and its
+ *    ACK/NACK, each byte the receiver clocks in takes the next recorded
+ *    read byte. Bytes the firmware sends that differ from the recording are
+ *    counted as mismatches.
+ *
+ * The file is only read through the mapping, front to back, so captures of
+ * any size replay without being loaded or copied.
+ *
+ * File format (little-endian):
+ *   header:  "BCAP" magic, u16 version, u16 reserved, u32 tick rate (Hz),
+ *            u32 reserved
+ *   record:  u8 event type, LEB128 varint ticks since the previous record,
+ *            then one data byte for events that carry one
+ * Each HAL_CAPTURE_Start() begins with a MARK record; replay restarts its
+ * time base there, so separately appended sessions do not wait for the
+ * gap between them. Gaps of 2^32 ticks or more inside a session are not
+ * representable (about 89 s at 48 MHz).
+ */
+
+#ifndef HAL_CAPTURE_H
+#define HAL_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define HAL_CAPTURE_MAGIC     0x50414342U   /* "BCAP" */
+#define HAL_CAPTURE_VERSION   1U
+
+typedef enum
+{
+    HAL_CAPTURE_MARK = 0,       /* Session start (no data) */
+    HAL_CAPTURE_UART_RX,        /* Byte received by the firmware */
+    HAL_CAPTURE_UART_TX,        /* Byte sent by the firmware */
+    HAL_CAPTURE_I2C_START,      /* (Repeated) START (no data) */
+    HAL_CAPTURE_I2C_STOP,       /* STOP (no data) */
+    HAL_CAPTURE_I2C_ADDR,       /* Address byte: addr << 1 | R/W */
+    HAL_CAPTURE_I2C_TX,         /* Byte written by the firmware */
+    HAL_CAPTURE_I2C_RX,         /* Byte read from the slave */
+    HAL_CAPTURE_I2C_NACK,       /* Previous ADDR/TX byte was NACKed (no data) */
+    HAL_CAPTURE_EVENT_COUNT
+} HAL_CAPTURE_Event_t;
+
+typedef struct
+{
+    uint64_t records_written;
+    uint64_t bytes_written;      /**< File bytes appended, headers included */
+    uint64_t uart_fed;           /**< UART bytes handed to the simulated peer */
+    uint64_t i2c_read;           /**< I2C bytes supplied to the receiver */
+    uint64_t i2c_nacks;          /**< NACKs replayed */
+    uint64_t i2c_mismatches;     /**< Firmware bytes that differ from the capture */
+    bool replay_done;            /**< All UART input and I2C responses used up */
+} HAL_CAPTURE_Stats_t;
+
+/* -------------------------------------------------------------------------- */
+/*                       HAL Function Prototypes (Public API)                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Start appending traffic to @p path (created with a header if new).
+ *
+ * @return false if the file cannot be opened or is not a capture file
+ */
+bool HAL_CAPTURE_Start(const char *path);
+
+/**
+ * @brief Flush and close the capture file.
+ */
+void HAL_CAPTURE_Stop(void);
+
+/**
+ * @brief Map @p path and start replaying it.
+ *
+ * @param path  Capture file
+ * @param speed Time scale: 1 = original timing, N = N times faster,
+ *              0 = no timing (UART input as fast as it is accepted)
+ * @return false if the file cannot be mapped or has a bad header
+ */
+bool HAL_CAPTURE_Replay(const char *path, uint32_t speed);
+
+/**
+ * @brief Stop replaying and unmap the file.
+ */
+void HAL_CAPTURE_ReplayStop(void);
+
+bool HAL_CAPTURE_IsReplaying(void);
+
+/**
+ * @brief Copy the capture/replay counters (reset by Start and Replay).
+ */
+void HAL_CAPTURE_GetStats(HAL_CAPTURE_Stats_t *stats);
+
+/* Simulated HAL hooks -------------------------------------------------------- */
+
+/**
+ * @brief Append one event if a capture is running.
+ *
+ * @param data Event byte (ignored for events without data)
+ */
+void HAL_CAPTURE_Record(HAL_CAPTURE_Event_t type, uint8_t data);
+
+/**
+ * @brief Feed the UART RX bytes that are due to the simulated peer.
+ */
+void HAL_CAPTURE_ReplayUart(void);
+
+/**
+ * @brief Match a byte the firmware put on the I2C bus against the capture.
+ *
+ * @param type HAL_CAPTURE_I2C_ADDR or HAL_CAPTURE_I2C_TX
+ * @param sent Byte sent
+ * @return true if the recorded byte was NACKed
+ */
+bool HAL_CAPTURE_ReplayI2CWrite(HAL_CAPTURE_Event_t type, uint8_t sent);
+
+/**
+ * @brief Next recorded I2C read byte.
+ *
+ * @return false if the recorded read has no more bytes (or the capture is
+ *         used up); the simulated slave then sends its default data
+ */
+bool HAL_CAPTURE_ReplayI2CRead(uint8_t *data);
+
+#endif /* HAL_CAPTURE_H */
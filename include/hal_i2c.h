@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "hal_reg.h"
 #include "../drivers/i2c.h"  /* For I2C_Direction_t */
 
 /* -------------------------------------------------------------------------- */
@@ -27,32 +28,59 @@
  *  - SR:   status register (flags for busy, TXE, RXNE, ADDR)
  *  - DR:   data register
  *  - CCR:  clock control (speed)
+ *  - OAR:  own address (target mode)
+ *
+ * The receiver is double-buffered like most MCU I2C controllers: while DR
+ * holds byte k, byte k+1 is clocked into the shift register. ACK is sampled
+ * when a byte completes (with POS set: when the byte before it completes; the
+ * first byte after the address is then always ACKed). When DR and the shift
+ * register are both full, BTF is set and SCL is held low until DR is read.
+ * After a read address phase SCL is also held until HAL_I2C_ClearAddress(),
+ * so ACK/POS/STOP for short reads can be armed before any byte moves.
+ *
+ * I2C1 is the controller. I2C2 is a target on the same bus: with OAR_EN
+ * set it answers to the address in OAR. On a target ADDR means "address
+ * matched" and TRA tells which way the data goes.
  *
  * Replace these with actual MCU register mappings for real hardware.
  */
 
 typedef struct
 {
-    volatile uint32_t CR;
-    volatile uint32_t SR;
-    volatile uint32_t DR;
-    volatile uint32_t CCR;
+    volatile SIM_Reg32_t CR;
+    volatile SIM_Reg32_t SR;
+    volatile SIM_Reg32_t DR;
+    volatile SIM_Reg32_t CCR;
+    volatile SIM_Reg32_t OAR;
 } I2C_Registers_t;
 
-/* Simulated peripheral instance */
-extern I2C_Registers_t I2C1;
+/* Simulated peripheral instances (live in the active register file, see hal_sim.h) */
+extern I2C_Registers_t *HAL_I2C1_Regs;
+extern I2C_Registers_t *HAL_I2C2_Regs;
+#define I2C1  (*HAL_I2C1_Regs)
+#define I2C2  (*HAL_I2C2_Regs)
 
 /* Control register bit masks */
 #define I2C_CR_ENABLE      (1U << 0)
 #define I2C_CR_START       (1U << 1)
 #define I2C_CR_STOP        (1U << 2)
 #define I2C_CR_ACK         (1U << 3)
+#define I2C_CR_SWRST       (1U << 4)   /* Peripheral software reset */
+#define I2C_CR_POS         (1U << 5)   /* ACK applies to the next byte, not the one shifting in */
 
 /* Status register bit masks */
 #define I2C_SR_BUSY        (1U << 0)
 #define I2C_SR_TXE         (1U << 1)   /* Transmit buffer empty */
 #define I2C_SR_RXNE        (1U << 2)   /* Receive buffer not empty */
 #define I2C_SR_ADDR        (1U << 3)   /* Address sent/matched */
+#define I2C_SR_AF          (1U << 4)   /* Acknowledge failure (NACK received) */
+#define I2C_SR_BTF         (1U << 5)   /* Byte transfer finished: DR and shift register full */
+#define I2C_SR_TRA         (1U << 6)   /* Target: the controller is reading */
+#define I2C_SR_STOPF       (1U << 7)   /* Target: STOP detected after being addressed */
+
+/* Own address register */
+#define I2C_OAR_ADDR_MASK  0x7FU       /* 7-bit own address */
+#define I2C_OAR_EN         (1U << 15)  /* Respond to the own address */
 
 /* -------------------------------------------------------------------------- */
 /*                       HAL Function Prototypes (Public API)                 */
@@ -74,12 +102,23 @@ void HAL_I2C_GenerateStart(void);
 void HAL_I2C_GenerateStop(void);
 void HAL_I2C_SendACK(void);
 void HAL_I2C_SendNACK(void);
+void HAL_I2C_SetAckPosition(bool next);   /* POS bit */
+
+/**
+ * Between HAL_I2C_ControlBegin() and HAL_I2C_ControlCommit() the CR
+ * operations above (and HAL_I2C_Enable) only update a shadow copy of CR;
+ * the commit writes CR once. Use it for changes that must all be in place
+ * before the bus moves again, e.g. NACK + POS while SCL is held after ADDR.
+ */
+void HAL_I2C_ControlBegin(void);
+void HAL_I2C_ControlCommit(void);
 
 /* Address & data operations ------------------------------------------------- */
 
 void HAL_I2C_SendAddress(uint8_t address, I2C_Direction_t direction);
 void HAL_I2C_SendData(uint8_t data);
 uint8_t HAL_I2C_ReadData(void);
+void HAL_I2C_ClearAddress(void);          /* Release SCL after ADDR (read SR1, SR2) */
 
 /* Status checks ------------------------------------------------------------- */
 
@@ -87,5 +126,118 @@ bool HAL_I2C_IsStartGenerated(void);
 bool HAL_I2C_IsAddressSent(void);
 bool HAL_I2C_IsTxComplete(void);
 bool HAL_I2C_IsRxReady(void);
+bool HAL_I2C_IsByteTransferFinished(void);
+bool HAL_I2C_IsAckFailure(void);
+void HAL_I2C_ClearAckFailure(void);
+
+/* Target mode (I2C2) ------------------------------------------------------- */
+
+/**
+ * The target raises its event interrupt for one event at a time:
+ *  - ADDR (+ TRA): addressed; clear it with HAL_I2C_TargetClearAddress()
+ *  - RXNE: the controller wrote a byte; HAL_I2C_TargetReadData() takes it
+ *  - TXE: DR is free, at the address phase of a read and whenever a byte
+ *    moves to the shift register; HAL_I2C_TargetWriteData() supplies the
+ *    next byte before the handler returns (or the bus sees 0xFF)
+ *  - AF: the controller NACKed the last byte it read (end of read); the
+ *    byte preloaded behind it is never sent
+ *  - STOPF: the transaction is over; clear it with HAL_I2C_TargetClearStop()
+ *
+ * The ACK bit (HAL_I2C_TargetSetAck) decides whether the next byte the
+ * controller writes is accepted.
+ */
+
+void HAL_I2C_TargetEnable(uint8_t own_address);
+void HAL_I2C_TargetDisable(void);
+void HAL_I2C_TargetSetAck(bool ack);
+bool HAL_I2C_TargetIsAddressed(void);
+bool HAL_I2C_TargetIsTransmitter(void);
+void HAL_I2C_TargetClearAddress(void);
+bool HAL_I2C_TargetIsRxReady(void);
+uint8_t HAL_I2C_TargetReadData(void);
+bool HAL_I2C_TargetIsTxEmpty(void);
+void HAL_I2C_TargetWriteData(uint8_t data);
+bool HAL_I2C_TargetIsNacked(void);
+void HAL_I2C_TargetClearNack(void);
+bool HAL_I2C_TargetIsStopDetected(void);
+void HAL_I2C_TargetClearStop(void);
+
+/* Bus line state & recovery ------------------------------------------------- */
+
+/**
+ * Bus recovery drives the pins directly: on real hardware
+ * HAL_I2C_RecoveryBegin() switches SCL/SDA to open-drain GPIO and
+ * HAL_I2C_RecoveryEnd() hands them back to the peripheral.
+ */
+
+bool HAL_I2C_IsSDALow(void);           /* SDA held low (by a slave) */
+bool HAL_I2C_IsClockStretched(void);   /* SCL held low by a slave */
+void HAL_I2C_RecoveryBegin(void);
+void HAL_I2C_RecoveryPulseSCL(void);   /* One full SCL clock cycle */
+void HAL_I2C_RecoveryStop(void);       /* SDA low -> high while SCL is high */
+void HAL_I2C_RecoveryEnd(void);
+void HAL_I2C_Reset(void);              /* Peripheral software reset */
+
+/* Simulated fault injection (host builds only) ------------------------------ */
+
+/**
+ * Faults apply to the process-local simulation only (not to an external
+ * device, see hal_sim.h):
+ *  - HAL_I2C_SimStickSDA(): a slave holds SDA low; START cannot be generated
+ *    until it has seen @p pulses SCL pulses (HAL_I2C_SIM_STUCK_FOREVER: never)
+ *  - HAL_I2C_SimStretchClock(): the next @p count address/data phases hold
+ *    SCL low for @p ticks HAL timer ticks before completing
+ *  - HAL_I2C_SimInjectNack(): the next @p count address or write-data phases
+ *    are NACKed (I2C_SR_AF)
+ *  - HAL_I2C_SimCorruptData(): the next @p count bytes read are XORed with
+ *    @p mask
+ *
+ * The local slave sends the bytes given to HAL_I2C_SimSetReadData() in a
+ * cycle (default: 0x33). With HAL_I2C_SimSetWireTiming() each byte takes
+ * 9 SCL periods at the CCR speed on the HAL timer instead of completing
+ * at once, so receiver stalls show up in real time. HAL_I2C_SimGetRxStats()
+ * reports what the receiver did on the wire. HAL_I2C_SimClearFaults() also
+ * restores the default slave data and timing, drops any received bytes and
+ * clears the statistics.
+ *
+ * An enabled target (I2C2) takes the place of the local slave for its own
+ * address. HAL_I2C_SimSetTargetIrq() installs its event handler, the
+ * stand-in for the interrupt vector; the HAL calls it synchronously for
+ * each target event. The target only exists in the local simulation.
+ */
+
+#define HAL_I2C_SIM_STUCK_FOREVER   0xFFFFFFFFU
+
+typedef enum
+{
+    HAL_I2C_SIM_PHASE_ADDRESS = 0,
+    HAL_I2C_SIM_PHASE_DATA
+} HAL_I2C_SimPhase_t;
+
+void HAL_I2C_SimStickSDA(uint32_t pulses);
+void HAL_I2C_SimStretchClock(uint32_t ticks, uint32_t count);
+void HAL_I2C_SimInjectNack(HAL_I2C_SimPhase_t phase, uint32_t count);
+void HAL_I2C_SimCorruptData(uint8_t mask, uint32_t count);
+void HAL_I2C_SimSetReadData(const uint8_t *data, uint32_t len);
+void HAL_I2C_SimSetWireTiming(bool enable);
+void HAL_I2C_SimClearFaults(void);
+uint32_t HAL_I2C_SimGetRecoveryPulses(void);  /* SCL pulses seen since last clear */
+uint32_t HAL_I2C_SimGetStartCount(void);      /* (Repeated) STARTs since last clear */
+uint32_t HAL_I2C_SimGetStopCount(void);       /* STOPs since last clear */
+
+typedef struct
+{
+    uint32_t bytes;         /**< Bytes clocked in by the receiver */
+    uint32_t stalls;        /**< Times SCL was held low with DR and shift register full */
+    uint32_t stall_ticks;   /**< HAL timer ticks spent in those stalls */
+    uint32_t acked_last;    /**< Reads ended by STOP/START after an ACKed byte */
+    uint32_t unread;        /**< Received bytes never read from DR */
+} HAL_I2C_SimRxStats_t;
+
+void HAL_I2C_SimGetRxStats(HAL_I2C_SimRxStats_t *stats);
+
+typedef void (*HAL_I2C_SimIrqHandler_t)(void);
+
+void HAL_I2C_SimSetTargetIrq(HAL_I2C_SimIrqHandler_t handler);
 
 #endif /* HAL_I2C_H */
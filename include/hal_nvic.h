@@ -0,0 +1,109 @@
+/**
+ * @file hal_nvic.h
+ * @brief Simulated NVIC-style interrupt controller.
+ *
+ * Each peripheral has one IRQ line with an enable bit, a pending bit, an
+ * active bit and a priority (0 = most urgent, as on Cortex-M). A line
+ * becomes pending when software sets it (HAL_NVIC_SetPendingIRQ) or while
+ * its peripheral asserts the interrupt (level-triggered: UART1 with
+ * UART_CTRL_RXNEIE set and a received byte in DATA). An enabled, pending
+ * line is dispatched to the handler installed with HAL_NVIC_SetHandler();
+ * among several, the lowest priority number wins, then the lowest IRQ
+ * number. A handler that returns while its peripheral still asserts the
+ * line is entered again.
+ *
+ * HAL_NVIC_StartDispatcher() runs the handlers on a separate "ISR" thread,
+ * so they genuinely run concurrently with the code they interrupt. The
+ * register blocks are C11 atomics (hal_reg.h); everything else the driver
+ * shares with its handlers needs the same care as on real hardware, and
+ * ThreadSanitizer (-fsanitize=thread) reports what is missed. Handlers run
+ * one at a time on the ISR thread: a more urgent IRQ waits for the running
+ * handler to return (tail-chaining) instead of nesting.
+ *
+ * Without the dispatcher thread, HAL_NVIC_Poll() runs pending handlers from
+ * the calling thread, e.g. from the main loop of a single-threaded build.
+ *
+ * HAL_NVIC_EnterCritical()/ExitCritical() play the role of PRIMASK
+ * (__disable_irq/__enable_irq): no handler starts while it is set, and
+ * EnterCritical() returns only after the running handler, if any, has
+ * finished. They nest, and do nothing when called from a handler.
+ *
+ * On real hardware these map onto the CMSIS NVIC_* functions.
+ */
+
+#ifndef HAL_NVIC_H
+#define HAL_NVIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+typedef enum
+{
+    HAL_IRQ_UART1 = 0,
+    HAL_IRQ_I2C1,
+    HAL_IRQ_I2C2,
+    HAL_IRQ_COUNT
+} HAL_IRQn_t;
+
+#define HAL_NVIC_PRIO_LOWEST   15U   /* 4 priority bits; reset priority 0 */
+
+typedef void (*HAL_NVIC_Handler_t)(void);
+
+/* -------------------------------------------------------------------------- */
+/*                       HAL Function Prototypes (Public API)                 */
+/* -------------------------------------------------------------------------- */
+
+/* Vector table & line configuration ----------------------------------------- */
+
+void HAL_NVIC_SetHandler(HAL_IRQn_t irq, HAL_NVIC_Handler_t handler);
+void HAL_NVIC_SetPriority(HAL_IRQn_t irq, uint8_t priority);
+void HAL_NVIC_EnableIRQ(HAL_IRQn_t irq);
+void HAL_NVIC_DisableIRQ(HAL_IRQn_t irq);   /* Waits for a running handler of @p irq */
+
+/* Pending & active state ---------------------------------------------------- */
+
+void HAL_NVIC_SetPendingIRQ(HAL_IRQn_t irq);
+void HAL_NVIC_ClearPendingIRQ(HAL_IRQn_t irq);
+bool HAL_NVIC_IsPending(HAL_IRQn_t irq);
+bool HAL_NVIC_IsActive(HAL_IRQn_t irq);
+bool HAL_NVIC_InHandler(void);              /* Called from a handler */
+uint32_t HAL_NVIC_GetDispatchCount(HAL_IRQn_t irq);
+
+/* Global masking (PRIMASK) -------------------------------------------------- */
+
+void HAL_NVIC_EnterCritical(void);
+void HAL_NVIC_ExitCritical(void);
+
+/* Dispatch ------------------------------------------------------------------ */
+
+/**
+ * @brief Run every enabled, pending handler from the calling thread.
+ *
+ * @return Number of handlers run
+ */
+uint32_t HAL_NVIC_Poll(void);
+
+/**
+ * @brief Start the ISR thread (host builds only).
+ *
+ * @return false if the thread could not be created
+ */
+bool HAL_NVIC_StartDispatcher(void);
+
+/**
+ * @brief Stop the ISR thread after the running handler returns.
+ */
+void HAL_NVIC_StopDispatcher(void);
+
+/**
+ * @brief Disable every line, clear pending bits, handlers and counters.
+ *
+ * Stops the ISR thread first.
+ */
+void HAL_NVIC_Reset(void);
+
+#endif /* HAL_NVIC_H */
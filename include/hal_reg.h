@@ -0,0 +1,154 @@
+/**
+ * @file hal_reg.h
+ * @brief Register cell type shared by the simulated peripheral blocks.
+ *
+ * On real hardware every peripheral register is a plain `volatile uint32_t`
+ * at a fixed bus address. In the simulator the register blocks may live in a
+ * POSIX shared-memory segment (see hal_sim.h) and be driven by another
+ * process or thread, so each cell is a C11 atomic word. Plain assignment,
+ * reads and compound operators (`|=`, `&=`) on such a cell are single atomic
+ * operations, which keeps the HAL code identical in both cases.
+ *
+ * On real hardware, replace SIM_Reg32_t with `uint32_t`.
+ *
+ * Register accesses made on behalf of the firmware go through
+ * HAL_REG_Read/Write/Modify, which count them: a read-modify-write is one
+ * read and one write on the peripheral bus. Accesses the simulated
+ * peripheral makes to its own registers are not counted.
+ *
+ * A shadow (HAL_REG_Shadow_t) batches changes to one control register: it
+ * reads the register once, collects bit changes in RAM and writes the
+ * result back with a single bus write. Only batch registers whose bits are
+ * owned by the firmware; a bit the hardware changes in between is
+ * overwritten by the commit.
+ */
+
+#ifndef HAL_REG_H
+#define HAL_REG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/** 32-bit register cell (lock-free and address-free, safe in shared memory). */
+typedef _Atomic uint32_t SIM_Reg32_t;
+
+/* -------------------------------------------------------------------------- */
+/*                              Access Counters                                */
+/* -------------------------------------------------------------------------- */
+
+#ifndef HAL_REG_COUNT_ACCESSES
+#define HAL_REG_COUNT_ACCESSES   1   /* 0: no counting overhead */
+#endif
+
+typedef struct
+{
+    uint32_t reads;     /**< Bus read cycles */
+    uint32_t writes;    /**< Bus write cycles */
+} HAL_REG_AccessStats_t;
+
+extern _Atomic uint32_t hal_reg_reads;
+extern _Atomic uint32_t hal_reg_writes;
+
+void HAL_REG_GetAccessStats(HAL_REG_AccessStats_t *stats);
+void HAL_REG_ResetAccessStats(void);
+
+/* -------------------------------------------------------------------------- */
+/*                              Counted Accesses                               */
+/* -------------------------------------------------------------------------- */
+
+static inline void HAL_REG_Count(_Atomic uint32_t *counter)
+{
+#if HAL_REG_COUNT_ACCESSES
+    atomic_fetch_add_explicit(counter, 1U, memory_order_relaxed);
+#else
+    (void)counter;
+#endif
+}
+
+static inline uint32_t HAL_REG_Read(volatile SIM_Reg32_t *reg)
+{
+    HAL_REG_Count(&hal_reg_reads);
+    return *reg;
+}
+
+static inline void HAL_REG_Write(volatile SIM_Reg32_t *reg, uint32_t value)
+{
+    HAL_REG_Count(&hal_reg_writes);
+    *reg = value;
+}
+
+/** Clear then set bits in one read-modify-write. */
+static inline void HAL_REG_Modify(volatile SIM_Reg32_t *reg, uint32_t clear, uint32_t set)
+{
+    HAL_REG_Count(&hal_reg_reads);
+    HAL_REG_Count(&hal_reg_writes);
+
+    if (clear == 0)
+    {
+        *reg |= set;
+    }
+    else if (set == 0)
+    {
+        *reg &= ~clear;
+    }
+    else
+    {
+        uint32_t old = atomic_load(reg);
+        while (!atomic_compare_exchange_weak(reg, &old, (old & ~clear) | set))
+            ;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Shadow Registers                               */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    volatile SIM_Reg32_t *reg;  /**< Register being batched, NULL when idle */
+    uint32_t value;             /**< Pending contents */
+    uint32_t loaded;            /**< Contents when the batch began */
+} HAL_REG_Shadow_t;
+
+static inline void HAL_REG_ShadowBegin(HAL_REG_Shadow_t *shadow, volatile SIM_Reg32_t *reg)
+{
+    shadow->reg = reg;
+    shadow->value = HAL_REG_Read(reg);
+    shadow->loaded = shadow->value;
+}
+
+/** Read @p reg, or its pending contents while @p shadow batches it. */
+static inline uint32_t HAL_REG_ShadowRead(const HAL_REG_Shadow_t *shadow, volatile SIM_Reg32_t *reg)
+{
+    return (shadow->reg == reg) ? shadow->value : HAL_REG_Read(reg);
+}
+
+/** Modify @p reg, or only its pending contents while @p shadow batches it. */
+static inline void HAL_REG_ShadowModify(HAL_REG_Shadow_t *shadow, volatile SIM_Reg32_t *reg,
+                                        uint32_t clear, uint32_t set)
+{
+    if (shadow->reg == reg)
+        shadow->value = (shadow->value & ~clear) | set;
+    else
+        HAL_REG_Modify(reg, clear, set);
+}
+
+/**
+ * @brief End the batch: write the pending contents if they changed.
+ *
+ * @return true if the register was written
+ */
+static inline bool HAL_REG_ShadowCommit(HAL_REG_Shadow_t *shadow)
+{
+    bool changed = (shadow->reg != NULL) && (shadow->value != shadow->loaded);
+
+    if (changed)
+        HAL_REG_Write(shadow->reg, shadow->value);
+
+    shadow->reg = NULL;
+    return changed;
+}
+
+#endif /* HAL_REG_H */
@@ -0,0 +1,197 @@
+/**
+ * @file hal_sim.h
+ * @brief Simulated register file, optionally placed in POSIX shared memory.
+ *
+ * By default the simulated I2C1, I2C2 and UART1 register blocks are ordinary
+ * process-local memory and the HAL emulates the peripheral side itself.
+ * Calling HAL_SIM_AttachShared() moves them into a named shared-memory
+ * segment so that a separate device-simulator process can act as the
+ * peripheral:
+ *
+ *  - The segment holds SIM_MAX_INSTANCES register files ("slots"); each
+ *    firmware instance claims one slot, so several firmware processes can
+ *    run against the same device simulator concurrently.
+ *  - Registers are C11 atomics (hal_reg.h), so both sides may access them
+ *    without locks.
+ *  - Every bus-visible HAL operation rings a per-peripheral doorbell
+ *    (a monotonically increasing counter). The device polls the doorbell,
+ *    services the registers and publishes the handled value in `ack`.
+ *  - UART data crosses the link through one-word mailboxes so that the
+ *    shared DATA register is never written by both sides at once.
+ *
+ * While the device side has set SIM_FLAG_DEVICE_ONLINE in a slot, the HAL
+ * stops emulating address/data phases locally and waits for the device to
+ * update the status flags instead.
+ */
+
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal_reg.h"
+#include "hal_i2c.h"
+#include "hal_uart.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define SIM_SHM_MAGIC        0x52464D53U  /* "SMFR" */
+#define SIM_SHM_VERSION      2U
+#define SIM_MAX_INSTANCES    16U
+#define SIM_SLOT_ANY         0xFFFFFFFFU  /* Claim the first free slot */
+
+/* Register file flags */
+#define SIM_FLAG_CLAIMED         (1U << 0)  /* Slot owned by a firmware instance */
+#define SIM_FLAG_DEVICE_ONLINE   (1U << 1)  /* External device services this slot */
+
+/* Mailbox word: bit 31 marks a valid payload in the low byte */
+#define SIM_MBOX_FULL        (1U << 31)
+
+typedef enum
+{
+    SIM_PERIPH_I2C1 = 0,
+    SIM_PERIPH_UART1,
+    SIM_PERIPH_COUNT
+} SIM_Periph_t;
+
+/**
+ * @brief Lock-free doorbell and data mailboxes for one peripheral.
+ */
+typedef struct
+{
+    SIM_Reg32_t ring;     /**< Bumped by firmware after each bus-visible access */
+    SIM_Reg32_t ack;      /**< Last ring value handled by the device */
+    SIM_Reg32_t to_dev;   /**< Firmware -> device data (SIM_MBOX_FULL | byte) */
+    SIM_Reg32_t to_fw;    /**< Device -> firmware data (SIM_MBOX_FULL | byte) */
+} SIM_Doorbell_t;
+
+/**
+ * @brief One firmware instance's view of the simulated peripherals.
+ */
+typedef struct
+{
+    I2C_Registers_t  i2c1;
+    I2C_Registers_t  i2c2;
+    UART_Registers_t uart1;
+    SIM_Doorbell_t   doorbell[SIM_PERIPH_COUNT];
+    SIM_Reg32_t      flags;
+} SIM_RegisterFile_t;
+
+/**
+ * @brief Layout of the shared-memory segment.
+ */
+typedef struct
+{
+    SIM_Reg32_t        magic;
+    uint32_t           version;
+    SIM_RegisterFile_t slot[SIM_MAX_INSTANCES];
+} SIM_SharedSegment_t;
+
+/* -------------------------------------------------------------------------- */
+/*                          Firmware-side Functions                            */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Move I2C1/I2C2/UART1 into slot @p slot of shared segment @p name.
+ *
+ * The segment is created if it does not exist yet. The claimed slot is reset
+ * to power-on register values.
+ *
+ * @param name  POSIX shared-memory object name (e.g. "/armsim")
+ * @param slot  Slot index, or SIM_SLOT_ANY for the first free one
+ * @return true on success, false if mapping failed or the slot is taken
+ */
+bool HAL_SIM_AttachShared(const char *name, uint32_t slot);
+
+/**
+ * @brief Release the claimed slot and return to process-local registers.
+ */
+void HAL_SIM_Detach(void);
+
+/**
+ * @brief Active register file (local or shared).
+ */
+SIM_RegisterFile_t *HAL_SIM_GetRegisterFile(void);
+
+/**
+ * @brief True while an external device services the active register file.
+ */
+bool HAL_SIM_IsDeviceOnline(void);
+
+/**
+ * @brief Signal the device that @p periph registers changed.
+ */
+void HAL_SIM_RingDoorbell(SIM_Periph_t periph);
+
+/**
+ * @brief Status-poll hook: yields the CPU to the device while a flag is clear.
+ *
+ * Lets busy-wait loops in the drivers make progress when the device process
+ * shares a core with the firmware. No-op without an external device.
+ *
+ * @param flag_set Current flag value
+ * @return @p flag_set
+ */
+bool HAL_SIM_Poll(bool flag_set);
+
+/**
+ * @brief Post a byte to the device mailbox of @p periph.
+ */
+void HAL_SIM_PostToDevice(SIM_Periph_t periph, uint8_t byte);
+
+/**
+ * @brief Take a byte posted by the device, if any.
+ *
+ * @return true if @p byte was filled
+ */
+bool HAL_SIM_TakeFromDevice(SIM_Periph_t periph, uint8_t *byte);
+
+/* -------------------------------------------------------------------------- */
+/*                           Device-side Functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Map shared segment @p name (creating and formatting it if asked).
+ *
+ * @return Segment pointer, or NULL on failure
+ */
+SIM_SharedSegment_t *HAL_SIM_MapShared(const char *name, bool create);
+
+/**
+ * @brief Unmap a segment returned by HAL_SIM_MapShared().
+ */
+void HAL_SIM_UnmapShared(SIM_SharedSegment_t *segment);
+
+/**
+ * @brief Remove the shared-memory object @p name from the system.
+ */
+void HAL_SIM_UnlinkShared(const char *name);
+
+/**
+ * @brief Check a doorbell for a new ring.
+ *
+ * @param file   Register file being serviced
+ * @param periph Peripheral doorbell to check
+ * @param seen   In: last ring handled. Out: current ring value.
+ * @return true if the doorbell rang since @p seen
+ */
+bool HAL_SIM_PollDoorbell(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint32_t *seen);
+
+/**
+ * @brief Publish that all rings up to @p seen have been handled.
+ */
+void HAL_SIM_AckDoorbell(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint32_t seen);
+
+/**
+ * @brief Take a byte posted by the firmware, if any.
+ */
+bool HAL_SIM_TakeFromFirmware(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint8_t *byte);
+
+/**
+ * @brief Post a byte for the firmware. Fails if the previous one is unread.
+ */
+bool HAL_SIM_PostToFirmware(SIM_RegisterFile_t *file, SIM_Periph_t periph, uint8_t byte);
+
+#endif /* HAL_SIM_H */
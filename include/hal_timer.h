@@ -0,0 +1,49 @@
+/**
+ * @file hal_timer.h
+ * @brief Hardware Abstraction Layer for a free-running timestamp counter.
+ *
+ * Provides a 32-bit tick counter for measuring short intervals (driver
+ * transaction latency). On a Cortex-M this maps naturally onto the DWT cycle
+ * counter (DWT->CYCCNT) running at the core clock; the simulator derives the
+ * same count from the host's monotonic clock.
+ *
+ * The counter wraps; intervals are computed as `end - start` in unsigned
+ * arithmetic and are valid up to 2^32 ticks (~89 s at 48 MHz).
+ */
+
+#ifndef HAL_TIMER_H
+#define HAL_TIMER_H
+
+#include <stdint.h>
+#include "board.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 Definitions                                 */
+/* -------------------------------------------------------------------------- */
+
+#define HAL_TIMER_TICK_HZ   BOARD_CPU_CLOCK_HZ   /* Cycle counter rate */
+
+/* -------------------------------------------------------------------------- */
+/*                       HAL Function Prototypes (Public API)                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Current tick count (wraps at 2^32).
+ */
+uint32_t HAL_TIMER_GetTicks(void);
+
+/**
+ * @brief Convert a tick interval to nanoseconds (saturates at UINT32_MAX).
+ */
+uint32_t HAL_TIMER_TicksToNs(uint32_t ticks);
+
+/* Simulation only ----------------------------------------------------------- */
+
+/**
+ * @brief Move simulated time forward by @p ticks.
+ *
+ * Lets tests and peripheral models emulate slow hardware without sleeping.
+ */
+void HAL_TIMER_SimAdvance(uint32_t ticks);
+
+#endif /* HAL_TIMER_H */
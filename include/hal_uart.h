@@ -16,6 +16,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "hal_reg.h"
+#include "board.h"
 
 /* -------------------------------------------------------------------------- */
 /*                     Simulated UART Register Definitions                     */
@@ -26,31 +28,66 @@
  *  - STATUS: TX ready, RX ready flags
  *  - DATA:   transmit/receive buffer
  *  - CTRL:   enable/parity/stop bit config
- *  - BAUD:   baudrate setting
+ *  - BAUD:   baud-rate divisor (UART_BAUD_*)
  *
  * Replace these with actual MCU register mappings for real hardware.
  */
 
 typedef struct
 {
-    volatile uint32_t STATUS;
-    volatile uint32_t DATA;
-    volatile uint32_t CTRL;
-    volatile uint32_t BAUD;
+    volatile SIM_Reg32_t STATUS;
+    volatile SIM_Reg32_t DATA;
+    volatile SIM_Reg32_t CTRL;
+    volatile SIM_Reg32_t BAUD;
 } UART_Registers_t;
 
-/* Simulated peripheral instance */
-extern UART_Registers_t UART1;
+/* Simulated peripheral instance (lives in the active register file, see hal_sim.h) */
+extern UART_Registers_t *HAL_UART1_Regs;
+#define UART1  (*HAL_UART1_Regs)
 
 /* Status register bit masks */
 #define UART_STATUS_TX_READY   (1U << 0)
 #define UART_STATUS_RX_READY   (1U << 1)
+#define UART_STATUS_CTS        (1U << 2)   /* CTS input asserted (peer can receive) */
+#define UART_STATUS_FE         (1U << 3)   /* Framing error on the byte in DATA */
+#define UART_STATUS_ABRF       (1U << 4)   /* Auto-baud measurement complete */
+#define UART_STATUS_ABRE       (1U << 5)   /* Auto-baud measurement failed */
+#define UART_STATUS_PE         (1U << 6)   /* Parity error on the byte in DATA */
+#define UART_STATUS_ORE        (1U << 7)   /* Overrun: a byte was lost before DATA */
+#define UART_STATUS_TC         (1U << 8)   /* Transmission complete: shifter idle */
+
+#define UART_STATUS_RX_ERRORS  (UART_STATUS_FE | UART_STATUS_PE | UART_STATUS_ORE)
 
 /* Control register bit masks */
 #define UART_CTRL_ENABLE       (1U << 0)
 #define UART_CTRL_PARITY_EVEN  (1U << 1)
 #define UART_CTRL_PARITY_ODD   (1U << 2)
 #define UART_CTRL_STOP_2       (1U << 3)
+#define UART_CTRL_HWFLOW       (1U << 4)   /* RTS/CTS enabled; TX gated by CTS */
+#define UART_CTRL_RTS          (1U << 5)   /* RTS output asserted (we can receive) */
+#define UART_CTRL_ABREN        (1U << 6)   /* Measure baud rate on next start bit */
+#define UART_CTRL_M9           (1U << 7)   /* 9 data bits (bit 8 = address mark) */
+#define UART_CTRL_MME          (1U << 8)   /* Mute receiver until an address frame matches */
+#define UART_CTRL_DE           (1U << 9)   /* RS-485 driver enable (DE, /RE tied) asserted */
+#define UART_CTRL_RXNEIE       (1U << 10)  /* Interrupt while RX_READY is set (hal_nvic.h) */
+#define UART_CTRL_OVER8        (1U << 11)  /* 8x instead of 16x oversampling */
+#define UART_CTRL_ADD_SHIFT    16U         /* Own multidrop address for MME */
+#define UART_CTRL_ADD_MASK     (0xFFU << UART_CTRL_ADD_SHIFT)
+
+/*
+ * Baud-rate register: USARTDIV = MANT + FRAC / oversampling, and one bit
+ * lasts oversampling * USARTDIV cycles of BOARD_UART_CLOCK_HZ. FRAC has 4
+ * bits at 16x and 3 bits (bit 3 kept clear) at 8x, so either way the bit
+ * time is set to one clock cycle; with 16x the register value simply is
+ * the bit time in clocks.
+ */
+#define UART_BAUD_FRAC_MASK    0xFU
+#define UART_BAUD_MANT_SHIFT   4U
+#define UART_BAUD_MANT_MAX     0xFFFU
+#define UART_BAUD_RESET        ((BOARD_UART_CLOCK_HZ + 57600U) / 115200U)   /* 115200, 16x */
+
+/* DATA register: 9th data bit in 9-bit mode */
+#define UART_DATA_ADDR_MARK    (1U << 8)
 
 /* -------------------------------------------------------------------------- */
 /*                       HAL Function Prototypes (Public API)                 */
@@ -64,18 +101,154 @@ void HAL_UART_ConfigurePins(void);
 /* UART configuration -------------------------------------------------------- */
 
 void HAL_UART_Enable(void);
+
+/**
+ * @brief Divisor setting for a baud rate, with the rate it really achieves.
+ */
+typedef struct
+{
+    uint32_t divisor;     /**< BAUD register value */
+    bool over8;           /**< UART_CTRL_OVER8 */
+    uint32_t actual;      /**< Achieved baud rate */
+    int32_t error_ppm;    /**< (actual - requested) / requested, in ppm */
+} HAL_UART_BaudDivisor_t;
+
+/**
+ * Of the closest 16x and the closest 8x setting, HAL_UART_ComputeBaud()
+ * picks the one with the smaller error, 16x on a tie (more samples per
+ * bit). 16x reaches BOARD_UART_CLOCK_HZ / 16 and 8x BOARD_UART_CLOCK_HZ / 8;
+ * requests beyond either end get the nearest setting and a large error.
+ * HAL_UART_SetBaudrate() programs the best setting, HAL_UART_GetBaudrate()
+ * reads back the achieved rate.
+ */
+void HAL_UART_ComputeBaud(uint32_t baudrate, HAL_UART_BaudDivisor_t *div);
+void HAL_UART_SetBaudDivisor(const HAL_UART_BaudDivisor_t *div);
 void HAL_UART_SetBaudrate(uint32_t baudrate);
+uint32_t HAL_UART_GetBaudrate(void);
 void HAL_UART_SetParity(uint32_t parity);
 void HAL_UART_SetStopBits(uint32_t stop_bits);
+void HAL_UART_SetHwFlowControl(bool enable);
+
+/**
+ * Between HAL_UART_ConfigBegin() and HAL_UART_ConfigCommit() every function
+ * that changes CTRL (configuration, RTS, RS-485, auto-baud) only updates a
+ * shadow copy; the commit writes CTRL once. BAUD, STATUS and DATA accesses
+ * are not deferred.
+ */
+void HAL_UART_ConfigBegin(void);
+void HAL_UART_ConfigCommit(void);
+
+/* Flow control lines -------------------------------------------------------- */
+
+void HAL_UART_SetRTS(bool asserted);
+bool HAL_UART_IsCTSAsserted(void);
+
+/* Auto-baud detection ------------------------------------------------------- */
+
+void HAL_UART_StartAutoBaud(void);
+void HAL_UART_CancelAutoBaud(void);
+bool HAL_UART_IsAutoBaudDone(void);
+bool HAL_UART_IsAutoBaudError(void);
+
+/* RS-485 multidrop ---------------------------------------------------------- */
+
+/**
+ * In 9-bit mode a frame with the 9th bit set is an address frame. With
+ * address matching enabled the receiver stays muted (no RX_READY, no CPU
+ * wake-up) until an address frame carrying our address arrives; it then
+ * receives data frames until an address frame for another node mutes it
+ * again. Address frames themselves are consumed by the receiver.
+ *
+ * DE drives the transceiver; the receiver is off while it is asserted (half
+ * duplex). TC signals that the last stop bit has left the shift register,
+ * which is the earliest moment DE may be released.
+ */
+
+void HAL_UART_SetDataBits9(bool enable);
+void HAL_UART_SetAddressMatch(bool enable, uint8_t address);
+void HAL_UART_SetDriverEnable(bool asserted);
+bool HAL_UART_IsTxComplete(void);
 
 /* UART data operations ------------------------------------------------------ */
 
 void HAL_UART_SendByte(uint8_t byte);
+void HAL_UART_SendAddress(uint8_t address);   /* 9-bit mode: address-marked frame */
 uint8_t HAL_UART_ReadByte(void);
+bool HAL_UART_IsAddressFrame(void);           /* Byte in DATA carries the address mark */
 
 /* Status checks ------------------------------------------------------------- */
 
 bool HAL_UART_IsTxReady(void);
 bool HAL_UART_IsRxReady(void);
+uint32_t HAL_UART_GetRxErrors(void);   /* UART_STATUS_RX_ERRORS bits for the byte in DATA */
+
+/* Interrupts ---------------------------------------------------------------- */
+
+/**
+ * With RXNEIE set the UART asserts HAL_IRQ_UART1 while a received byte
+ * waits in DATA. The interrupt controller samples the line through
+ * HAL_UART_SimIrqLevel(), which also lets the simulated receiver move the
+ * peer's next byte into DATA without any driver call.
+ */
+void HAL_UART_SetRxInterrupt(bool enable);
+bool HAL_UART_SimIrqLevel(void);
+
+/* Simulated remote peer (host builds only) ---------------------------------- */
+
+/**
+ * The simulator models the device at the other end of the wire:
+ *  - bytes queued with HAL_UART_SimFeed() are delivered one at a time into
+ *    DATA whenever the receive register is free
+ *  - with UART_CTRL_HWFLOW set, the peer stops sending while RTS is low
+ *    (after HAL_UART_SIM_RTS_SKID bytes already in flight)
+ *  - with peer software flow enabled, the peer stops on our XOFF
+ *    (after HAL_UART_SIM_XOFF_SKID bytes) and resumes on XON
+ *  - the peer transmits at its own baud rate (HAL_UART_SimSetPeerBaud,
+ *    latched per byte when it is queued);
+ *    bytes exchanged while the two rates differ by more than
+ *    HAL_UART_SIM_BAUD_TOLERANCE_PCT, or while our rate exceeds what the
+ *    link can carry (HAL_UART_SimSetLinkMaxBaud), arrive with a framing error
+ *  - auto-baud measures the peer's bit time in BOARD_UART_CLOCK_HZ ticks
+ *    from the start of the next byte, which must have its LSB set
+ *  - HAL_UART_SimInjectRxError() flags the next delivered byte with parity
+ *    or overrun errors
+ *  - transmitted bytes go to the TX hook if one is set, else to stdout
+ *  - each transmitted frame occupies the wire for its bit time at the
+ *    programmed rate; TC is set once the last queued frame has gone out
+ *  - HAL_UART_SimFeedAddress() queues an address-marked (9-bit) frame;
+ *    HAL_UART_SimGetRs485Stats() reports frames muted by address matching
+ *    and the DE timing of the last transmission
+ */
+
+#define HAL_UART_SIM_FIFO_SIZE   4096U
+#define HAL_UART_SIM_RTS_SKID    2U
+#define HAL_UART_SIM_XOFF_SKID   8U
+#define HAL_UART_SIM_XON         0x11U
+#define HAL_UART_SIM_XOFF        0x13U
+#define HAL_UART_SIM_BAUD_TOLERANCE_PCT  3U
+
+typedef void (*HAL_UART_SimTxHook_t)(uint8_t byte, bool framing_error);
+
+uint32_t HAL_UART_SimFeed(const uint8_t *data, uint32_t len);
+uint32_t HAL_UART_SimPending(void);
+void HAL_UART_SimReset(void);
+void HAL_UART_SimSetCTS(bool asserted);
+void HAL_UART_SimSetPeerSwFlow(bool enable);
+void HAL_UART_SimSetTxHook(HAL_UART_SimTxHook_t hook);
+void HAL_UART_SimSetPeerBaud(uint32_t baudrate);     /* 0: follow our rate */
+void HAL_UART_SimSetLinkMaxBaud(uint32_t baudrate);  /* 0: unlimited */
+void HAL_UART_SimInjectRxError(uint32_t status_bits); /* UART_STATUS_PE / _ORE */
+
+typedef struct
+{
+    uint32_t address_frames_sent;
+    uint8_t last_address_sent;
+    uint32_t muted_frames;     /* Received frames dropped by address matching */
+    uint32_t de_lead_ticks;    /* DE asserted -> first start bit (last transmission) */
+    uint32_t de_lag_ticks;     /* Transmission complete -> DE released (last transmission) */
+} HAL_UART_SimRs485Stats_t;
+
+bool HAL_UART_SimFeedAddress(uint8_t address);
+void HAL_UART_SimGetRs485Stats(HAL_UART_SimRs485Stats_t *stats);
 
 #endif /* HAL_UART_H */
\ No newline at end of file
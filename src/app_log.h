@@ -0,0 +1,27 @@
+/**
+ * @file app_log.h
+ * @brief Application log message IDs generated from log_strings.def.
+ *
+ * A matching format table (for text-mode logging or a host decoder) is
+ * built the same way:
+ *
+ *   static const char *const formats[] = {
+ *   #define LOG_STRING(name, format) format,
+ *   #include "log_strings.def"
+ *   #undef LOG_STRING
+ *   };
+ */
+
+#ifndef APP_LOG_H
+#define APP_LOG_H
+
+/* One enumerator per LOG_STRING entry; the value is the wire ID */
+typedef enum
+{
+#define LOG_STRING(name, format) name,
+#include "log_strings.def"
+#undef LOG_STRING
+    LOG_STRING_COUNT
+} App_LogId_t;
+
+#endif /* APP_LOG_H */
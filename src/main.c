@@ -26,12 +26,19 @@
  * hardware directly—they call into the HAL layer. */
 #include "../drivers/uart.h"    // UART high-level driver functions (UART_Init, UART_WriteString, etc.)
 #include "../drivers/i2c.h"     // I2C high-level driver functions (I2C_Init, I2C_WriteByte, I2C_ReadByte)
+#include "../drivers/uart_log.h" // Tokenized logging (UART_LOG0, UART_LOG1, ...)
+#include "app_log.h"             // Log message IDs generated from log_strings.def
+#include "../drivers/sample_codec.h" // Delta/varint sample stream encoder
+#include "../drivers/sample_window.h" // Windowed summaries of sensor samples
+#include "../drivers/drv_latency.h"  // Driver latency histograms (DRV_LatencyDump)
 
 /* ---------------- HAL Layer Includes (Low-Level Hardware Simulation) ------- */
 /* These files contain simulated hardware registers for UART and I2C. The driver
  * functions call these to "pretend" hardware exists. */
 #include "../include/hal_uart.h" // Simulated UART register definitions
 #include "../include/hal_i2c.h"  // Simulated I2C register definitions
+#include "../include/hal_sim.h"  // Optional shared-memory register file (co-simulation)
+#include "../include/hal_timer.h" // Timestamps for windowed samples
 
 /* ---------------- Board Configuration Include ------------------------------ */
 /* Defines core hardware interface structures (UART_Registers_t, I2C_Registers_t) */
@@ -56,6 +63,69 @@
 #define SENSOR_I2C_ADDRESS   0x48   /* Typical temp sensor address */
 #define SENSOR_REG_TEMP      0x00
 
+/* -------------------------------------------------------------------------- */
+/*                               Log String Table                              */
+/* -------------------------------------------------------------------------- */
+/**
+ * Every log message lives in log_strings.def and is referred to by its ID.
+ * By default the firmware formats the text itself (UART_LOG_TEXT), so the
+ * console output is plain text. Building with -DAPP_LOG_TOKENIZED sends only
+ * the ID and binary arguments instead; pipe the output through
+ * build/log_decode to read it. In that build the strings below are not
+ * linked into the firmware at all.
+ */
+#ifndef APP_LOG_TOKENIZED
+static const char *const app_log_formats[] = {
+#define LOG_STRING(name, format) format,
+#include "log_strings.def"
+#undef LOG_STRING
+};
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                             Sample Stream Encoder                           */
+/* -------------------------------------------------------------------------- */
+/**
+ * Building with -DAPP_SAMPLE_STREAM sends sensor readings as compressed
+ * sample blocks (sample_codec.h) instead of one log line each. A temperature
+ * that barely changes then costs about one byte per reading instead of a
+ * full message; pipe the output through build/sample_decode to read it.
+ */
+#ifdef APP_SAMPLE_STREAM
+#define APP_SAMPLE_CH_TEMP   0   /* Stream channel used for the temperature */
+
+static SAMPLE_Encoder_t app_samples;
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                             Windowed Aggregation                            */
+/* -------------------------------------------------------------------------- */
+/**
+ * Building with -DAPP_SAMPLE_WINDOW keeps raw readings on the device and
+ * sends one summary line (mean, standard deviation, min, max) per window of
+ * APP_WINDOW_SAMPLES readings instead. A reading outside the trigger range
+ * is still sent raw, together with the readings just before it.
+ */
+#ifdef APP_SAMPLE_WINDOW
+#define APP_WINDOW_CH_TEMP   0    /* Pipeline channel used for the temperature */
+#define APP_WINDOW_SAMPLES   5    /* One summary per main loop run */
+
+static SWIN_Pipeline_t app_window;
+
+static void App_WindowSummary(uint8_t channel, const SWIN_Summary_t *summary)
+{
+    (void)channel;
+    UART_LOG4(LOG_SENSOR_SUMMARY, summary->mean, summary->stddev, summary->min, summary->max);
+}
+
+static void App_WindowRaw(uint8_t channel, const SWIN_Sample_t *sample, SWIN_RawReason_t reason)
+{
+    (void)channel;
+    (void)reason;
+    UART_LOG2(LOG_SENSOR_RAW, sample->value, sample->tick);
+}
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*                               Initialization                                */
 /* -------------------------------------------------------------------------- */
@@ -76,9 +146,15 @@ static void App_InitUART(void)
      */
     UART_Init(&cfg);
 
-    /* Sends a string over UART by writing each character to the simulated register.
-     * UART_WriteString() comes from uart.c and internally calls HAL_UART_SendByte(). */
-    UART_WriteString("UART Initialized.\r\n");
+    /* Sends a log message over UART. UART_LOG0() comes from uart_log.h; the text
+     * for LOG_UART_INITIALIZED lives in log_strings.def. */
+    UART_LOG0(LOG_UART_INITIALIZED);
+
+    /* The 48 MHz UART clock does not divide down to every rate exactly.
+     * UART_CheckBaudrate() compares the rate it really achieves against the
+     * error budget (2 % unless cfg.baud_tolerance_ppm says otherwise). */
+    if (UART_CheckBaudrate(cfg.baudrate, NULL, NULL) != UART_RESULT_OK)
+        UART_LOG2(LOG_UART_BAUD_ERROR, cfg.baudrate, UART_GetActualBaudrate());
 }
 
 static void App_InitI2C(void)
@@ -100,7 +176,14 @@ static void App_InitI2C(void)
      */
     I2C_Init(&cfg);
 
-    UART_WriteString("I2C Initialized.\r\n");  // Confirm initialization
+    /* I2C_SetRetryPolicy():
+     * - A busy sensor NACKs now and then; let the driver retry with backoff
+     *   (and stop hammering it if it keeps failing) instead of the caller.
+     */
+    static const I2C_RetryPolicy_t sensor_retry = I2C_RETRY_POLICY_DEFAULT;
+    I2C_SetRetryPolicy(SENSOR_I2C_ADDRESS, &sensor_retry);
+
+    UART_LOG0(LOG_I2C_INITIALIZED);  // Confirm initialization
 }
 
 /* -------------------------------------------------------------------------- */
@@ -111,7 +194,7 @@ static void App_ReadSensor(void)
 {
     uint8_t temp_value = 0; // Will store the 1‑byte temperature value returned by the sensor.
 
-    UART_WriteString("Reading temperature sensor...\r\n");
+    UART_LOG0(LOG_SENSOR_READING);
 
     /* Step 1: Tell the sensor which register we want to read.
      * I2C_WriteByte():
@@ -122,7 +205,7 @@ static void App_ReadSensor(void)
      */
     if (I2C_WriteByte(SENSOR_I2C_ADDRESS, SENSOR_REG_TEMP) != I2C_STATUS_OK)
     {
-        UART_WriteString("I2C Write Error!\r\n");
+        UART_LOG0(LOG_I2C_WRITE_ERROR);
         return; // Stop if write fails
     }
 
@@ -133,16 +216,24 @@ static void App_ReadSensor(void)
      */
     if (I2C_ReadByte(SENSOR_I2C_ADDRESS, &temp_value) != I2C_STATUS_OK)
     {
-        UART_WriteString("I2C Read Error!\r\n");
+        UART_LOG0(LOG_I2C_READ_ERROR);
         return;
     }
 
+#if defined(APP_SAMPLE_WINDOW)
+    /* Fold the reading into the current window; summaries go out from the
+     * pipeline's callbacks. */
+    SWIN_Push(&app_window, APP_WINDOW_CH_TEMP, temp_value, HAL_TIMER_GetTicks());
+#elif defined(APP_SAMPLE_STREAM)
+    /* Queue the reading; a block goes out once enough samples are collected. */
+    SAMPLE_Push(&app_samples, APP_SAMPLE_CH_TEMP, temp_value);
+#else
     /* Output the data over UART.
-     * UART_WriteHex() converts a byte into readable HEX characters (e.g., 0x33).
+     * UART_LOG1() passes temp_value as an argument; the "%08X" in the format
+     * string turns it into readable HEX characters (e.g., 00000033).
      */
-    UART_WriteString("Sensor Value (Hex): 0x");
-    UART_WriteHex(temp_value);
-    UART_WriteString("\r\n");
+    UART_LOG1(LOG_SENSOR_VALUE, temp_value);
+#endif
 
     /* fflush(stdout):
      * Ensures all text immediately prints to your terminal instead of waiting
@@ -151,22 +242,81 @@ static void App_ReadSensor(void)
     fflush(stdout);
 }
 
+/* -------------------------------------------------------------------------- */
+/*                              Console Commands                               */
+/* -------------------------------------------------------------------------- */
+
+#define APP_CMD_LATENCY   '?'   /* Send '?' to get the driver latency report */
+
+static void App_ServiceConsole(void)
+{
+    /* UART_PollRx() moves any received bytes into the driver's RX buffer.
+     * We only read when something is there, so the main loop never blocks. */
+    UART_PollRx();
+
+    while (UART_RxAvailable() > 0)
+    {
+        if (UART_ReadChar() == APP_CMD_LATENCY)
+            DRV_LatencyDump(); // Prints p50/p99/... of every I2C and UART operation
+    }
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                     MAIN                                   */
 /* -------------------------------------------------------------------------- */
 
 int main(void)
 {
+#ifdef SIM_SHM_NAME
+    /* Optional co-simulation: build with -DSIM_SHM_NAME=\"/armsim\" to move the
+     * simulated registers into shared memory served by build/sim_device.
+     * SIM_SLOT_ANY lets several firmware instances share one device process. */
+    if (!HAL_SIM_AttachShared(SIM_SHM_NAME, SIM_SLOT_ANY))
+        return 1;
+#endif
+
+    /* Select text or tokenized log output (see Log String Table above). */
+#ifdef APP_LOG_TOKENIZED
+    UART_LogInit(UART_LOG_TOKENIZED, NULL, 0);
+#else
+    UART_LogInit(UART_LOG_TEXT, app_log_formats, LOG_STRING_COUNT);
+#endif
+
     /* Announce system start. At this moment UART is not yet configured,
-     * but UART_WriteString uses the simulated HAL which is always enabled.
+     * but the UART driver uses the simulated HAL which is always enabled.
      */
-    UART_WriteString("System Booting...\r\n");
+    UART_LOG0(LOG_SYSTEM_BOOTING);
 
     /* Initialize communication peripherals */
     App_InitUART(); // Sets up UART with baud rate and settings from cfg
     App_InitI2C();  // Sets up I2C with 100 kHz & 7‑bit addressing
 
-    UART_WriteString("System Ready.\r\n");
+#ifdef APP_SAMPLE_STREAM
+    /* Blocks are written straight to the UART; run-length mode makes a
+     * constant temperature almost free. */
+    SAMPLE_EncoderInit(&app_samples, &(SAMPLE_EncoderConfig_t){
+        .block_size = SAMPLE_DEFAULT_BLOCK,
+        .keyframe_interval = SAMPLE_DEFAULT_KEYFRAME,
+        .run_length = true,
+        .output = UART_WriteBytes
+    });
+#endif
+
+#ifdef APP_SAMPLE_WINDOW
+    /* Summaries per APP_WINDOW_SAMPLES readings; a reading outside 0x00..0x7F
+     * sends the two before it and the two after it raw. */
+    SWIN_Init(&app_window, App_WindowSummary, App_WindowRaw);
+    SWIN_ConfigureChannel(&app_window, APP_WINDOW_CH_TEMP, &(SWIN_ChannelConfig_t){
+        .window_samples = APP_WINDOW_SAMPLES,
+        .trigger = true,
+        .trigger_low = 0x00,
+        .trigger_high = 0x7F,
+        .burst_pre = 2,
+        .burst_post = 2
+    });
+#endif
+
+    UART_LOG0(LOG_SYSTEM_READY);
 
     /* Main loop (runs only 5 times to avoid infinite output).
      * In real firmware this would typically be while(1) to run forever.
@@ -174,8 +324,21 @@ int main(void)
     for (int i = 0; i < 5; i++)
     {
         App_ReadSensor(); // Perform one full I2C transaction and print data
-        UART_WriteString("Loop iteration complete.\r\n");
+        UART_LOG0(LOG_LOOP_COMPLETE);
+        App_ServiceConsole(); // Answer commands typed on the UART console
     }
 
+#ifdef APP_SAMPLE_STREAM
+    SAMPLE_Flush(&app_samples); // Send the last, partially filled block
+#endif
+
+#ifdef APP_SAMPLE_WINDOW
+    SWIN_Flush(&app_window); // Summarize the last, partially filled window
+#endif
+
+#ifdef SIM_SHM_NAME
+    HAL_SIM_Detach(); // Release our slot so another firmware instance can use it
+#endif
+
     return 0; // Indicate normal program termination
 }
\ No newline at end of file
@@ -11,19 +11,29 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
 
 #include "../drivers/uart.h"
 #include "../drivers/i2c.h"
+#include "../drivers/uart_log.h"
+#include "../drivers/sample_codec.h"
+#include "../drivers/sample_window.h"
+#include "../drivers/histogram.h"
+#include "../drivers/drv_latency.h"
+#include "../drivers/sensor_cache.h"
+#include "../drivers/line_scan.h"
+#include "../drivers/i2c_target.h"
+#include "../drivers/uart_mux.h"
 #include "../include/hal_uart.h"
 #include "../include/hal_i2c.h"
-
-/* -------------------------------------------------------------------------- */
-/*                 Manual Mock Register Instances for Testing                 */
-/* -------------------------------------------------------------------------- */
-
-extern UART_Registers_t UART1;
-extern I2C_Registers_t I2C1;
+#include "../include/hal_sim.h"
+#include "../include/hal_timer.h"
+#include "../include/hal_capture.h"
+#include "../include/hal_nvic.h"
 
 /* -------------------------------------------------------------------------- */
 /*                        Helper Functions for Testing                        */
@@ -37,6 +47,131 @@ static void reset_uart_registers(void)
     UART1.BAUD = 0;
 }
 
+static uint8_t uart_tx_capture[256];
+static uint32_t uart_tx_captured;
+
+static void capture_uart_tx(uint8_t byte, bool framing_error)
+{
+    (void)framing_error;
+
+    if (uart_tx_captured < sizeof(uart_tx_capture))
+        uart_tx_capture[uart_tx_captured] = byte;
+    uart_tx_captured++;
+}
+
+static void reset_uart_peer(void)
+{
+    reset_uart_registers();
+    UART1.STATUS |= UART_STATUS_CTS;
+    HAL_UART_SimReset();
+    HAL_UART_SimSetTxHook(capture_uart_tx);
+    uart_tx_captured = 0;
+}
+
+static void init_uart_flow(UART_FlowControl_t flow)
+{
+    UART_Config_t cfg = {
+        .baudrate = 115200,
+        .stop_bits = UART_STOPBITS_1,
+        .parity = UART_PARITY_NONE,
+        .flow_control = flow
+    };
+
+    UART_Init(&cfg);
+}
+
+/* Feed a counting pattern and check it arrives complete and in order */
+static void flood_and_drain(uint32_t total)
+{
+    static uint8_t pattern[1000];
+
+    for (uint32_t i = 0; i < total; i++)
+        pattern[i] = (uint8_t)(0x20 + (i % 0x50));  /* Never XON/XOFF */
+
+    assert(HAL_UART_SimFeed(pattern, total) == total);
+
+    for (uint32_t i = 0; i < total; i++)
+        assert((uint8_t)UART_ReadChar() == pattern[i]);
+
+    assert(UART_RxDropped() == 0);
+}
+
+/* Scripted peer for baud-rate negotiation tests */
+static const uint32_t neg_rates[UART_NEG_RATE_COUNT] = UART_NEG_RATES;
+static uint8_t neg_peer_frame[4];
+static uint32_t neg_peer_len;
+static uint32_t neg_peer_caps;
+static uint32_t neg_peer_verified;
+
+static void neg_peer_send(uint8_t type, uint8_t arg)
+{
+    const uint8_t frame[4] = { UART_NEG_MAGIC, type, arg, (uint8_t)(UART_NEG_MAGIC ^ type ^ arg) };
+    HAL_UART_SimFeed(frame, sizeof(frame));
+}
+
+/* Collect one frame from our TX; returns true when complete */
+static bool neg_peer_collect(uint8_t byte)
+{
+    if (neg_peer_len == 0 && byte != UART_NEG_MAGIC)
+        return false;
+
+    neg_peer_frame[neg_peer_len++] = byte;
+    if (neg_peer_len < sizeof(neg_peer_frame))
+        return false;
+
+    neg_peer_len = 0;
+    return true;
+}
+
+/* Peer acting as responder; falls back to 115200 when it sees garbage */
+static void neg_responder_hook(uint8_t byte, bool framing_error)
+{
+    if (framing_error)
+    {
+        neg_peer_len = 0;
+        HAL_UART_SimSetPeerBaud(115200);
+        return;
+    }
+
+    if (!neg_peer_collect(byte))
+        return;
+
+    if (neg_peer_frame[1] == UART_NEG_REQUEST)
+    {
+        uint32_t common = neg_peer_frame[2] & neg_peer_caps;
+        uint8_t index = UART_NEG_RATE_COUNT - 1U;
+
+        while (index > 0 && !(common & (1U << index)))
+            index--;
+
+        neg_peer_send(UART_NEG_ACCEPT, index);
+        HAL_UART_SimSetPeerBaud(neg_rates[index]);
+    }
+    else if (neg_peer_frame[1] == UART_NEG_VERIFY)
+    {
+        neg_peer_send(UART_NEG_VERIFY_ACK, neg_peer_frame[2]);
+    }
+}
+
+/* Peer acting as initiator */
+static void neg_initiator_hook(uint8_t byte, bool framing_error)
+{
+    assert(!framing_error);
+
+    if (!neg_peer_collect(byte))
+        return;
+
+    if (neg_peer_frame[1] == UART_NEG_ACCEPT)
+    {
+        HAL_UART_SimSetPeerBaud(neg_rates[neg_peer_frame[2]]);
+        neg_peer_send(UART_NEG_VERIFY, neg_peer_frame[2]);
+    }
+    else if (neg_peer_frame[1] == UART_NEG_VERIFY_ACK)
+    {
+        neg_peer_verified++;
+    }
+}
+
 static void reset_i2c_registers(void)
 {
     I2C1.CR = 0;
@@ -76,6 +211,992 @@ static void test_uart_write_read(void)
     printf("[UART] Read/Write test passed.\n");
 }
 
+static void test_uart_no_flow_control_overruns(void)
+{
+    static uint8_t flood[1000];
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+
+    assert(HAL_UART_SimFeed(flood, sizeof(flood)) == sizeof(flood));
+    UART_PollRx();
+
+    assert(UART_RxAvailable() == UART_RX_BUFFER_SIZE);
+    assert(UART_RxDropped() == sizeof(flood) - UART_RX_BUFFER_SIZE);
+
+    HAL_UART_SimReset();
+    printf("[UART] No-flow-control overrun test passed.\n");
+}
+
+static void test_uart_rts_cts(void)
+{
+    static uint8_t flood[1000];
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_RTS_CTS);
+    assert(UART1.CTRL & UART_CTRL_RTS);
+
+    /* RTS drops at the high watermark; only the in-flight skid follows */
+    assert(HAL_UART_SimFeed(flood, sizeof(flood)) == sizeof(flood));
+    UART_PollRx();
+    assert(!(UART1.CTRL & UART_CTRL_RTS));
+    assert(UART_RxAvailable() == (UART_RX_BUFFER_SIZE * 3U) / 4U + HAL_UART_SIM_RTS_SKID);
+    assert(UART_RxDropped() == 0);
+
+    /* Draining to the low watermark raises RTS again */
+    while (UART_RxAvailable() > UART_RX_BUFFER_SIZE / 4U)
+        (void)UART_ReadChar();
+    assert(UART1.CTRL & UART_CTRL_RTS);
+
+    while (UART_RxAvailable() > 0 || HAL_UART_SimPending() > 0)
+        (void)UART_ReadChar();
+    flood_and_drain(1000);
+
+    /* CTS gates the transmitter */
+    HAL_UART_SimSetCTS(false);
+    assert(!HAL_UART_IsTxReady());
+    HAL_UART_SimSetCTS(true);
+    assert(HAL_UART_IsTxReady());
+
+    /* Custom high watermark: the default low is derived from it */
+    UART_Config_t cfg = { .baudrate = 115200, .flow_control = UART_FLOW_RTS_CTS,
+                          .rx_high_watermark = 32 };
+    reset_uart_peer();
+    assert(UART_Init(&cfg) == UART_RESULT_OK);
+    assert(HAL_UART_SimFeed(flood, sizeof(flood)) == sizeof(flood));
+    UART_PollRx();
+    assert(!(UART1.CTRL & UART_CTRL_RTS));
+    assert(UART_RxAvailable() == 32U + HAL_UART_SIM_RTS_SKID);
+    while (UART_RxAvailable() > 11U)
+        (void)UART_ReadChar();
+    assert(!(UART1.CTRL & UART_CTRL_RTS));
+    (void)UART_ReadChar();
+    assert(UART1.CTRL & UART_CTRL_RTS);
+
+    /* No room left for the skid, or the watermarks the wrong way round */
+    cfg.rx_high_watermark = UART_RX_BUFFER_SIZE;
+    assert(UART_Init(&cfg) == UART_RESULT_ERROR);
+    cfg.rx_high_watermark = 32;
+    cfg.rx_low_watermark = 32;
+    assert(UART_Init(&cfg) == UART_RESULT_ERROR);
+
+    HAL_UART_SimReset();
+    printf("[UART] RTS/CTS flow control test passed.\n");
+}
+
+static void test_uart_xon_xoff(void)
+{
+    const uint8_t xoff = UART_XOFF;
+    const uint8_t xon = UART_XON;
+
+    reset_uart_peer();
+    HAL_UART_SimSetPeerSwFlow(true);
+    init_uart_flow(UART_FLOW_XON_XOFF);
+
+    /* Receive side: XOFF at the high watermark, XON at the low watermark */
+    flood_and_drain(1000);
+    assert(uart_tx_captured >= 2);
+    assert(uart_tx_capture[0] == UART_XOFF);
+    assert(uart_tx_capture[1] == UART_XON);
+
+    /* Transmit side: peer XOFF/XON pause and resume our TX path */
+    HAL_UART_SimFeed(&xoff, 1);
+    UART_PollRx();
+    assert(UART_IsTxPaused());
+    assert(UART_RxAvailable() == 0);   /* Flow characters are not data */
+
+    HAL_UART_SimFeed(&xon, 1);
+    UART_PollRx();
+    assert(!UART_IsTxPaused());
+
+    HAL_UART_SimFeed(&xoff, 1);
+    UART_PollRx();
+    HAL_UART_SimFeed(&xon, 1);
+    uart_tx_captured = 0;
+    UART_WriteChar('T');               /* Waits for XON, then sends */
+    assert(!UART_IsTxPaused());
+    assert(uart_tx_captured == 1 && uart_tx_capture[0] == 'T');
+
+    HAL_UART_SimReset();
+    printf("[UART] XON/XOFF flow control test passed.\n");
+}
+
+static void test_uart_autobaud(void)
+{
+    const uint8_t early[] = { 'a', 'b' };
+    const uint8_t late[] = { 'U', 'c', 'd' };
+    const uint8_t bad_sync = 0x54;   /* LSB clear: start bit cannot be timed */
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+
+    HAL_UART_SimFeed(early, sizeof(early));
+    UART_PollRx();
+
+    HAL_UART_SimSetPeerBaud(921600);
+    HAL_UART_SimFeed(late, sizeof(late));
+    assert(UART_AutoBaud('U', UART_TIMEOUT) == UART_RESULT_OK);
+    assert(UART_GetBaudrate() == 921600);
+
+    /* Bytes received before and after the switch are all intact */
+    assert(UART_ReadChar() == 'a' && UART_ReadChar() == 'b');
+    assert(UART_ReadChar() == 'c' && UART_ReadChar() == 'd');
+    assert(UART_RxFramingErrors() == 0);
+
+    HAL_UART_SimSetPeerBaud(460800);
+    HAL_UART_SimFeed(&bad_sync, 1);
+    assert(UART_AutoBaud('U', UART_TIMEOUT) == UART_RESULT_NO_SYNC);
+    assert(UART_GetBaudrate() == 921600);
+
+    assert(UART_AutoBaud('U', 1000) == UART_RESULT_TIMEOUT);
+
+    /* A snapped rate outside the error budget keeps the old divisor */
+    reset_uart_peer();
+    UART_Init(&(UART_Config_t){ .baudrate = 115200, .stop_bits = UART_STOPBITS_1,
+                                .parity = UART_PARITY_NONE, .flow_control = UART_FLOW_NONE,
+                                .baud_tolerance_ppm = 1000 });
+    uint32_t before = UART_GetActualBaudrate();
+    HAL_UART_SimSetPeerBaud(921600);   /* Best divisor is ~1600 ppm off */
+    HAL_UART_SimFeed(late, 1);
+    assert(UART_AutoBaud('U', UART_TIMEOUT) == UART_RESULT_BAUD_ERROR);
+    assert(UART_GetBaudrate() == 115200 && UART_GetActualBaudrate() == before);
+
+    HAL_UART_SimReset();
+    printf("[UART] Auto-baud test passed.\n");
+}
+
+static void test_uart_baud_divisor(void)
+{
+    const uint8_t probe[] = { 'h', 'i' };
+    UART_Config_t cfg = { .baudrate = 115200 };
+    uint32_t actual;
+    int32_t error;
+
+    reset_uart_peer();
+    UART_Init(&cfg);
+
+    /* 416.7 clocks per bit round to 417: a little slow, well within budget */
+    assert(UART_CheckBaudrate(115200, &actual, &error) == UART_RESULT_OK);
+    assert(actual == 115108 && error < 0 && error > -1000);
+    assert(UART_GetActualBaudrate() == 115108 && UART_GetBaudError() == error);
+    assert(!(UART1.CTRL & UART_CTRL_OVER8));
+
+    /* 16x reaches 3 Mbaud exactly */
+    assert(UART_SetBaudrate(3000000) == UART_RESULT_OK);
+    assert(UART1.BAUD == 16 && !(UART1.CTRL & UART_CTRL_OVER8));
+    assert(UART_GetActualBaudrate() == 3000000);
+
+    /* Beyond that only 8x: USARTDIV 1.5 -> MANT 1, FRAC 4/8 */
+    assert(UART_SetBaudrate(4000000) == UART_RESULT_OK);
+    assert(UART1.BAUD == ((1U << UART_BAUD_MANT_SHIFT) | 4U) && (UART1.CTRL & UART_CTRL_OVER8));
+    assert(UART_GetActualBaudrate() == 4000000 && UART_GetBaudError() == 0);
+    assert(UART_SetBaudrate(6000000) == UART_RESULT_OK);
+    assert(UART_GetActualBaudrate() == 6000000);
+
+    /* The link works at the new rate */
+    HAL_UART_SimFeed(probe, sizeof(probe));
+    assert(UART_ReadChar() == 'h' && UART_ReadChar() == 'i');
+    assert(UART_RxFramingErrors() == 0);
+
+    /* 5 Mbaud is 9.6 clocks per bit: 4 % off either way, so it is refused */
+    assert(UART_CheckBaudrate(5000000, &actual, &error) == UART_RESULT_BAUD_ERROR);
+    assert(actual == 4800000 && error == -40000);
+    assert(UART_SetBaudrate(5000000) == UART_RESULT_BAUD_ERROR);
+    assert(UART_GetBaudrate() == 6000000 && UART_GetActualBaudrate() == 6000000);
+    assert(UART_SetBaudrate(12000000) == UART_RESULT_BAUD_ERROR);
+    assert(UART_SetBaudrate(0) == UART_RESULT_BAUD_ERROR);
+
+    /* With a wider budget it is accepted */
+    cfg.baud_tolerance_ppm = 50000;
+    UART_Init(&cfg);
+    assert(UART_SetBaudrate(5000000) == UART_RESULT_OK);
+    assert(UART_GetActualBaudrate() == 4800000);
+
+    /* A budget 921600 cannot meet keeps it out of negotiation entirely */
+    cfg.baud_tolerance_ppm = 1000;
+    UART_Init(&cfg);
+    uart_tx_captured = 0;
+    assert(UART_CheckBaudrate(921600, &actual, NULL) == UART_RESULT_BAUD_ERROR);
+    assert(actual == 923077);
+    assert(UART_NegotiateBaud(UART_CAP_921600) == UART_RESULT_REJECTED);
+    assert(uart_tx_captured == 0);
+
+    HAL_UART_SimReset();
+    printf("[UART] Fractional baud divisor test passed.\n");
+}
+
+static void test_uart_baud_negotiation(void)
+{
+    const uint8_t pending[] = { 'x', 'y' };
+    const uint8_t after = 'z';
+
+    /* Initiator: peer supports 3 Mbaud, but the link tops out at 2 Mbaud */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_UART_SimFeed(pending, sizeof(pending));
+    UART_PollRx();
+
+    HAL_UART_SimSetTxHook(neg_responder_hook);
+    HAL_UART_SimSetPeerBaud(115200);
+    HAL_UART_SimSetLinkMaxBaud(2000000);
+    neg_peer_len = 0;
+    neg_peer_caps = UART_CAP_ALL;
+
+    assert(UART_NegotiateBaud(UART_CAP_ALL) == UART_RESULT_OK);
+    assert(UART_GetBaudrate() == 2000000);
+
+    HAL_UART_SimFeed(&after, 1);
+    assert(UART_ReadChar() == 'x' && UART_ReadChar() == 'y' && UART_ReadChar() == 'z');
+
+    /* Our own capabilities cap the result */
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_UART_SimSetPeerBaud(115200);
+    assert(UART_NegotiateBaud(UART_CAP_115200 | UART_CAP_921600) == UART_RESULT_OK);
+    assert(UART_GetBaudrate() == 921600);
+
+    /* Responder: highest common rate of the two capability masks */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_UART_SimSetTxHook(neg_initiator_hook);
+    neg_peer_len = 0;
+    neg_peer_verified = 0;
+    neg_peer_send(UART_NEG_REQUEST, UART_CAP_ALL);
+
+    assert(UART_RespondBaudNegotiation(UART_CAP_115200 | UART_CAP_460800, UART_TIMEOUT) == UART_RESULT_OK);
+    assert(UART_GetBaudrate() == 460800);
+    assert(neg_peer_verified == 1);
+
+    /* A switch waits for the last frame to leave the shifter at the old rate */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    assert(UART_SetBaudrate(9600) == UART_RESULT_OK);
+    uint32_t start = HAL_TIMER_GetTicks();
+    UART_WriteChar('!');
+    assert(UART_SetBaudrate(115200) == UART_RESULT_OK);
+    assert(HAL_TIMER_GetTicks() - start >= 10U * (HAL_TIMER_TICK_HZ / 9600U));
+
+    HAL_UART_SimReset();
+    printf("[UART] Baud negotiation test passed.\n");
+}
+
+static void test_uart_rx_spans(void)
+{
+    static uint8_t data[200];
+    UART_RxView_t view;
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)i;
+
+    /* Move the read position close to the end of the ring */
+    HAL_UART_SimFeed(data, sizeof(data));
+    UART_PollRx();
+    assert(UART_RxPeek(&view) == sizeof(data));
+    assert(view.span[0].len == sizeof(data) && view.span[1].len == 0);
+    UART_RxConsume(sizeof(data));
+
+    /* 100 new bytes wrap: two spans, pointing straight into the ring */
+    HAL_UART_SimFeed(data, 100);
+    UART_PollRx();
+    assert(UART_RxPeek(&view) == 100);
+    assert(view.span[0].len == UART_RX_BUFFER_SIZE - sizeof(data));
+    assert(view.span[1].len == 100 - view.span[0].len);
+    assert(memcmp(view.span[0].data, data, view.span[0].len) == 0);
+    assert(memcmp(view.span[1].data, data + view.span[0].len, view.span[1].len) == 0);
+
+    /* Partial consume keeps the remainder in place */
+    const uint8_t *next = view.span[0].data + 10;
+    UART_RxConsume(10);
+    assert(UART_RxPeek(&view) == 90 && view.span[0].data == next);
+    UART_RxConsume(1000);
+    assert(UART_RxPeek(&view) == 0);
+
+    /* Error counters travel with the view */
+    HAL_UART_SimInjectRxError(UART_STATUS_PE);
+    HAL_UART_SimFeed(data, 1);
+    UART_PollRx();
+    HAL_UART_SimInjectRxError(UART_STATUS_ORE);
+    HAL_UART_SimFeed(data + 1, 1);
+    UART_PollRx();
+    HAL_UART_SimSetPeerBaud(57600);
+    HAL_UART_SimFeed(data + 2, 1);
+    UART_PollRx();
+
+    assert(UART_RxPeek(&view) == 1 && view.span[0].data[0] == 1);
+    assert(view.parity_errors == 1);
+    assert(view.overruns == 1);
+    assert(view.framing_errors == 1);
+    assert(view.dropped == 0);
+    UART_RxConsume(1);
+
+    HAL_UART_SimReset();
+    printf("[UART] Zero-copy RX span test passed.\n");
+}
+
+static void copy_line(const LINE_Line_t *line, char *out)
+{
+    memcpy(out, line->span[0].data, line->span[0].len);
+    memcpy(out + line->span[0].len, line->span[1].data, line->span[1].len);
+    out[line->len] = '\0';
+}
+
+static void test_uart_line_scan(void)
+{
+    static uint8_t data[300];
+    static const uint8_t crlf[] = { '\r', '\n' };
+    static const uint8_t semi[] = { ';' };
+    LINE_Reader_t reader;
+    LINE_Line_t line;
+    UART_RxView_t view;
+    char text[UART_RX_BUFFER_SIZE + 1];
+    uint32_t seed = 12345;
+
+    /* Vector scan agrees with the byte loop for every length and offset */
+    for (uint32_t round = 0; round < 200; round++)
+    {
+        for (uint32_t i = 0; i < sizeof(data); i++)
+        {
+            seed = seed * 1103515245U + 12345U;
+            data[i] = (uint8_t)('a' + ((seed >> 16) % 26U));
+        }
+        for (uint32_t hits = round % 4U; hits > 0; hits--)
+        {
+            seed = seed * 1103515245U + 12345U;
+            data[(seed >> 8) % sizeof(data)] = (round & 1U) ? '\n' : '\r';
+        }
+
+        uint32_t offset = round % 17U;
+        uint32_t len = (uint32_t)sizeof(data) - offset - (round % 23U);
+        assert(LINE_FindAny(data + offset, len, crlf, 2) ==
+               LINE_FindAnyScalar(data + offset, len, crlf, 2));
+    }
+    memset(data, 'x', sizeof(data));
+    for (uint32_t pos = 0; pos < 40; pos++)
+    {
+        data[pos] = ';';
+        assert(LINE_FindAny(data, 40, semi, 1) == pos);
+        data[pos] = 'x';
+    }
+    assert(LINE_FindAny(data, 40, semi, 1) == 40);
+    assert(LINE_FindAny(data, 0, semi, 1) == 0);
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    LINE_Init(&reader, &(LINE_Config_t){ .delimiters = NULL, .max_line = 32 });
+
+    /* CR, LF and CRLF endings; a partial line waits for its delimiter */
+    HAL_UART_SimFeed((const uint8_t *)"get temp\r\nset rate 10\nstat\rpart", 31);
+    assert(LINE_Next(&reader, &line) && line.len == 8);
+    copy_line(&line, text);
+    assert(strcmp(text, "get temp") == 0);
+    assert(!LINE_Next(&reader, &line));   /* Not released yet */
+    LINE_Release(&reader);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "set rate 10") == 0);
+    LINE_Release(&reader);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "stat") == 0);
+    LINE_Release(&reader);
+    assert(!LINE_Next(&reader, &line));
+    assert(reader.scanned == 4);          /* "part" is not scanned twice */
+
+    HAL_UART_SimFeed((const uint8_t *)"ial\r\n", 5);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "partial") == 0);
+    LINE_Release(&reader);
+    assert(!LINE_Next(&reader, &line) && UART_RxPeek(&view) == 0);
+
+    /* A line that wraps around the ring comes back as two spans */
+    memset(data, 'w', sizeof(data));
+    HAL_UART_SimFeed(data, 200);
+    UART_PollRx();
+    UART_RxConsume(200);
+    memset(data, 'z', 30);
+    data[30] = '\n';
+    HAL_UART_SimFeed(data, 31);
+    assert(LINE_Next(&reader, &line) && line.len == 30);
+    assert(line.span[1].len != 0);
+    assert(line.span[0].len + line.span[1].len == 30);
+    LINE_Release(&reader);
+
+    /* Overlong lines are dropped up to their delimiter, even across polls */
+    memset(data, 'o', 40);
+    data[40] = '\n';
+    HAL_UART_SimFeed(data, 41);
+    HAL_UART_SimFeed((const uint8_t *)"ok\n", 3);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "ok") == 0 && reader.overlong == 1);
+    LINE_Release(&reader);
+
+    HAL_UART_SimFeed(data, 40);
+    assert(!LINE_Next(&reader, &line) && reader.overlong == 2);
+    HAL_UART_SimFeed(data, 41);
+    HAL_UART_SimFeed((const uint8_t *)"next\n", 5);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "next") == 0 && reader.overlong == 2);
+    LINE_Release(&reader);
+
+    /* Custom delimiter set */
+    LINE_Init(&reader, &(LINE_Config_t){ .delimiters = ";", .max_line = 0 });
+    HAL_UART_SimFeed((const uint8_t *)"a=1;b=2\n;", 9);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "a=1") == 0);
+    LINE_Release(&reader);
+    assert(LINE_Next(&reader, &line));
+    copy_line(&line, text);
+    assert(strcmp(text, "b=2\n") == 0);
+    LINE_Release(&reader);
+    assert(reader.lines == 2);
+
+    /* With RTS/CTS the buffer stops at the high watermark, below max_line;
+     * the undelimited line is dropped instead of wedging the sender */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_RTS_CTS);
+    LINE_Init(&reader, &(LINE_Config_t){ .delimiters = NULL, .max_line = 0 });
+    memset(data, 'f', sizeof(data));
+    data[sizeof(data) - 1U] = '\n';
+    HAL_UART_SimFeed(data, sizeof(data));
+    HAL_UART_SimFeed((const uint8_t *)"ok\n", 3);
+
+    bool got = false;
+    for (uint32_t tries = 0; tries < 10 && !got; tries++)
+        got = LINE_Next(&reader, &line);
+    assert(got && reader.overlong == 1);
+    copy_line(&line, text);
+    assert(strcmp(text, "ok") == 0);
+    LINE_Release(&reader);
+    assert(!UART_IsRxThrottled() && HAL_UART_SimPending() == 0);
+
+    HAL_UART_SimReset();
+    printf("[UART] Line scanner test passed.\n");
+}
+
+static void test_uart_rs485_multidrop(void)
+{
+    UART_Config_t master = {
+        .baudrate = 115200,
+        .stop_bits = UART_STOPBITS_1,
+        .parity = UART_PARITY_NONE,
+        .data_bits = UART_DATABITS_9,
+        .rs485 = true,
+        .de_assert_ns = 2000,
+        .de_deassert_ns = 1000
+    };
+    UART_Config_t node = {
+        .baudrate = 115200,
+        .stop_bits = UART_STOPBITS_1,
+        .parity = UART_PARITY_NONE,
+        .data_bits = UART_DATABITS_9,
+        .address_match = true,
+        .node_address = 0x21
+    };
+    const uint32_t ticks_per_us = HAL_TIMER_TICK_HZ / 1000000U;
+    HAL_UART_SimRs485Stats_t stats;
+    char buffer[8] = { 0 };
+
+    /* Master: address frame + data in one DE window, released after TC */
+    reset_uart_peer();
+    UART_Init(&master);
+    assert(UART_WriteAddressed(0x21, (const uint8_t *)"ping", 4) == UART_RESULT_OK);
+    assert(uart_tx_captured == 5 && memcmp(uart_tx_capture, "\x21ping", 5) == 0);
+    assert(!(UART1.CTRL & UART_CTRL_DE) && HAL_UART_IsTxComplete());
+
+    HAL_UART_SimGetRs485Stats(&stats);
+    assert(stats.address_frames_sent == 1 && stats.last_address_sent == 0x21);
+    assert(stats.de_lead_ticks >= 2U * ticks_per_us);
+
+    /* The lag is wall-clock time: a preempted test thread overshoots, so
+     * only a lag that is late every time counts as a failure */
+    for (uint32_t attempt = 0; attempt < 10U && stats.de_lag_ticks >= 1000U * ticks_per_us;
+         attempt++)
+    {
+        assert(UART_WriteAddressed(0x21, (const uint8_t *)"ping", 4) == UART_RESULT_OK);
+        HAL_UART_SimGetRs485Stats(&stats);
+    }
+    assert(stats.de_lag_ticks >= 1U * ticks_per_us && stats.de_lag_ticks < 1000U * ticks_per_us);
+
+    /* Plain writes are wrapped in DE too; nothing is received while driving */
+    HAL_UART_SimFeed((const uint8_t *)"ack", 3);
+    UART_WriteString("x");
+    assert(!(UART1.CTRL & UART_CTRL_DE));
+    UART_PollRx();
+    assert(UART_RxAvailable() == 3);
+
+    /* No flow control on a half-duplex bus; the port is left as it was */
+    master.flow_control = UART_FLOW_XON_XOFF;
+    assert(UART_Init(&master) == UART_RESULT_ERROR);
+    master.flow_control = UART_FLOW_RTS_CTS;
+    assert(UART_Init(&master) == UART_RESULT_ERROR);
+    assert(UART_WriteAddressed(0x21, (const uint8_t *)"x", 1) == UART_RESULT_OK);
+    assert(!(UART1.CTRL & UART_CTRL_HWFLOW));
+
+    /* Only 9-bit ports can address */
+    init_uart_flow(UART_FLOW_NONE);
+    assert(UART_WriteAddressed(0x21, (const uint8_t *)"x", 1) == UART_RESULT_ERROR);
+
+    /* Node: traffic for other nodes is dropped by the receiver itself */
+    reset_uart_peer();
+    UART_Init(&node);
+    HAL_UART_SimFeed((const uint8_t *)"xx", 2);           /* Before any address */
+    HAL_UART_SimFeedAddress(0x30);
+    HAL_UART_SimFeed((const uint8_t *)"yy", 2);
+    HAL_UART_SimFeedAddress(0x21);
+    HAL_UART_SimFeed((const uint8_t *)"hi", 2);
+    HAL_UART_SimFeedAddress(0x22);
+    HAL_UART_SimFeed((const uint8_t *)"zz", 2);
+    UART_PollRx();
+
+    assert(UART_RxAvailable() == 2);
+    buffer[0] = UART_ReadChar();
+    buffer[1] = UART_ReadChar();
+    assert(strcmp(buffer, "hi") == 0);
+    HAL_UART_SimGetRs485Stats(&stats);
+    assert(stats.muted_frames == 8);
+    assert(UART_RxAddressFrames() == 0);
+
+    /* Without address matching a 9-bit port sees every frame; address
+     * frames are counted, not stored */
+    node.address_match = false;
+    reset_uart_peer();
+    UART_Init(&node);
+    HAL_UART_SimFeedAddress(0x30);
+    HAL_UART_SimFeed((const uint8_t *)"yy", 2);
+    UART_PollRx();
+    assert(UART_RxAvailable() == 2 && UART_RxAddressFrames() == 1);
+
+    HAL_UART_SimReset();
+    init_uart_flow(UART_FLOW_NONE);
+    printf("[UART] RS-485 multidrop test passed.\n");
+}
+
+static uint8_t mux_wire[2048];
+static uint32_t mux_wire_len;
+
+static void mux_tx_sink(uint8_t byte, bool framing_error)
+{
+    (void)framing_error;
+
+    if (mux_wire_len < sizeof(mux_wire))
+        mux_wire[mux_wire_len++] = byte;
+}
+
+/* Split the captured wire bytes back into channels, noting the frame order */
+static uint32_t mux_demux(MUX_Decoder_t *dec, uint8_t *order, uint8_t rx[][600], uint32_t *rx_len)
+{
+    uint32_t pos = 0;
+    uint32_t frames = 0;
+
+    MUX_DecoderInit(dec);
+    while (pos < mux_wire_len)
+    {
+        MUX_Frame_t frame;
+        uint32_t consumed = 0;
+
+        assert(MUX_DecodeFrame(dec, &mux_wire[pos], mux_wire_len - pos, &frame, &consumed) ==
+               MUX_DECODE_OK);
+        memcpy(&rx[frame.channel][rx_len[frame.channel]], frame.data, frame.len);
+        rx_len[frame.channel] += frame.len;
+        order[frames++] = frame.channel;
+        pos += consumed;
+    }
+    return frames;
+}
+
+static void test_uart_mux(void)
+{
+    static const UART_MuxChannelConfig_t console = { .priority = 1, .weight = 1 };
+    static const UART_MuxChannelConfig_t telemetry = { .priority = 0, .weight = 1 };
+    static const UART_MuxChannelConfig_t bulk = { .priority = 1, .weight = 3 };
+    static uint8_t rx[MUX_MAX_CHANNELS][600];
+    static uint8_t bulk_data[600];
+    uint32_t rx_len[MUX_MAX_CHANNELS] = { 0 };
+    uint8_t order[64];
+    MUX_Decoder_t dec;
+    UART_MuxStats_t stats;
+    HIST_Snapshot_t snap;
+
+    for (uint32_t i = 0; i < sizeof(bulk_data); i++)
+        bulk_data[i] = (uint8_t)(i * 7U);
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_UART_SimSetTxHook(mux_tx_sink);
+    mux_wire_len = 0;
+
+    UART_MuxInit();
+    assert(UART_MuxOpen(0, &console) && UART_MuxOpen(1, &telemetry) && UART_MuxOpen(2, &bulk));
+    assert(!UART_MuxOpen(MUX_MAX_CHANNELS, &bulk));
+    assert(UART_MuxWrite(3, bulk_data, 1) == 0);     /* Not open */
+
+    /* Telemetry queued behind a bulk transfer goes out at the next chunk */
+    assert(UART_MuxWrite(2, bulk_data, 300) == 300);
+    assert(UART_MuxPoll());
+    assert(UART_MuxWrite(1, (const uint8_t *)"T=21", 4) == 4);
+    assert(UART_MuxPoll());
+
+    /* Equal priority: bulk gets three chunks for every console chunk */
+    assert(UART_MuxWrite(0, bulk_data, 200) == 200);
+    for (uint32_t i = 0; i < 8; i++)
+        assert(UART_MuxPoll());
+    UART_MuxFlush();
+    assert(!UART_MuxPoll());
+
+    uint32_t frames = mux_demux(&dec, order, rx, rx_len);
+    assert(frames == 10 + 1 + 7);
+    assert(order[0] == 2 && order[1] == 1);
+    uint32_t bulk_chunks = 0;
+    for (uint32_t i = 2; i < 10; i++)
+        bulk_chunks += (order[i] == 2);
+    assert(bulk_chunks == 6);
+
+    assert(rx_len[1] == 4 && memcmp(rx[1], "T=21", 4) == 0);
+    assert(rx_len[0] == 200 && memcmp(rx[0], bulk_data, 200) == 0);
+    assert(rx_len[2] == 300 && memcmp(rx[2], bulk_data, 300) == 0);
+    assert(dec.lost[0] == 0 && dec.lost[1] == 0 && dec.lost[2] == 0);
+
+    UART_MuxGetStats(2, &stats);
+    assert(stats.bytes_sent == 300 && stats.chunks_sent == 10);
+    assert(stats.depth == 0 && stats.max_depth == 300 && stats.dropped == 0);
+#if DRV_LATENCY_STATS
+    assert(UART_MuxGetLatency(1, &snap) && snap.count == 1);
+    assert(UART_MuxGetLatency(2, &snap) && snap.count == 1);
+#else
+    assert(!UART_MuxGetLatency(1, &snap));
+#endif
+
+    /* A full queue takes what fits and counts the rest */
+    assert(UART_MuxOpen(3, &console));
+    assert(UART_MuxWrite(3, bulk_data, sizeof(bulk_data)) == UART_MUX_QUEUE_SIZE);
+    UART_MuxGetStats(3, &stats);
+    assert(stats.depth == UART_MUX_QUEUE_SIZE && stats.dropped == sizeof(bulk_data) - UART_MUX_QUEUE_SIZE);
+    UART_MuxFlush();
+
+    /* The receiver counts chunks lost on the wire and rejects damaged frames */
+    uint8_t frame_buf[MUX_MAX_FRAME];
+    MUX_Frame_t frame;
+    uint32_t consumed;
+    uint32_t n = MUX_EncodeFrame(1, 5, (const uint8_t *)"abc", 3, frame_buf);
+
+    assert(MUX_DecodeFrame(&dec, frame_buf, n - 1, &frame, &consumed) == MUX_DECODE_INCOMPLETE);
+    assert(MUX_DecodeFrame(&dec, frame_buf, n, &frame, &consumed) == MUX_DECODE_OK);
+    assert(dec.lost[1] == 4 && consumed == n);
+    frame_buf[5] ^= 0x01;
+    assert(MUX_DecodeFrame(&dec, frame_buf, n, &frame, &consumed) == MUX_DECODE_INVALID);
+
+    HAL_UART_SimReset();
+    printf("[UART] Virtual channel mux test passed.\n");
+}
+
+static void test_uart_tokenized_log(void)
+{
+    static const char *const formats[] = { "Boot\r\n", "T=%d V=0x%08X\r\n" };
+    LOG_Frame_t frame;
+    uint32_t consumed = 0;
+
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+
+    /* Tokenized: one short frame, arguments round-trip including sign */
+    UART_LogInit(UART_LOG_TOKENIZED, NULL, 0);
+    UART_LOG2(1, -5, 0x33);
+    assert(uart_tx_captured == 5);   /* sync + id + argc + 2 one-byte args */
+    assert(uart_tx_capture[0] == LOG_FRAME_SYNC);
+    assert(LOG_DecodeFrame(uart_tx_capture, uart_tx_captured, &frame, &consumed) == LOG_DECODE_OK);
+    assert(consumed == uart_tx_captured);
+    assert(frame.id == 1 && frame.argc == 2);
+    assert(frame.args[0] == -5 && frame.args[1] == 0x33);
+
+    /* A truncated frame is reported as incomplete, not invalid */
+    assert(LOG_DecodeFrame(uart_tx_capture, 3, &frame, &consumed) == LOG_DECODE_INCOMPLETE);
+
+    /* Text mode formats on the target from the same table */
+    uart_tx_captured = 0;
+    UART_LogInit(UART_LOG_TEXT, formats, 2);
+    UART_LOG2(1, -5, 0x33);
+    assert(uart_tx_captured == strlen("T=-5 V=0x00000033\r\n"));
+    assert(memcmp(uart_tx_capture, "T=-5 V=0x00000033\r\n", uart_tx_captured) == 0);
+    assert(LOG_CountArgs(formats[1]) == 2);
+
+    UART_LogInit(UART_LOG_TEXT, NULL, 0);
+    HAL_UART_SimReset();
+    printf("[UART] Tokenized log test passed.\n");
+}
+
+static uint8_t sample_stream[4096];
+static uint32_t sample_stream_len;
+
+static void capture_sample_block(const uint8_t *data, uint32_t len)
+{
+    assert(sample_stream_len + len <= sizeof(sample_stream));
+    memcpy(&sample_stream[sample_stream_len], data, len);
+    sample_stream_len += len;
+}
+
+/* Decode the whole capture; returns the number of samples recovered */
+static uint32_t decode_sample_stream(SAMPLE_Decoder_t *dec, int32_t *out, uint32_t *unsynced)
+{
+    uint32_t pos = 0;
+    uint32_t total = 0;
+
+    while (pos < sample_stream_len)
+    {
+        uint32_t consumed = 0;
+        uint32_t count = 0;
+        uint8_t channel = 0;
+        SAMPLE_DecodeStatus_t status = SAMPLE_DecodeBlock(dec, &sample_stream[pos],
+                                                          sample_stream_len - pos, &consumed,
+                                                          &channel, &out[total], &count);
+        assert(status == SAMPLE_DECODE_OK || status == SAMPLE_DECODE_UNSYNCED);
+        if (status == SAMPLE_DECODE_UNSYNCED)
+            (*unsynced)++;
+        total += count;
+        pos += consumed;
+    }
+    return total;
+}
+
+static SWIN_Summary_t swin_summaries[8];
+static uint32_t swin_summary_count;
+static SWIN_Sample_t swin_raw[32];
+static SWIN_RawReason_t swin_raw_reason[32];
+static uint32_t swin_raw_count;
+
+static void swin_capture_summary(uint8_t channel, const SWIN_Summary_t *summary)
+{
+    (void)channel;
+    if (swin_summary_count < sizeof(swin_summaries) / sizeof(swin_summaries[0]))
+        swin_summaries[swin_summary_count] = *summary;
+    swin_summary_count++;
+}
+
+static void swin_capture_raw(uint8_t channel, const SWIN_Sample_t *sample, SWIN_RawReason_t reason)
+{
+    (void)channel;
+    if (swin_raw_count < sizeof(swin_raw) / sizeof(swin_raw[0]))
+    {
+        swin_raw_reason[swin_raw_count] = reason;
+        swin_raw[swin_raw_count] = *sample;
+    }
+    swin_raw_count++;   /* Counts past the end so the asserts notice */
+}
+
+static void test_sample_window(void)
+{
+    static SWIN_Pipeline_t pipe;
+    SWIN_Sample_t recent[SWIN_HISTORY];
+    SWIN_Stats_t stats;
+
+    SWIN_Init(&pipe, swin_capture_summary, swin_capture_raw);
+
+    /* Count windows: exact mean (rounded) and standard deviation (truncated) */
+    SWIN_ConfigureChannel(&pipe, 0, &(SWIN_ChannelConfig_t){ .window_samples = 4 });
+    SWIN_Push(&pipe, 0, 10, 100);
+    SWIN_Push(&pipe, 0, 40, 110);
+    SWIN_Push(&pipe, 0, 20, 120);
+    assert(swin_summary_count == 0);
+    SWIN_Push(&pipe, 0, 30, 130);
+    assert(swin_summary_count == 1);
+    assert(swin_summaries[0].count == 4 && swin_summaries[0].min == 10 && swin_summaries[0].max == 40);
+    assert(swin_summaries[0].mean == 25 && swin_summaries[0].stddev == 11);   /* sqrt(125) */
+    assert(swin_summaries[0].first_tick == 100 && swin_summaries[0].last_tick == 130);
+
+    SWIN_Push(&pipe, 0, -1, 140);
+    SWIN_Push(&pipe, 0, -2, 150);
+    SWIN_Flush(&pipe);
+    assert(swin_summary_count == 2 && swin_summaries[1].count == 2);
+    assert(swin_summaries[1].mean == -2 && swin_summaries[1].stddev == 0);    /* -1.5, sd 0.5 */
+    SWIN_Flush(&pipe);
+    assert(swin_summary_count == 2);
+
+    /* Full int32 range: exact mean and standard deviation */
+    SWIN_Push(&pipe, 0, INT32_MIN, 160);
+    SWIN_Push(&pipe, 0, INT32_MAX, 170);
+    SWIN_Flush(&pipe);
+    assert(swin_summary_count == 3 && swin_summaries[2].mean == 0);
+    assert(swin_summaries[2].stddev == INT32_MAX);                 /* (2^32 - 1) / 2 */
+
+    /* A full window of extremes: the largest sums the window can hold */
+    SWIN_ConfigureChannel(&pipe, 0, &(SWIN_ChannelConfig_t){ .window_samples = SWIN_MAX_WINDOW });
+    for (uint32_t i = 0; i < SWIN_MAX_WINDOW; i++)
+        SWIN_Push(&pipe, 0, (i % 4U == 3U) ? INT32_MIN : INT32_MAX, 200U + i);
+    assert(swin_summary_count == 4 && swin_summaries[3].count == SWIN_MAX_WINDOW);
+    assert(swin_summaries[3].mean == 1073741823);                  /* 2^30 - 3/4 */
+    assert(swin_summaries[3].stddev == 1859775392);                /* (2^32 - 1) * sqrt(3) / 4 */
+
+    /* Time windows close when a sample falls past the window span */
+    swin_summary_count = 0;
+    SWIN_ConfigureChannel(&pipe, 1, &(SWIN_ChannelConfig_t){ .window_ticks = 100 });
+    SWIN_Push(&pipe, 1, 1000000, UINT32_MAX - 10U);   /* Across the tick wrap */
+    SWIN_Push(&pipe, 1, 1000002, 39);
+    SWIN_Push(&pipe, 1, 1000004, 88);
+    assert(swin_summary_count == 0);
+    SWIN_Push(&pipe, 1, 7, 89);
+    assert(swin_summary_count == 1 && swin_summaries[0].count == 3);
+    assert(swin_summaries[0].mean == 1000002 && swin_summaries[0].stddev == 1);
+
+    /* Decimation forwards every Nth sample unchanged */
+    SWIN_ConfigureChannel(&pipe, 2, &(SWIN_ChannelConfig_t){ .decimation = 3 });
+    for (int32_t i = 0; i < 9; i++)
+        SWIN_Push(&pipe, 2, i, (uint32_t)i);
+    assert(swin_raw_count == 3);
+    assert(swin_raw[0].value == 2 && swin_raw[1].value == 5 && swin_raw[2].value == 8);
+    assert(swin_raw_reason[2] == SWIN_RAW_DECIMATED);
+
+    /* A trigger sends the history before it and the samples after it, once */
+    swin_raw_count = 0;
+    SWIN_ConfigureChannel(&pipe, 3, &(SWIN_ChannelConfig_t){
+        .trigger = true, .trigger_low = 0, .trigger_high = 100, .burst_pre = 2, .burst_post = 2
+    });
+    static const int32_t trace[] = { 50, 51, 52, 53, 200, 54, 55, 56, 300, 301, 302, 303, 57, 400 };
+    for (uint32_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++)
+        SWIN_Push(&pipe, 3, trace[i], i);
+
+    static const int32_t sent[] = { 52, 53, 200, 54, 55, 56, 300, 301, 302, 303, 57, 400 };
+    assert(swin_raw_count == sizeof(sent) / sizeof(sent[0]));
+    for (uint32_t i = 0; i < swin_raw_count; i++)
+        assert(swin_raw[i].value == sent[i] && swin_raw_reason[i] == SWIN_RAW_BURST);
+    assert(swin_raw[2].tick == 4);
+
+    SWIN_GetStats(&pipe, 3, &stats);
+    assert(stats.samples == 14 && stats.bursts == 3 && stats.raw_sent == swin_raw_count);
+    assert(stats.windows == 0);
+
+    /* The history ring keeps the latest SWIN_HISTORY samples */
+    assert(SWIN_GetRecent(&pipe, 3, recent, 2) == 2);
+    assert(recent[0].value == 57 && recent[1].value == 400 && recent[1].tick == 13);
+    swin_raw_count = 0;
+    for (int32_t i = 0; i < 100; i++)
+        SWIN_Push(&pipe, 2, i, (uint32_t)i);
+    assert(swin_raw_count == 33);   /* Channel 2 still decimates by 3 */
+    assert(SWIN_GetRecent(&pipe, 2, recent, SWIN_HISTORY) == SWIN_HISTORY);
+    assert(recent[0].value == 100 - (int32_t)SWIN_HISTORY && recent[SWIN_HISTORY - 1U].value == 99);
+
+    printf("[SWIN] Windowed aggregation test passed.\n");
+}
+
+static void test_sample_codec(void)
+{
+    static int32_t input[256];
+    static int32_t output[256];
+    SAMPLE_Encoder_t enc;
+    SAMPLE_Decoder_t dec;
+    uint32_t unsynced = 0;
+
+    /* Slowly drifting signal plus extremes: exact round trip, ~1 byte/sample */
+    for (uint32_t i = 0; i < 256; i++)
+        input[i] = 2500 + (int32_t)(i % 7) - 3;
+    input[100] = INT32_MIN;
+    input[101] = INT32_MAX;
+
+    sample_stream_len = 0;
+    SAMPLE_EncoderInit(&enc, &(SAMPLE_EncoderConfig_t){ .output = capture_sample_block });
+    for (uint32_t i = 0; i < 256; i++)
+        SAMPLE_Push(&enc, 0, input[i]);
+    SAMPLE_Flush(&enc);
+    assert(enc.samples_in == 256 && enc.bytes_out == sample_stream_len);
+    assert(sample_stream_len < 256 * 3 / 2);
+
+    SAMPLE_DecoderInit(&dec);
+    assert(decode_sample_stream(&dec, output, &unsynced) == 256);
+    assert(memcmp(input, output, sizeof(input)) == 0);
+    assert(unsynced == 0 && dec.blocks_lost == 0);
+
+    /* Run-length mode: a constant channel costs a few bytes per block */
+    sample_stream_len = 0;
+    SAMPLE_EncoderInit(&enc, &(SAMPLE_EncoderConfig_t){ .block_size = 32, .run_length = true,
+                                                        .output = capture_sample_block });
+    for (uint32_t i = 0; i < 64; i++)
+        SAMPLE_Push(&enc, 3, 0x33);
+    SAMPLE_Flush(&enc);
+    assert(sample_stream_len <= 2 * (SAMPLE_HEADER_BYTES + 4));
+
+    SAMPLE_DecoderInit(&dec);
+    assert(decode_sample_stream(&dec, output, &unsynced) == 64);
+    for (uint32_t i = 0; i < 64; i++)
+        assert(output[i] == 0x33);
+
+    /* A lost block desynchronizes the channel until the next keyframe */
+    sample_stream_len = 0;
+    SAMPLE_EncoderInit(&enc, &(SAMPLE_EncoderConfig_t){ .block_size = 4, .keyframe_interval = 4,
+                                                        .output = capture_sample_block });
+    for (uint32_t i = 0; i < 32; i++)
+        SAMPLE_Push(&enc, 1, (int32_t)i * 10);
+    SAMPLE_Flush(&enc);
+
+    uint32_t first = SAMPLE_HEADER_BYTES + sample_stream[4] + 1U;
+    uint32_t second = SAMPLE_HEADER_BYTES + sample_stream[first + 4] + 1U;
+    memmove(&sample_stream[first], &sample_stream[first + second],
+            sample_stream_len - first - second);
+    sample_stream_len -= second;
+
+    unsynced = 0;
+    SAMPLE_DecoderInit(&dec);
+    assert(decode_sample_stream(&dec, output, &unsynced) == 32 - 4 * 3);
+    assert(dec.blocks_lost == 1 && unsynced == 2);
+    assert(output[4] == 160);   /* Resumed exactly at the keyframe (block 4) */
+
+    /* Corruption is rejected by the checksum */
+    sample_stream[SAMPLE_HEADER_BYTES] ^= 0x01;
+    uint32_t consumed;
+    uint32_t count;
+    uint8_t channel;
+    assert(SAMPLE_DecodeBlock(&dec, sample_stream, sample_stream_len, &consumed,
+                              &channel, output, &count) == SAMPLE_DECODE_INVALID);
+
+    printf("[SAMPLE] Delta/varint codec test passed.\n");
+}
+
+static void test_histogram(void)
+{
+    static HIST_Histogram_t hist;
+    HIST_Snapshot_t snap;
+    HIST_Snapshot_t merged = { .min = UINT32_MAX };
+
+    /* Bucket boundaries: exact below 2 * HIST_SUB_COUNT, contiguous above */
+    for (uint32_t v = 0; v < 2U * HIST_SUB_COUNT; v++)
+        assert(HIST_BucketIndex(v) == v);
+    for (uint32_t i = 1; i < HIST_BUCKETS; i++)
+        assert(HIST_BucketLowest(i) == HIST_BucketHighest(i - 1) + 1U);
+    assert(HIST_BucketHighest(HIST_BUCKETS - 1U) == UINT32_MAX);
+    assert(HIST_BucketIndex(UINT32_MAX) == HIST_BUCKETS - 1U);
+
+    /* 1..10000: percentiles within one sub-bucket of the exact value */
+    HIST_Reset(&hist);
+    HIST_Snapshot(&hist, &snap);
+    assert(snap.count == 0 && HIST_ValueAt(&snap, HIST_P50) == 0);
+
+    for (uint32_t v = 1; v <= 10000; v++)
+        HIST_Record(&hist, v);
+    HIST_Snapshot(&hist, &snap);
+
+    assert(snap.count == 10000 && snap.min == 1 && snap.max == 10000);
+    assert(snap.sum == 10000ULL * 10001ULL / 2ULL);
+
+    uint32_t p50 = HIST_ValueAt(&snap, HIST_P50);
+    uint32_t p99 = HIST_ValueAt(&snap, HIST_P99);
+    assert(p50 >= 5000 && p50 <= 5000 + 5000 / HIST_SUB_COUNT);
+    assert(p99 >= 9900 && p99 <= 9900 + 9900 / HIST_SUB_COUNT);
+    assert(HIST_ValueAt(&snap, 10000) == 10000);   /* Clamped to max */
+
+    /* Merging keeps counts and extremes */
+    HIST_Merge(&merged, &snap);
+    HIST_Reset(&hist);
+    HIST_Record(&hist, 0);
+    HIST_Snapshot(&hist, &snap);
+    HIST_Merge(&merged, &snap);
+    assert(merged.count == 10001 && merged.min == 0 && merged.max == 10000);
+
+    printf("[HIST] Log-linear histogram test passed.\n");
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                I2C TESTS                                   */
 /* -------------------------------------------------------------------------- */
@@ -125,17 +1246,1202 @@ static void test_i2c_read(void)
     printf("[I2C] Read test passed.\n");
 }
 
-/* -------------------------------------------------------------------------- */
-/*                                     MAIN                                   */
-/* -------------------------------------------------------------------------- */
+static void test_i2c_transfer(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    uint8_t reg = 0x05;
+    uint8_t header[2] = { 0 };
+    uint8_t payload[3] = { 0 };
+    HIST_Snapshot_t snap;
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* Register read: write pointer, repeated START, read, one STOP */
+    I2C_Msg_t reg_read[] = {
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x48, .flags = I2C_M_RD, .len = 2, .buf = header },
+    };
+    assert(I2C_Transfer(reg_read, 2) == I2C_STATUS_OK);
+    assert(header[0] == 0x33 && header[1] == 0x33);
+    assert(HAL_I2C_SimGetStartCount() == 2 && HAL_I2C_SimGetStopCount() == 1);
+    assert((I2C1.CR & I2C_CR_ACK) == 0);   /* Last byte NACKed */
+
+    /* NOSTART read continues the previous one: no new address, ACK between */
+    I2C_Msg_t split_read[] = {
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x48, .flags = I2C_M_RD, .len = 2, .buf = header },
+        { .addr = 0x48, .flags = I2C_M_RD | I2C_M_NOSTART, .len = 3, .buf = payload },
+    };
+    HAL_I2C_SimClearFaults();
+    assert(I2C_Transfer(split_read, 3) == I2C_STATUS_OK);
+    assert(payload[2] == 0x33);
+    assert(HAL_I2C_SimGetStartCount() == 2 && HAL_I2C_SimGetStopCount() == 1);
+
+    /* Several targets in one tenure */
+    I2C_Msg_t multi[] = {
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x50, .flags = 0, .len = 2, .buf = header },
+        { .addr = 0x51, .flags = I2C_M_RD, .len = 1, .buf = payload },
+    };
+    HAL_I2C_SimClearFaults();
+    assert(I2C_Transfer(multi, 3) == I2C_STATUS_OK);
+    assert(HAL_I2C_SimGetStartCount() == 3 && HAL_I2C_SimGetStopCount() == 1);
+
+    /* A NACK aborts with a single STOP... */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    multi[0].addr = 0x49;
+    assert(I2C_Transfer(multi, 3) == I2C_STATUS_ADDR_NACK);
+    assert(HAL_I2C_SimGetStartCount() == 1 && HAL_I2C_SimGetStopCount() == 1);
+
+    /* ...unless the segment ignores it */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    multi[0].flags = I2C_M_IGNORE_NAK;
+    assert(I2C_Transfer(multi, 3) == I2C_STATUS_OK);
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_DATA, 1);
+    multi[0].flags = 0;
+    assert(I2C_Transfer(multi, 3) == I2C_STATUS_DATA_NACK);
+    HAL_I2C_SimClearFaults();
+
+    /* Invalid sequences never touch the bus */
+    I2C_Msg_t bad_first[] = { { .addr = 0x48, .flags = I2C_M_NOSTART, .len = 1, .buf = &reg } };
+    I2C_Msg_t bad_turn[] = {
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x48, .flags = I2C_M_RD | I2C_M_NOSTART, .len = 1, .buf = header },
+    };
+    assert(I2C_Transfer(bad_first, 1) == I2C_STATUS_ERROR);
+    assert(I2C_Transfer(bad_turn, 2) == I2C_STATUS_ERROR);
+    assert(I2C_Transfer(reg_read, 0) == I2C_STATUS_ERROR);
+    assert(HAL_I2C_SimGetStartCount() == 0);
+
+#if DRV_LATENCY_STATS
+    assert(I2C_GetLatency(I2C_LATENCY_TRANSFER, &snap) && snap.count == 6);
+#else
+    assert(!I2C_GetLatency(I2C_LATENCY_TRANSFER, &snap));
+#endif
+
+    printf("[I2C] Message-array transfer test passed.\n");
+}
+
+#define CACHE_READERS   4U
+
+static atomic_uint cache_waiters;
+static pthread_mutex_t cache_bus_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local bool cache_thread_waited;
+
+static void cache_lock_bus(void)
+{
+    /* Hold the fetch until every other reader is queued behind it */
+    for (uint32_t spin = 0; spin < 100000000U; spin++)
+    {
+        if (atomic_load(&cache_waiters) == CACHE_READERS - 1U)
+            break;
+        sched_yield();
+    }
+    pthread_mutex_lock(&cache_bus_lock);
+}
+
+static void cache_unlock_bus(void)
+{
+    pthread_mutex_unlock(&cache_bus_lock);
+}
+
+static void cache_wait(void)
+{
+    if (!cache_thread_waited)
+    {
+        cache_thread_waited = true;
+        atomic_fetch_add(&cache_waiters, 1U);
+    }
+    sched_yield();
+}
+
+static void *cache_reader(void *arg)
+{
+    uint8_t value[2] = { 0 };
+    I2C_Status_t *status = arg;
+
+    *status = SCACHE_Read(0x48, 0x00, value);
+    if (value[0] != 0x33 || value[1] != 0x33)
+        *status = I2C_STATUS_ERROR;
+    return NULL;
+}
+
+static void test_i2c_pipelined_read(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_FAST,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    static const uint8_t pattern[] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+    const uint32_t byte_ticks = 9U * HAL_TIMER_TICK_HZ / I2C_SPEED_FAST;
+    HAL_I2C_SimRxStats_t rx;
+    uint8_t buffer[16];
+    uint8_t reg = 0x00;
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* Every length, including the 1- and 2-byte special cases: bytes arrive
+     * in order, the last one is NACKed and nothing is left unread */
+    for (uint32_t len = 1; len <= sizeof(pattern); len++)
+    {
+        HAL_I2C_SimClearFaults();
+        HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+        memset(buffer, 0, sizeof(buffer));
+
+        assert(I2C_ReadBuffer(0x48, buffer, len) == I2C_STATUS_OK);
+        assert(memcmp(buffer, pattern, len) == 0);
+
+        HAL_I2C_SimGetRxStats(&rx);
+        assert(rx.bytes == len && rx.acked_last == 0 && rx.unread == 0);
+        assert(HAL_I2C_SimGetStopCount() == 1);
+        assert(!(I2C1.CR & I2C_CR_POS));
+    }
+
+    /* A read ending in a repeated START, and one continued with NOSTART */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+    I2C_Msg_t msgs[] = {
+        { .addr = 0x48, .flags = I2C_M_RD, .len = 2, .buf = buffer },
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x48, .flags = I2C_M_RD, .len = 1, .buf = buffer + 2 },
+        { .addr = 0x48, .flags = I2C_M_RD | I2C_M_NOSTART, .len = 3, .buf = buffer + 3 },
+    };
+    assert(I2C_Transfer(msgs, 4) == I2C_STATUS_OK);
+    assert(memcmp(buffer, pattern, 6) == 0);
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.bytes == 6 && rx.acked_last == 0 && rx.unread == 0);
+    assert(HAL_I2C_SimGetStartCount() == 3 && HAL_I2C_SimGetStopCount() == 1);
+
+    /* The simulator catches the classic mistake: NACK decided after reading
+     * the last byte is too late, the slave has already been ACKed */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SendACK();
+    HAL_I2C_GenerateStart();
+    HAL_I2C_SendAddress(0x48, I2C_READ);
+    HAL_I2C_ClearAddress();
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        assert(HAL_I2C_IsRxReady());
+        buffer[i] = HAL_I2C_ReadData();
+    }
+    HAL_I2C_SendNACK();
+    HAL_I2C_GenerateStop();
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.acked_last == 1);
+
+    /* With bus timing on, bytes take real time and the result is the same */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimSetWireTiming(true);
+    uint32_t start = HAL_TIMER_GetTicks();
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    uint32_t elapsed = HAL_TIMER_GetTicks() - start;
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.bytes == sizeof(buffer) && rx.acked_last == 0 && rx.unread == 0);
+    assert(elapsed >= sizeof(buffer) * byte_ticks);
+
+    HAL_I2C_SimClearFaults();
+    printf("[I2C] Pipelined burst read test passed.\n");
+}
+
+/* I2C_ReadStream consumer: checks the data, optionally slow or stopping */
+typedef struct
+{
+    const uint8_t *expect;
+    uint32_t expect_len;
+    uint32_t offset;
+    uint32_t chunks;
+    uint32_t last_len;
+    uint32_t stop_after;     /* Chunks to accept (0: all) */
+    uint32_t work_ticks;     /* Time spent per chunk */
+} StreamCheck_t;
+
+static bool stream_check_chunk(void *ctx, const uint8_t *data, uint32_t len)
+{
+    StreamCheck_t *check = ctx;
+    uint32_t start = HAL_TIMER_GetTicks();
+
+    for (uint32_t i = 0; i < len; i++)
+        assert(data[i] == check->expect[(check->offset + i) % check->expect_len]);
+
+    check->offset += len;
+    check->chunks++;
+    check->last_len = len;
+
+    while (HAL_TIMER_GetTicks() - start < check->work_ticks)
+        ;
+    return check->stop_after == 0 || check->chunks < check->stop_after;
+}
+
+static void test_i2c_stream_read(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_FAST,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    static uint8_t pattern[61];   /* Not a divisor of the chunk size */
+    const uint8_t mem_addr[2] = { 0x00, 0x00 };
+    uint8_t chunk[64];
+    HAL_I2C_SimRxStats_t rx;
+
+    for (uint32_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t)(i * 7U + 1U);
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* 10000 bytes through a 64-byte buffer: one address setup, one STOP */
+    HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+    StreamCheck_t check = { .expect = pattern, .expect_len = sizeof(pattern) };
+    I2C_Stream_t stream = {
+        .cmd = mem_addr, .cmd_len = sizeof(mem_addr), .len = 10000,
+        .chunk = chunk, .chunk_len = sizeof(chunk),
+        .on_chunk = stream_check_chunk, .ctx = &check
+    };
+    assert(I2C_ReadStream(0x50, &stream) == I2C_STATUS_OK);
+    assert(stream.delivered == 10000 && check.offset == 10000);
+    assert(check.chunks == 157 && check.last_len == 10000 % 64);
+    assert(HAL_I2C_SimGetStartCount() == 2 && HAL_I2C_SimGetStopCount() == 1);
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.bytes == 10000 && rx.acked_last == 0 && rx.unread == 0);
+
+    /* A slow consumer pauses the bus instead of losing bytes */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+    HAL_I2C_SimSetWireTiming(true);
+    check = (StreamCheck_t){ .expect = pattern, .expect_len = sizeof(pattern),
+                             .work_ticks = 5U * 9U * HAL_TIMER_TICK_HZ / I2C_SPEED_FAST };
+    stream.cmd = NULL;
+    stream.cmd_len = 0;
+    stream.len = 640;
+    assert(I2C_ReadStream(0x50, &stream) == I2C_STATUS_OK);
+    assert(stream.delivered == 640 && check.chunks == 10);
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.bytes == 640 && rx.stalls >= 9 && rx.unread == 0);
+    assert(HAL_I2C_SimGetStartCount() == 1);
+    HAL_I2C_SimSetWireTiming(false);
+
+    /* Stopping early costs three extra bytes and still ends with NACK + STOP */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+    check = (StreamCheck_t){ .expect = pattern, .expect_len = sizeof(pattern), .stop_after = 2 };
+    stream.len = 10000;
+    assert(I2C_ReadStream(0x50, &stream) == I2C_STATUS_OK);
+    assert(stream.delivered == 128 && check.chunks == 2);
+    HAL_I2C_SimGetRxStats(&rx);
+    assert(rx.bytes == 131 && rx.acked_last == 0 && rx.unread == 0);
+    assert(HAL_I2C_SimGetStopCount() == 1);
+
+    /* A NACKed address delivers nothing */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    check = (StreamCheck_t){ .expect = pattern, .expect_len = sizeof(pattern) };
+    assert(I2C_ReadStream(0x50, &stream) == I2C_STATUS_ADDR_NACK);
+    assert(stream.delivered == 0 && check.chunks == 0);
+
+    stream.on_chunk = NULL;
+    assert(I2C_ReadStream(0x50, &stream) == I2C_STATUS_ERROR);
+
+    HAL_I2C_SimClearFaults();
+    printf("[I2C] Chunked stream read test passed.\n");
+}
+
+static uint32_t target_write_reg;
+static uint32_t target_write_len;
+static uint32_t target_writes;
+
+static void target_on_write(uint32_t reg, uint32_t len)
+{
+    target_write_reg = reg;
+    target_write_len = len;
+    target_writes++;
+}
+
+static void test_i2c_target(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_FAST,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    uint8_t map[8] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7 };
+    I2CT_Config_t target = {
+        .own_address = 0x2A,
+        .map = map,
+        .map_size = sizeof(map),
+        .writable_size = 4,         /* 4..7 are read-only status */
+        .on_write = target_on_write
+    };
+    I2CT_Stats_t stats;
+    uint8_t reg;
+    uint8_t buffer[8];
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+    assert(I2CT_Init(&target));
+    HAL_I2C_SimSetTargetIrq(I2CT_EventIRQHandler);
+    target_writes = 0;
+
+    /* Controller writes land directly in the map */
+    assert(I2C_WriteBuffer(0x2A, (const uint8_t *)"\x01\x11\x12", 3) == I2C_STATUS_OK);
+    assert(map[0] == 0xA0 && map[1] == 0x11 && map[2] == 0x12 && map[3] == 0xA3);
+    assert(target_writes == 1 && target_write_reg == 1 && target_write_len == 2);
+
+    /* Register read: pointer write, repeated START, read across the
+     * read-only part; the pointer auto-increments. The target preloads
+     * 0xA7 behind the NACKed last byte and puts it back */
+    reg = 0x02;
+    I2C_Msg_t msgs[] = {
+        { .addr = 0x2A, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x2A, .flags = I2C_M_RD, .len = 5, .buf = buffer },
+    };
+    assert(I2C_Transfer(msgs, 2) == I2C_STATUS_OK);
+    assert(memcmp(buffer, "\x12\xA3\xA4\xA5\xA6", 5) == 0);
+    assert(I2CT_GetPointer() == 7);
+    assert(target_writes == 1);    /* A pointer-only write changes nothing */
+
+    /* A plain read continues from the pointer, then runs off the map */
+    assert(I2C_ReadBuffer(0x2A, buffer, 3) == I2C_STATUS_OK);
+    assert(buffer[0] == 0xA7 && buffer[1] == 0xFF && buffer[2] == 0xFF);
+
+    /* Writing into the read-only part is NACKed; the bytes before it stick */
+    assert(I2C_WriteBuffer(0x2A, (const uint8_t *)"\x03\x33\x44", 3) == I2C_STATUS_DATA_NACK);
+    assert(map[3] == 0x33 && map[4] == 0xA4);
+    assert(target_writes == 2 && target_write_reg == 3 && target_write_len == 1);
+
+    I2CT_GetStats(&stats);
+    assert(stats.transactions == 5);
+    assert(stats.bytes_written == 3 && stats.write_nacks == 1);
+    assert(stats.bytes_read == 6 && stats.read_overruns == 2);
+
+    /* Other addresses still reach the simulated slave */
+    assert(I2C_ReadByte(0x48, buffer) == I2C_STATUS_OK && buffer[0] == 0x33);
+
+    /* A disabled target no longer answers for its address */
+    I2CT_Deinit();
+    assert(I2C_ReadByte(0x2A, buffer) == I2C_STATUS_OK && buffer[0] == 0x33);
+    I2CT_GetStats(&stats);
+    assert(stats.transactions == 5);
+
+    HAL_I2C_SimSetTargetIrq(NULL);
+    printf("[I2C] Target mode register map test passed.\n");
+}
+
+static void test_sensor_cache(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    const SCACHE_Hooks_t hooks = {
+        .lock = cache_lock_bus,
+        .unlock = cache_unlock_bus,
+        .wait = cache_wait
+    };
+    const uint32_t ticks_per_ms = HAL_TIMER_TICK_HZ / 1000U;
+    pthread_t threads[CACHE_READERS];
+    I2C_Status_t results[CACHE_READERS];
+    SCACHE_Stats_t stats;
+    uint8_t value[2] = { 0 };
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+    SCACHE_Init(NULL);
+
+    assert(!SCACHE_Register(0x48, 0x00, 0, 1000));
+    assert(!SCACHE_Register(0x48, 0x00, SCACHE_MAX_VALUE + 1U, 1000));
+    assert(SCACHE_Register(0x48, 0x00, 2, 10000));   /* 10 ms conversion time */
+    assert(SCACHE_Read(0x49, 0x00, value) == I2C_STATUS_ERROR);
+
+    /* First read goes to the bus (one transfer), the rest are hits */
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK && value[0] == 0x33);
+    for (uint32_t i = 0; i < 9; i++)
+        assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK);
+    assert(HAL_I2C_SimGetStopCount() == 1);
+    SCACHE_GetStats(&stats);
+    assert(stats.misses == 1 && stats.hits == 9);
+
+    /* Expiry and invalidation both cause a refetch */
+    HAL_TIMER_SimAdvance(11U * ticks_per_ms);
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK);
+    SCACHE_Invalidate(0x48, 0x00);
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK);
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK);
+    assert(HAL_I2C_SimGetStopCount() == 3);
+
+    /* Failed fetches are not cached */
+    HAL_TIMER_SimAdvance(11U * ticks_per_ms);
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_ADDR_NACK);
+    assert(SCACHE_Read(0x48, 0x00, value) == I2C_STATUS_OK);
+    SCACHE_GetStats(&stats);
+    assert(stats.errors == 1 && stats.misses == 5);
+
+    /* A 100 s TTL is capped at ~44 s instead of wrapping to ~10 s */
+    assert(SCACHE_Register(0x48, 0x01, 2, 100000000U));
+    assert(SCACHE_Register(0x48, 0x02, 1, 10000));
+    assert(SCACHE_Read(0x48, 0x01, value) == I2C_STATUS_OK);
+    HAL_TIMER_SimAdvance(20000U * ticks_per_ms);
+    assert(SCACHE_Read(0x48, 0x01, value) == I2C_STATUS_OK);
+    SCACHE_GetStats(&stats);
+    assert(stats.misses == 6);
+
+    /* A full timer period later the stamp looks 20 s old again; it is stale */
+    for (uint32_t quarter = 0; quarter < 4; quarter++)
+    {
+        HAL_TIMER_SimAdvance(1UL << 30);
+        assert(SCACHE_Read(0x48, 0x02, value) == I2C_STATUS_OK);
+    }
+    assert(SCACHE_Read(0x48, 0x01, value) == I2C_STATUS_OK);
+    SCACHE_GetStats(&stats);
+    assert(stats.misses == 11);
+
+    /* Concurrent misses: one leader reads the bus, the others share it */
+    SCACHE_Init(&hooks);
+    assert(SCACHE_Register(0x48, 0x00, 2, 10000));
+    HAL_I2C_SimClearFaults();
+    atomic_store(&cache_waiters, 0U);
+
+    for (uint32_t t = 0; t < CACHE_READERS; t++)
+        pthread_create(&threads[t], NULL, cache_reader, &results[t]);
+    for (uint32_t t = 0; t < CACHE_READERS; t++)
+    {
+        pthread_join(threads[t], NULL);
+        assert(results[t] == I2C_STATUS_OK);
+    }
+
+    SCACHE_GetStats(&stats);
+    assert(stats.misses == 1 && stats.coalesced == CACHE_READERS - 1U && stats.hits == 0);
+    assert(HAL_I2C_SimGetStopCount() == 1);
+
+    printf("[CACHE] Sensor value cache test passed.\n");
+}
+
+static void test_i2c_bus_faults(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    const uint32_t ticks_per_ms = HAL_TIMER_TICK_HZ / 1000U;
+    I2C_BusStats_t stats;
+    HIST_Snapshot_t snap;
+    uint8_t value = 0;
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* Stuck SDA: recovered before the START, transaction succeeds */
+    HAL_I2C_SimStickSDA(5);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK && value == 0x33);
+    assert(HAL_I2C_SimGetRecoveryPulses() == 5);
+    I2C_GetBusStats(&stats);
+    assert(stats.recoveries == 1 && stats.recovery_failures == 0);
+#if DRV_LATENCY_STATS
+    assert(I2C_GetLatency(I2C_LATENCY_RECOVERY, &snap) && snap.count == 1);
+    assert(HAL_TIMER_TicksToNs(snap.max) < 1000000U);   /* Well under 1 ms */
+#else
+    assert(!I2C_GetLatency(I2C_LATENCY_RECOVERY, &snap));
+#endif
+
+    /* A slave that never lets go: bounded to 9 pulses, reported */
+    HAL_I2C_SimClearFaults();
+    HAL_I2C_SimStickSDA(HAL_I2C_SIM_STUCK_FOREVER);
+    assert(I2C_WriteByte(0x48, 0x00) == I2C_STATUS_BUS_STUCK);
+    assert(HAL_I2C_SimGetRecoveryPulses() == I2C_RECOVERY_PULSES);
+    I2C_GetBusStats(&stats);
+    assert(stats.recovery_failures == 1);
+
+    /* Once released, the bus works again without a re-init */
+    HAL_I2C_SimClearFaults();
+    assert(I2C_WriteByte(0x48, 0x00) == I2C_STATUS_OK);
+
+    /* Clock stretching below the bound is waited out... */
+    HAL_I2C_SimStretchClock(ticks_per_ms, 2);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK);
+
+    /* ...above it the phase is aborted */
+    HAL_I2C_SimStretchClock((I2C_STRETCH_TIMEOUT_US / 1000U + 5U) * ticks_per_ms, 1);
+    assert(I2C_WriteByte(0x48, 0x00) == I2C_STATUS_TIMEOUT);
+    I2C_GetBusStats(&stats);
+    assert(stats.stretch_timeouts == 1);
+    HAL_I2C_SimClearFaults();
+
+    /* NACKs are reported per phase and do not poison the next transfer */
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_ADDR_NACK);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK);
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_DATA, 1);
+    assert(I2C_WriteBuffer(0x48, (const uint8_t *)"ab", 2) == I2C_STATUS_DATA_NACK);
+    I2C_GetBusStats(&stats);
+    assert(stats.nacks == 2);
+
+    /* Corrupted data is delivered as-is (no PEC in this driver) */
+    HAL_I2C_SimCorruptData(0xFF, 1);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK && value == 0xCC);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK && value == 0x33);
+
+    HAL_I2C_SimClearFaults();
+    printf("[I2C] Bus fault recovery test passed.\n");
+}
+
+#define SLOW_TX_TICKS   4800U   /* 100 us per byte at 48 MHz */
+
+static void slow_uart_tx(uint8_t byte, bool framing_error)
+{
+    capture_uart_tx(byte, framing_error);
+    HAL_TIMER_SimAdvance(SLOW_TX_TICKS);
+}
+
+static void test_i2c_speed_profiles(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    I2C_BusStats_t stats;
+    uint8_t buffer[8];
+    uint8_t reg = 0x00;
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* A fast sensor and an EEPROM limited to 100 kHz share the bus */
+    assert(I2C_SetDeviceSpeed(0x48, I2C_SPEED_FAST_PLUS));
+    assert(I2C_GetDeviceSpeed(0x48) == I2C_SPEED_FAST_PLUS);
+    assert(I2C_GetDeviceSpeed(0x50) == I2C_SPEED_STANDARD);
+
+    /* Switching happens once, not per transaction */
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    assert(I2C1.CCR == I2C_SPEED_FAST_PLUS);
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    assert(I2C_WriteByte(0x48, 0x01) == I2C_STATUS_OK);
+    I2C_GetBusStats(&stats);
+    assert(stats.speed_switches == 1);
+
+    assert(I2C_WriteByte(0x50, 0x02) == I2C_STATUS_OK);
+    assert(I2C1.CCR == I2C_SPEED_STANDARD);
+    I2C_GetBusStats(&stats);
+    assert(stats.speed_switches == 2);
+
+    /* With wire timing, the fast device's reads take a tenth of the time */
+    HAL_I2C_SimSetWireTiming(true);
+    uint32_t start = HAL_TIMER_GetTicks();
+    assert(I2C_ReadBuffer(0x50, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    uint32_t slow = HAL_TIMER_GetTicks() - start;
+    uint32_t fast = UINT32_MAX;
+    for (uint32_t run = 0; run < 3; run++)   /* Best of three: host jitter */
+    {
+        start = HAL_TIMER_GetTicks();
+        assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+        uint32_t took = HAL_TIMER_GetTicks() - start;
+        if (took < fast)
+            fast = took;
+    }
+    HAL_I2C_SimSetWireTiming(false);
+    assert(slow >= sizeof(buffer) * (9U * HAL_TIMER_TICK_HZ / I2C_SPEED_STANDARD));
+    assert(fast < slow / 2U);
+
+    /* A transfer touching both runs at the slower speed */
+    I2C_Msg_t msgs[] = {
+        { .addr = 0x48, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = 0x50, .flags = I2C_M_RD, .len = 2, .buf = buffer },
+    };
+    assert(I2C_Transfer(msgs, 2) == I2C_STATUS_OK);
+    assert(I2C1.CCR == I2C_SPEED_STANDARD);
+
+    /* Bus recovery keeps the speed in effect */
+    assert(I2C_WriteByte(0x48, 0x03) == I2C_STATUS_OK);
+    HAL_I2C_SimStickSDA(3);
+    assert(I2C_RecoverBus() == I2C_STATUS_OK);
+    assert(I2C1.CCR == I2C_SPEED_FAST_PLUS);
+
+    /* Removing the profile falls back to the bus default */
+    assert(I2C_SetDeviceSpeed(0x48, I2C_SPEED_BUS_DEFAULT));
+    assert(I2C_GetDeviceSpeed(0x48) == I2C_SPEED_STANDARD);
+    assert(I2C_WriteByte(0x48, 0x04) == I2C_STATUS_OK);
+    assert(I2C1.CCR == I2C_SPEED_STANDARD);
+
+    /* Slots are limited, and I2C_Init clears them */
+    for (uint8_t addr = 0x10; addr < 0x10 + I2C_MAX_DEVICES; addr++)
+        assert(I2C_SetDeviceSpeed(addr, I2C_SPEED_FAST));
+    assert(!I2C_SetDeviceSpeed(0x60, I2C_SPEED_FAST));
+    I2C_Init(&cfg);
+    assert(I2C_GetDeviceSpeed(0x10) == I2C_SPEED_STANDARD);
+
+    HAL_I2C_SimClearFaults();
+    printf("[I2C] Per-device speed profile test passed.\n");
+}
+
+static void test_i2c_retry_policy(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    I2C_RetryPolicy_t policy = {
+        .max_attempts = 3,
+        .backoff_base_us = 50,
+        .backoff_max_us = 80,
+        .jitter = true,
+        .nack_only = true,
+        .breaker_threshold = 2,
+        .breaker_cooldown_us = 1000
+    };
+    const uint32_t ticks_per_ms = HAL_TIMER_TICK_HZ / 1000U;
+    I2C_RetryStats_t stats;
+    uint8_t value = 0;
+
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* Without a policy the first failure is returned as before */
+    assert(!I2C_GetRetryStats(0x48, &stats));
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_ADDR_NACK);
+
+    assert(I2C_SetRetryPolicy(0x48, &policy));
+
+    /* Two NACKs are absorbed; backoff is 50 then 80 (capped), jittered down to half */
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 2);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK && value == 0x33);
+    assert(I2C_GetRetryStats(0x48, &stats));
+    assert(stats.calls == 1 && stats.attempts == 3 && stats.retries == 2);
+    assert(stats.recovered == 1 && stats.exhausted == 0);
+    assert(stats.backoff_us >= 25 + 40 && stats.backoff_us <= 50 + 80);
+
+    /* nack_only: a clock-stretch timeout is not retried */
+    HAL_I2C_SimStretchClock((I2C_STRETCH_TIMEOUT_US / 1000U + 5U) * ticks_per_ms, 1);
+    assert(I2C_WriteByte(0x48, 0x00) == I2C_STATUS_TIMEOUT);
+    assert(I2C_GetRetryStats(0x48, &stats) && stats.attempts == 4 && stats.exhausted == 1);
+    HAL_I2C_SimClearFaults();
+
+    /* Second failed call in a row opens the breaker: the next call never
+     * reaches the bus (the pending NACK stays pending) */
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_DATA, 4);
+    assert(I2C_WriteBuffer(0x48, (const uint8_t *)"ab", 2) == I2C_STATUS_DATA_NACK);
+    assert(I2C_WriteByte(0x48, 0x01) == I2C_STATUS_CIRCUIT_OPEN);
+    assert(I2C_GetRetryStats(0x48, &stats));
+    assert(stats.breaker_open && stats.breaker_trips == 1 && stats.fast_fails == 1);
+    assert(stats.attempts == 7);
+
+    /* After the cooldown a single probe runs; failing it re-opens the breaker */
+    HAL_TIMER_SimAdvance(ticks_per_ms);
+    assert(I2C_WriteByte(0x48, 0x01) == I2C_STATUS_DATA_NACK);
+    assert(I2C_GetRetryStats(0x48, &stats) && stats.attempts == 8 && stats.breaker_trips == 2);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_CIRCUIT_OPEN);
+
+    /* A successful probe closes it */
+    HAL_I2C_SimClearFaults();
+    HAL_TIMER_SimAdvance(ticks_per_ms);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK);
+    assert(I2C_GetRetryStats(0x48, &stats) && !stats.breaker_open);
+    assert(I2C_ReadByte(0x48, &value) == I2C_STATUS_OK);
+
+    /* Policies are per address */
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+    assert(I2C_WriteByte(0x50, 0x00) == I2C_STATUS_ADDR_NACK);
+
+    assert(I2C_SetRetryPolicy(0x48, NULL));
+    assert(!I2C_GetRetryStats(0x48, &stats));
+
+    HAL_I2C_SimClearFaults();
+    printf("[I2C] Retry policy test passed.\n");
+}
+
+static void test_driver_latency(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_STANDARD,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    HIST_Snapshot_t snap;
+    uint8_t buffer[4] = { 0 };
+    uint8_t addrs[I2C_MAX_DEVICES];
+
+    reset_i2c_registers();
+    I2C_Init(&cfg);
+
+    /* Every transaction lands in its op histogram, "all" and its device */
+    assert(I2C_ReadByte(0x48, buffer) == I2C_STATUS_OK);
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    assert(I2C_WriteByte(0x50, 0x01) == I2C_STATUS_OK);
+
+#if DRV_LATENCY_STATS
+    assert(I2C_GetLatency(I2C_LATENCY_READ, &snap) && snap.count == 2);
+    assert(I2C_GetLatency(I2C_LATENCY_WRITE, &snap) && snap.count == 1);
+    assert(I2C_GetLatency(I2C_LATENCY_ALL, &snap) && snap.count == 3);
+    assert(I2C_GetDeviceLatency(0x48, &snap) && snap.count == 2);
+    assert(I2C_GetDeviceLatency(0x50, &snap) && snap.count == 1);
+    assert(!I2C_GetDeviceLatency(0x51, &snap));
+    assert(I2C_GetLatencyDevices(addrs, I2C_MAX_DEVICES) == 2 && addrs[0] == 0x48);
+#else
+    /* Compiled out: nothing is recorded and nothing reported */
+    assert(!I2C_GetLatency(I2C_LATENCY_ALL, &snap));
+    assert(!I2C_GetDeviceLatency(0x48, &snap));
+    assert(I2C_GetLatencyDevices(addrs, I2C_MAX_DEVICES) == 0);
+#endif
+
+    /* A slow transmitter shows up in the per-byte and per-write histograms */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_UART_SimSetTxHook(slow_uart_tx);
+
+    UART_WriteBytes((const uint8_t *)"abc", 3);
+    assert(HAL_TIMER_TicksToNs(SLOW_TX_TICKS) == 100000U);
+#if DRV_LATENCY_STATS
+    assert(UART_GetLatency(UART_LATENCY_TX_CHAR, &snap) && snap.count == 3);
+    assert(snap.min >= SLOW_TX_TICKS);
+    assert(UART_GetLatency(UART_LATENCY_WRITE, &snap) && snap.count == 1);
+    assert(snap.min >= 3 * SLOW_TX_TICKS);
+#else
+    assert(!UART_GetLatency(UART_LATENCY_WRITE, &snap));
+#endif
+
+    /* The dump is plain text over UART */
+    HAL_UART_SimSetTxHook(capture_uart_tx);
+    uart_tx_captured = 0;
+    DRV_LatencyDump();
+#if DRV_LATENCY_STATS
+    assert(uart_tx_captured > 0);
+    assert(memcmp(uart_tx_capture, "-- latency (ns) --\r\n", 20) == 0);
+    assert(memcmp(uart_tx_capture + 20, "i2c.write   n=1 ", 16) == 0);
+
+    I2C_ResetLatency();
+    assert(I2C_GetLatency(I2C_LATENCY_ALL, &snap) && snap.count == 0);
+    assert(I2C_GetLatencyDevices(addrs, I2C_MAX_DEVICES) == 0);
+#else
+    assert(memcmp(uart_tx_capture, "-- latency stats disabled --\r\n", 30) == 0);
+#endif
+
+    HAL_UART_SimReset();
+    printf("[LAT] Driver latency histogram test passed.\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                         INTERRUPT CONTROLLER TESTS                         */
+/* -------------------------------------------------------------------------- */
+
+static HAL_IRQn_t nvic_order[8];
+static uint32_t nvic_ran;
+
+static void nvic_record_i2c1(void)
+{
+    assert(HAL_NVIC_InHandler() && HAL_NVIC_IsActive(HAL_IRQ_I2C1));
+    nvic_order[nvic_ran++] = HAL_IRQ_I2C1;
+}
+
+static void nvic_record_i2c2(void)
+{
+    nvic_order[nvic_ran++] = HAL_IRQ_I2C2;
+}
+
+static void test_nvic(void)
+{
+    static uint8_t pattern[200];
+
+    HAL_NVIC_Reset();
+    HAL_NVIC_SetHandler(HAL_IRQ_I2C1, nvic_record_i2c1);
+    HAL_NVIC_SetHandler(HAL_IRQ_I2C2, nvic_record_i2c2);
+    HAL_NVIC_SetPriority(HAL_IRQ_I2C1, 5);
+    HAL_NVIC_SetPriority(HAL_IRQ_I2C2, 2);
+    HAL_NVIC_EnableIRQ(HAL_IRQ_I2C1);
+    HAL_NVIC_EnableIRQ(HAL_IRQ_I2C2);
+
+    /* The lower priority number runs first, whatever the IRQ number */
+    nvic_ran = 0;
+    HAL_NVIC_SetPendingIRQ(HAL_IRQ_I2C1);
+    HAL_NVIC_SetPendingIRQ(HAL_IRQ_I2C2);
+    assert(HAL_NVIC_Poll() == 2);
+    assert(nvic_order[0] == HAL_IRQ_I2C2 && nvic_order[1] == HAL_IRQ_I2C1);
+    assert(!HAL_NVIC_IsPending(HAL_IRQ_I2C1) && !HAL_NVIC_InHandler());
+
+    /* A disabled line stays pending until it is enabled */
+    HAL_NVIC_DisableIRQ(HAL_IRQ_I2C1);
+    HAL_NVIC_SetPendingIRQ(HAL_IRQ_I2C1);
+    assert(HAL_NVIC_Poll() == 0 && HAL_NVIC_IsPending(HAL_IRQ_I2C1));
+    HAL_NVIC_EnableIRQ(HAL_IRQ_I2C1);
+    assert(HAL_NVIC_Poll() == 1);
+
+    /* Critical sections nest; nothing runs until the outermost one ends */
+    HAL_NVIC_EnterCritical();
+    HAL_NVIC_EnterCritical();
+    HAL_NVIC_SetPendingIRQ(HAL_IRQ_I2C2);
+    HAL_NVIC_ExitCritical();
+    assert(HAL_NVIC_Poll() == 0);
+    HAL_NVIC_ExitCritical();
+    assert(HAL_NVIC_Poll() == 1);
+    assert(HAL_NVIC_GetDispatchCount(HAL_IRQ_I2C2) == 2);
+
+    /* RX interrupt on the ISR thread fills the buffer while we read */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    UART_EnableRxInterrupt(true);
+    assert(UART1.CTRL & UART_CTRL_RXNEIE);
+    assert(HAL_NVIC_StartDispatcher());
+
+    for (uint32_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t)(0x20 + (i % 0x50));
+
+    for (uint32_t round = 0; round < 5; round++)
+    {
+        assert(HAL_UART_SimFeed(pattern, sizeof(pattern)) == sizeof(pattern));
+
+        for (uint32_t i = 0; i < sizeof(pattern); i++)
+            assert((uint8_t)UART_ReadChar() == pattern[i]);
+    }
+
+    HAL_NVIC_StopDispatcher();
+    assert(HAL_NVIC_GetDispatchCount(HAL_IRQ_UART1) > 0);
+    assert(UART_RxDropped() == 0 && UART_RxAvailable() == 0);
+
+    /* Without the thread, polling runs the handler from the main loop */
+    assert(HAL_UART_SimFeed(pattern, 10) == 10);
+    UART_PollRx();
+    assert(UART_RxAvailable() == 10 && HAL_UART_SimPending() == 0);
+
+    /* Masked again, bytes wait in the peripheral */
+    UART_EnableRxInterrupt(false);
+    assert(!(UART1.CTRL & UART_CTRL_RXNEIE));
+    assert(HAL_UART_SimFeed(pattern, 3) == 3);
+    assert(HAL_NVIC_Poll() == 0 && HAL_UART_SimPending() == 3);
+
+    HAL_NVIC_Reset();
+    HAL_UART_SimReset();
+    printf("[NVIC] Interrupt controller test passed.\n");
+}
+
+static void test_uart_irq_flow_control(void)
+{
+    static const UART_FlowControl_t flows[] = { UART_FLOW_RTS_CTS, UART_FLOW_XON_XOFF };
+    static uint8_t flood[1000];
+
+    for (uint32_t i = 0; i < sizeof(flood); i++)
+        flood[i] = (uint8_t)(0x20 + (i % 0x50));  /* Never XON/XOFF */
+
+    /* The handler throttles and the main loop releases while it transmits */
+    for (uint32_t f = 0; f < sizeof(flows) / sizeof(flows[0]); f++)
+    {
+        uint32_t sent = 0;
+        uint32_t xoff = 0;
+        uint32_t xon = 0;
+        uint32_t data = 0;
+
+        reset_uart_peer();
+        init_uart_flow(flows[f]);
+        HAL_UART_SimSetPeerSwFlow(flows[f] == UART_FLOW_XON_XOFF);
+        UART_EnableRxInterrupt(true);
+        assert(HAL_NVIC_StartDispatcher());
+
+        assert(HAL_UART_SimFeed(flood, sizeof(flood)) == sizeof(flood));
+        while (!UART_IsRxThrottled())
+            ;
+
+        for (uint32_t i = 0; i < sizeof(flood); i++)
+        {
+            if (i % 8U == 0)
+                UART_WriteChar((char)('a' + sent++ % 26U));
+            assert((uint8_t)UART_ReadChar() == flood[i]);
+        }
+
+        HAL_NVIC_StopDispatcher();
+        UART_EnableRxInterrupt(false);
+        assert(UART_RxDropped() == 0 && !UART_IsRxThrottled());
+
+        /* Our bytes arrive whole and in order, XON/XOFF only between them */
+        assert(uart_tx_captured <= sizeof(uart_tx_capture));
+        for (uint32_t i = 0; i < uart_tx_captured; i++)
+        {
+            if (uart_tx_capture[i] == UART_XOFF)
+                xoff++;
+            else if (uart_tx_capture[i] == UART_XON)
+                xon++;
+            else
+                assert(uart_tx_capture[i] == (uint8_t)('a' + data++ % 26U));
+        }
+        assert(data == sent);
+        if (flows[f] == UART_FLOW_XON_XOFF)
+            assert(xoff >= 1 && xon == xoff);
+        else
+            assert(xoff == 0 && xon == 0 && (UART1.CTRL & UART_CTRL_RTS));
+    }
+
+    HAL_NVIC_Reset();
+    HAL_UART_SimReset();
+    printf("[NVIC] Flow control under the RX interrupt test passed.\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                         SHARED REGISTER FILE TESTS                         */
+/* -------------------------------------------------------------------------- */
+
+static void test_register_write_combining(void)
+{
+    UART_Config_t cfg = {
+        .baudrate = 115200,
+        .parity = UART_PARITY_ODD,
+        .flow_control = UART_FLOW_RTS_CTS,
+        .data_bits = UART_DATABITS_9,
+        .address_match = true,
+        .node_address = 0x21
+    };
+    HAL_REG_AccessStats_t acc;
+
+    reset_uart_peer();
+
+    /* One bus write per register for the whole UART configuration */
+    HAL_REG_ResetAccessStats();
+    UART_Init(&cfg);
+    HAL_REG_GetAccessStats(&acc);
+#if HAL_REG_COUNT_ACCESSES
+    assert(acc.reads == 1 && acc.writes == 2);   /* CTRL read, BAUD + CTRL written */
+#endif
+    assert(UART1.BAUD == 417);   /* 48 MHz / 115200 = 416.7 clocks per bit */
+    assert(UART1.CTRL == (UART_CTRL_ENABLE | UART_CTRL_PARITY_ODD | UART_CTRL_HWFLOW |
+                          UART_CTRL_RTS | UART_CTRL_M9 | UART_CTRL_MME |
+                          (0x21U << UART_CTRL_ADD_SHIFT)));
+
+    /* Unbatched, every setter is its own read-modify-write */
+    UART1.CTRL = 0;
+    HAL_REG_ResetAccessStats();
+    HAL_UART_SetParity(2);
+    HAL_UART_SetHwFlowControl(true);
+    HAL_UART_SetRTS(true);
+    HAL_UART_SetDataBits9(true);
+    HAL_UART_SetAddressMatch(true, 0x21);
+    HAL_UART_Enable();
+    HAL_REG_GetAccessStats(&acc);
+#if HAL_REG_COUNT_ACCESSES
+    assert(acc.writes == 6);
+#endif
+
+    /* A batch that changes nothing costs no write */
+    HAL_REG_ResetAccessStats();
+    HAL_UART_ConfigBegin();
+    HAL_UART_Enable();
+    HAL_UART_ConfigCommit();
+    HAL_REG_GetAccessStats(&acc);
+#if HAL_REG_COUNT_ACCESSES
+    assert(acc.reads == 1 && acc.writes == 0);
+#endif
+
+    /* START and STOP are a single CR update each */
+    reset_i2c_registers();
+    HAL_REG_ResetAccessStats();
+    HAL_I2C_GenerateStart();
+    HAL_REG_GetAccessStats(&acc);
+#if HAL_REG_COUNT_ACCESSES
+    assert(acc.reads == 1 && acc.writes == 1);
+#endif
+    assert(I2C1.CR == I2C_CR_START);
+    HAL_I2C_GenerateStop();
+    assert(I2C1.CR == I2C_CR_STOP);
+
+    /* Batched CR changes are invisible until the commit */
+    I2C1.CR = I2C_CR_ENABLE | I2C_CR_ACK;
+    HAL_REG_ResetAccessStats();
+    HAL_I2C_ControlBegin();
+    HAL_I2C_SendNACK();
+    HAL_I2C_SetAckPosition(true);
+    assert(I2C1.CR == (I2C_CR_ENABLE | I2C_CR_ACK));
+    HAL_I2C_ControlCommit();
+    HAL_REG_GetAccessStats(&acc);
+    assert(I2C1.CR == (I2C_CR_ENABLE | I2C_CR_POS));
+#if HAL_REG_COUNT_ACCESSES
+    assert(acc.reads == 1 && acc.writes == 1);
+#endif
+
+    reset_i2c_registers();
+    HAL_UART_SimReset();
+    printf("[HAL] Register write combining test passed.\n");
+}
+
+static void test_sim_shared_registers(void)
+{
+    const char *name = "/arm_drivers_test";
+
+    HAL_SIM_UnlinkShared(name);
+    assert(HAL_SIM_AttachShared(name, 3));
+
+    /* Play the device side through a second mapping of the same segment */
+    SIM_SharedSegment_t *device = HAL_SIM_MapShared(name, false);
+    assert(device != NULL);
+
+    SIM_RegisterFile_t *file = &device->slot[3];
+    UART1.CTRL = UART_CTRL_ENABLE;  /* Same memory, seen from both mappings */
+    assert(file->uart1.CTRL == UART_CTRL_ENABLE);
+    assert(file->flags & SIM_FLAG_CLAIMED);
+    assert(!HAL_SIM_AttachShared(name, 3));  /* Already attached in this process */
+    file->flags |= SIM_FLAG_DEVICE_ONLINE;
+
+    /* Firmware TX lands in the device mailbox and rings the doorbell */
+    uint32_t seen = 0;
+    uint8_t byte = 0;
+
+    UART_WriteChar('Q');
+    assert(HAL_SIM_PollDoorbell(file, SIM_PERIPH_UART1, &seen));
+    assert(HAL_SIM_TakeFromFirmware(file, SIM_PERIPH_UART1, &byte));
+    assert(byte == 'Q');
+    assert(!(file->uart1.STATUS & UART_STATUS_TX_READY));
+    file->uart1.STATUS |= UART_STATUS_TX_READY;
+    HAL_SIM_AckDoorbell(file, SIM_PERIPH_UART1, seen);
+
+    /* Device RX reaches the driver; the mailbox holds one byte at a time */
+    assert(HAL_SIM_PostToFirmware(file, SIM_PERIPH_UART1, 'R'));
+    assert(!HAL_SIM_PostToFirmware(file, SIM_PERIPH_UART1, 'S'));
+    assert(UART_ReadChar() == 'R');
+    assert(HAL_SIM_PollDoorbell(file, SIM_PERIPH_UART1, &seen));
+
+    HAL_SIM_UnmapShared(device);
+    HAL_SIM_Detach();
+    HAL_SIM_UnlinkShared(name);
+
+    /* Back on process-local registers */
+    assert(!HAL_SIM_IsDeviceOnline());
+
+    printf("[SIM] Shared register file test passed.\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                     MAIN                                   */
+/* -------------------------------------------------------------------------- */
+
+#define CAPTURE_TEST_FILE   "/tmp/test_i2c_uart.bcap"
+
+static void test_capture_replay(void)
+{
+    I2C_Config_t cfg = {
+        .speed = I2C_SPEED_FAST,
+        .addressing_mode = I2C_ADDR_7BIT
+    };
+    static const uint8_t pattern[] = { 0xA0, 0xA1, 0xA2, 0xA3 };
+    static const uint8_t reg[] = { 0x10, 0x20 };
+    HAL_CAPTURE_Stats_t stats;
+    uint8_t buffer[4];
+
+    remove(CAPTURE_TEST_FILE);
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    reset_i2c_registers();
+    HAL_I2C_SimClearFaults();
+    I2C_Init(&cfg);
+
+    /* Record: two UART bytes a second apart, a read, a NACKed write */
+    assert(HAL_CAPTURE_Start(CAPTURE_TEST_FILE));
+    assert(HAL_UART_SimFeed((const uint8_t *)"x", 1) == 1);
+    UART_PollRx();
+    HAL_TIMER_SimAdvance(HAL_TIMER_TICK_HZ);
+    assert(HAL_UART_SimFeed((const uint8_t *)"y", 1) == 1);
+    UART_PollRx();
+
+    HAL_I2C_SimSetReadData(pattern, sizeof(pattern));
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_DATA, 1);
+    assert(I2C_WriteBuffer(0x48, reg, sizeof(reg)) == I2C_STATUS_DATA_NACK);
+
+    HAL_CAPTURE_GetStats(&stats);
+    assert(stats.records_written > 10 && stats.bytes_written > 16);
+    HAL_CAPTURE_Stop();
+
+    /* Untimed replay: the capture plays the peers */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    HAL_I2C_SimClearFaults();
+    assert(HAL_CAPTURE_Replay(CAPTURE_TEST_FILE, 0));
+
+    UART_PollRx();
+    assert(UART_RxAvailable() == 2);
+    assert(UART_ReadChar() == 'x' && UART_ReadChar() == 'y');
+
+    memset(buffer, 0, sizeof(buffer));
+    assert(I2C_ReadBuffer(0x48, buffer, sizeof(buffer)) == I2C_STATUS_OK);
+    assert(memcmp(buffer, pattern, sizeof(pattern)) == 0);
+    assert(I2C_WriteBuffer(0x48, reg, sizeof(reg)) == I2C_STATUS_DATA_NACK);
+
+    HAL_CAPTURE_GetStats(&stats);
+    assert(stats.uart_fed == 2 && stats.i2c_read == sizeof(pattern));
+    assert(stats.i2c_nacks == 1 && stats.i2c_mismatches == 0);
+    assert(stats.replay_done);
+
+    /* Used up: the simulated slave answers with its own data again */
+    assert(I2C_ReadBuffer(0x48, buffer, 1) == I2C_STATUS_OK && buffer[0] == 0x33);
+    HAL_CAPTURE_ReplayStop();
+
+    /* Original timing: the second byte waits for its second */
+    reset_uart_peer();
+    init_uart_flow(UART_FLOW_NONE);
+    assert(HAL_CAPTURE_Replay(CAPTURE_TEST_FILE, 1));
+    HAL_TIMER_SimAdvance(HAL_TIMER_TICK_HZ / 10U);
+    UART_PollRx();
+    assert(UART_RxAvailable() == 1);
+    HAL_TIMER_SimAdvance(HAL_TIMER_TICK_HZ);
+    UART_PollRx();
+    assert(UART_RxAvailable() == 2);
+    HAL_CAPTURE_ReplayStop();
+    assert(!HAL_CAPTURE_IsReplaying());
+
+    /* Files that are not captures are neither replayed nor appended to */
+    FILE *junk = fopen(CAPTURE_TEST_FILE, "wb");
+    assert(junk != NULL);
+    fputs("not a capture file", junk);
+    fclose(junk);
+    assert(!HAL_CAPTURE_Replay(CAPTURE_TEST_FILE, 0));
+    assert(!HAL_CAPTURE_Start(CAPTURE_TEST_FILE));
+
+    remove(CAPTURE_TEST_FILE);
+    HAL_UART_SimReset();
+    HAL_I2C_SimClearFaults();
+    printf("[CAP] Capture/replay test passed.\n");
+}
 
 int main(void)
 {
     printf("Running UART + I2C Driver Tests...\n");
 
     test_uart_write_read();
+    test_uart_no_flow_control_overruns();
+    test_uart_rts_cts();
+    test_uart_xon_xoff();
+    test_uart_autobaud();
+    test_uart_baud_divisor();
+    test_uart_baud_negotiation();
+    test_uart_rx_spans();
+    test_uart_line_scan();
+    test_uart_rs485_multidrop();
+    test_uart_mux();
+    test_uart_tokenized_log();
+    test_sample_codec();
+    test_sample_window();
+    test_histogram();
     test_i2c_write();
     test_i2c_read();
+    test_i2c_transfer();
+    test_i2c_pipelined_read();
+    test_i2c_stream_read();
+    test_i2c_target();
+    test_sensor_cache();
+    test_i2c_bus_faults();
+    test_i2c_retry_policy();
+    test_i2c_speed_profiles();
+    test_driver_latency();
+    test_nvic();
+    test_uart_irq_flow_control();
+    test_register_write_combining();
+    test_sim_shared_registers();
+    test_capture_replay();
 
     printf("All tests passed successfully.\n");
     return 0;
@@ -0,0 +1,110 @@
+/**
+ * @file log_decode.c
+ * @brief Host decoder for tokenized UART logs (see drivers/log_token.h).
+ *
+ * Reads a raw UART capture on stdin and writes text on stdout. Frames are
+ * expanded with the same string table the firmware was built from
+ * (src/log_strings.def); every other byte is passed through unchanged, so
+ * mixed text/tokenized captures decode cleanly.
+ *
+ * Usage:
+ *   make app CFLAGS_EXTRA=-DAPP_LOG_TOKENIZED && ./build/main | ./build/log_decode
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/log_token.h"
+#include "../src/app_log.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                String Table                                 */
+/* -------------------------------------------------------------------------- */
+
+static const char *const log_formats[] = {
+#define LOG_STRING(name, format) format,
+#include "../src/log_strings.def"
+#undef LOG_STRING
+};
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static void LogDecode_PutChar(char c)
+{
+    putchar(c);
+}
+
+static void LogDecode_Emit(const LOG_Frame_t *frame)
+{
+    if (frame->id < LOG_STRING_COUNT)
+    {
+        LOG_Format(log_formats[frame->id], frame->args, frame->argc, LogDecode_PutChar);
+        return;
+    }
+
+    /* Unknown ID: firmware is newer than this decoder */
+    printf("<log id %u:", (unsigned)frame->id);
+    for (uint32_t i = 0; i < frame->argc; i++)
+        printf(" %ld", (long)frame->args[i]);
+    printf(">\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    MAIN                                    */
+/* -------------------------------------------------------------------------- */
+
+int main(void)
+{
+    uint8_t buffer[LOG_MAX_FRAME];
+    uint32_t len = 0;
+    int c;
+
+    while ((c = getchar()) != EOF)
+    {
+        if (len == 0 && (uint8_t)c != LOG_FRAME_SYNC)
+        {
+            putchar(c);
+            continue;
+        }
+
+        buffer[len++] = (uint8_t)c;
+
+        /* Resolve the buffered bytes: emit frames, pass through garbage */
+        while (len > 0)
+        {
+            LOG_Frame_t frame;
+            uint32_t consumed = 0;
+            LOG_DecodeStatus_t status = LOG_DecodeFrame(buffer, len, &frame, &consumed);
+
+            if (status == LOG_DECODE_INCOMPLETE)
+                break;
+
+            if (status == LOG_DECODE_OK)
+            {
+                LogDecode_Emit(&frame);
+            }
+            else
+            {
+                /* Not a frame after all: print the sync byte and rescan */
+                putchar(buffer[0]);
+                consumed = 1;
+            }
+
+            len -= consumed;
+            memmove(buffer, &buffer[consumed], len);
+
+            /* Leading text bytes are not part of any frame */
+            while (len > 0 && buffer[0] != LOG_FRAME_SYNC)
+            {
+                putchar(buffer[0]);
+                memmove(buffer, &buffer[1], --len);
+            }
+        }
+    }
+
+    /* Truncated frame at end of capture */
+    fwrite(buffer, 1, len, stdout);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file mux_decode.c
+ * @brief Host demultiplexer for UART virtual channels (see drivers/mux_frame.h).
+ *
+ * Reads a raw UART capture on stdin and writes the payload of one channel
+ * (default 0) on stdout, so it can sit in front of the channel's own
+ * decoder. Bytes outside frames are passed through unchanged:
+ *
+ *   ./build/main | ./build/mux_decode -c 1 | ./build/log_decode
+ *
+ * Per-channel frame, byte and lost-chunk counts are reported on stderr at
+ * the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../drivers/mux_frame.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                    MAIN                                    */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    MUX_Decoder_t decoder;
+    uint8_t buffer[MUX_MAX_FRAME];
+    uint32_t len = 0;
+    uint32_t channel = 0;
+    int c;
+
+    if (argc == 3 && strcmp(argv[1], "-c") == 0)
+        channel = (uint32_t)strtoul(argv[2], NULL, 0);
+
+    if ((argc != 1 && argc != 3) || channel >= MUX_MAX_CHANNELS)
+    {
+        fprintf(stderr, "usage: %s [-c channel]   (channel 0..%u)\n", argv[0],
+                (unsigned)(MUX_MAX_CHANNELS - 1U));
+        return 2;
+    }
+
+    MUX_DecoderInit(&decoder);
+
+    while ((c = getchar()) != EOF)
+    {
+        if (len == 0 && (uint8_t)c != MUX_FRAME_SYNC)
+        {
+            putchar(c);
+            continue;
+        }
+
+        buffer[len++] = (uint8_t)c;
+
+        /* Resolve the buffered bytes: emit frames, pass through the rest */
+        while (len > 0)
+        {
+            MUX_Frame_t frame;
+            uint32_t consumed = 0;
+            MUX_DecodeStatus_t status = MUX_DecodeFrame(&decoder, buffer, len, &frame, &consumed);
+
+            if (status == MUX_DECODE_INCOMPLETE)
+                break;
+
+            if (status == MUX_DECODE_OK)
+            {
+                if (frame.channel == channel)
+                    fwrite(frame.data, 1, frame.len, stdout);
+            }
+            else
+            {
+                /* Not a frame after all: print the sync byte and rescan */
+                putchar(buffer[0]);
+                consumed = 1;
+            }
+
+            len -= consumed;
+            memmove(buffer, &buffer[consumed], len);
+
+            while (len > 0 && buffer[0] != MUX_FRAME_SYNC)
+            {
+                putchar(buffer[0]);
+                memmove(buffer, &buffer[1], --len);
+            }
+        }
+    }
+
+    fwrite(buffer, 1, len, stdout);
+    fflush(stdout);
+
+    for (uint32_t ch = 0; ch < MUX_MAX_CHANNELS; ch++)
+    {
+        if (decoder.frames[ch] == 0)
+            continue;
+
+        fprintf(stderr, "mux_decode: ch%u %u frames, %u bytes, %u chunks lost\n",
+                (unsigned)ch, (unsigned)decoder.frames[ch], (unsigned)decoder.bytes[ch],
+                (unsigned)decoder.lost[ch]);
+    }
+    return 0;
+}
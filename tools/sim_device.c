@@ -0,0 +1,175 @@
+/**
+ * @file sim_device.c
+ * @brief Stand-alone device simulator for shared-memory co-simulation.
+ *
+ * Maps the shared register segment (hal_sim.h), marks every slot as served by
+ * an external device and then plays the peripheral side for all firmware
+ * instances attached to it:
+ *  - UART1: echoes every transmitted byte to stdout, tagged with the slot
+ *  - I2C1:  ACKs every address and data byte, returns 0x33 on reads
+ *
+ * Usage:
+ *   ./build/sim_device /armsim
+ *   make app CFLAGS_EXTRA='-DSIM_SHM_NAME=\"/armsim\"' && ./build/main
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+
+#include "../include/hal_sim.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                Definitions                                  */
+/* -------------------------------------------------------------------------- */
+
+#define SIM_DEVICE_READ_DATA   0x33U   /* Same fake sensor value as the local HAL */
+#define SIM_DEVICE_LINE_MAX    127U    /* UART output is printed line by line */
+
+static volatile sig_atomic_t sim_running = 1;
+static bool sim_i2c_reading[SIM_MAX_INSTANCES];
+static char sim_uart_line[SIM_MAX_INSTANCES][SIM_DEVICE_LINE_MAX + 1];
+static uint32_t sim_uart_line_len[SIM_MAX_INSTANCES];
+
+/* -------------------------------------------------------------------------- */
+/*                          Peripheral Models                                  */
+/* -------------------------------------------------------------------------- */
+
+static void SimDevice_ServiceUART(SIM_RegisterFile_t *file, uint32_t slot)
+{
+    uint8_t byte;
+
+    if (HAL_SIM_TakeFromFirmware(file, SIM_PERIPH_UART1, &byte))
+    {
+        char *line = sim_uart_line[slot];
+        uint32_t *len = &sim_uart_line_len[slot];
+
+        if (byte != '\r' && byte != '\n')
+            line[(*len)++] = (char)byte;
+
+        /* Print whole lines so concurrent instances do not interleave */
+        if (byte == '\n' || *len == SIM_DEVICE_LINE_MAX)
+        {
+            line[*len] = '\0';
+            printf("[%02u] %s\n", (unsigned)slot, line);
+            fflush(stdout);
+            *len = 0;
+        }
+        file->uart1.STATUS |= UART_STATUS_TX_READY;
+    }
+}
+
+static void SimDevice_ServiceI2C(SIM_RegisterFile_t *file, uint32_t slot)
+{
+    uint32_t sr = file->i2c1.SR;
+
+    /* Idle or STOP: nothing to drive */
+    if (!(sr & I2C_SR_BUSY))
+        return;
+
+    /* Address phase: ACK, then present the first byte for reads */
+    if (!(sr & I2C_SR_ADDR))
+    {
+        sim_i2c_reading[slot] = (file->i2c1.DR & 0x01U) != 0;
+
+        if (sim_i2c_reading[slot])
+        {
+            file->i2c1.DR = SIM_DEVICE_READ_DATA;
+            file->i2c1.SR |= I2C_SR_ADDR | I2C_SR_RXNE;
+        }
+        else
+        {
+            file->i2c1.SR |= I2C_SR_ADDR | I2C_SR_TXE;
+        }
+        return;
+    }
+
+    /* Data phase: ACK written bytes, refill DR after each read. A STOP
+     * requested during a read follows the byte that was still in flight. */
+    if (sim_i2c_reading[slot])
+    {
+        if (!(sr & I2C_SR_RXNE))
+        {
+            file->i2c1.DR = SIM_DEVICE_READ_DATA;
+            file->i2c1.SR |= I2C_SR_RXNE;
+
+            if (file->i2c1.CR & I2C_CR_STOP)
+                file->i2c1.SR &= ~I2C_SR_BUSY;
+        }
+    }
+    else if (!(sr & I2C_SR_TXE))
+    {
+        file->i2c1.SR |= I2C_SR_TXE;
+    }
+}
+
+static void SimDevice_HandleSignal(int sig)
+{
+    (void)sig;
+    sim_running = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    MAIN                                    */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    const char *name = (argc > 1) ? argv[1] : "/armsim";
+    uint32_t seen[SIM_MAX_INSTANCES][SIM_PERIPH_COUNT] = {{0}};
+
+    SIM_SharedSegment_t *segment = HAL_SIM_MapShared(name, true);
+    if (segment == NULL)
+    {
+        fprintf(stderr, "sim_device: cannot map %s\n", name);
+        return 1;
+    }
+
+    signal(SIGINT, SimDevice_HandleSignal);
+    signal(SIGTERM, SimDevice_HandleSignal);
+
+    for (uint32_t i = 0; i < SIM_MAX_INSTANCES; i++)
+        segment->slot[i].flags |= SIM_FLAG_DEVICE_ONLINE;
+
+    fprintf(stderr, "sim_device: serving %u slots on %s\n", SIM_MAX_INSTANCES, name);
+
+    while (sim_running)
+    {
+        bool busy = false;
+
+        for (uint32_t i = 0; i < SIM_MAX_INSTANCES; i++)
+        {
+            SIM_RegisterFile_t *file = &segment->slot[i];
+
+            if (!(file->flags & SIM_FLAG_CLAIMED))
+                continue;
+
+            if (HAL_SIM_PollDoorbell(file, SIM_PERIPH_UART1, &seen[i][SIM_PERIPH_UART1]))
+            {
+                SimDevice_ServiceUART(file, i);
+                HAL_SIM_AckDoorbell(file, SIM_PERIPH_UART1, seen[i][SIM_PERIPH_UART1]);
+                busy = true;
+            }
+
+            if (HAL_SIM_PollDoorbell(file, SIM_PERIPH_I2C1, &seen[i][SIM_PERIPH_I2C1]))
+            {
+                SimDevice_ServiceI2C(file, i);
+                HAL_SIM_AckDoorbell(file, SIM_PERIPH_I2C1, seen[i][SIM_PERIPH_I2C1]);
+                busy = true;
+            }
+        }
+
+        /* Hand the CPU back to the firmware when there was nothing to do */
+        if (!busy)
+            sched_yield();
+    }
+
+    for (uint32_t i = 0; i < SIM_MAX_INSTANCES; i++)
+        segment->slot[i].flags &= ~SIM_FLAG_DEVICE_ONLINE;
+
+    HAL_SIM_UnmapShared(segment);
+    HAL_SIM_UnlinkShared(name);
+    return 0;
+}
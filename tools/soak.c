@@ -0,0 +1,521 @@
+/**
+ * @file soak.c
+ * @brief Multi-threaded soak/load harness for the UART and I2C drivers.
+ *
+ * Runs a weighted mix of UART writes, I2C reads and I2C writes from several
+ * threads for a fixed duration and/or number of operations, records the
+ * latency of every operation in per-thread HDR-style histograms
+ * (drivers/histogram.h) and reports throughput plus p50/p90/p99/p99.9.
+ *
+ * The drivers expect one caller per peripheral at a time, exactly like
+ * firmware that guards a bus with an RTOS mutex, so each operation takes
+ * its peripheral's lock; UART and I2C operations run in parallel. Reported
+ * latency is what a caller observes: waiting for the bus plus the transfer
+ * itself.
+ *
+ * Usage:
+ *   ./build/soak [-t threads] [-d seconds] [-n ops] [-m uart,i2c_read,i2c_write]
+ *                [-u uart_len] [-i i2c_len] [-P p999_limit_ns] [-s shm_name]
+ *                [-F fault_every] [-N nack_every] [-R attempts] [-C cache_ttl_us]
+ *                [-W] [-w capture_file] [-r replay_file]
+ *
+ *   ./build/soak -t 8 -d 5 -m 50,30,20
+ *   ./build/soak -t 4 -n 100000 -P 200000      # exit 1 if p99.9 > 200 us
+ *   ./build/soak -s /armsim                    # against build/sim_device
+ *   ./build/soak -F 1000                       # stuck SDA every 1000 I2C ops
+ *   ./build/soak -N 50 -R 3                    # NACK every 50th op, 3 attempts
+ *   ./build/soak -C 1000 -m 0,100,0            # i2c reads via a 1 ms TTL cache
+ *   ./build/soak -W -i 16 -m 0,100,0           # I2C bytes take real bus time
+ *   ./build/soak -w /tmp/bus.bcap              # record all bus traffic
+ *
+ * With -F, the simulated HAL sticks SDA low before every Nth I2C operation;
+ * the driver's bus recovery count and time are reported at the end.
+ * With -N, it NACKs the address of every Nth I2C operation. -R installs an
+ * I2C_RETRY_POLICY_DEFAULT policy with the given attempt count on the
+ * device, so error rate and latency can be compared with and without it.
+ * With -C, I2C reads go through the sensor cache (drivers/sensor_cache.h)
+ * with the given TTL; only cache misses take the I2C lock, and the report
+ * shows how many reads actually reached the bus.
+ * With -W, the simulated I2C bus clocks each byte in 9 SCL periods instead
+ * of instantly; the report shows how long the double-buffered receiver held
+ * SCL waiting for the driver, and any reads that ended on an ACKed byte.
+ * With -w, all UART and I2C traffic is appended to a capture file; with -r,
+ * the I2C slave answers from a capture file instead (hal_capture.h), and the
+ * report shows how far the replay got and how often the firmware's bytes
+ * differed from the recording.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../drivers/uart.h"
+#include "../drivers/i2c.h"
+#include "../drivers/histogram.h"
+#include "../drivers/sensor_cache.h"
+#include "../include/hal_uart.h"
+#include "../include/hal_i2c.h"
+#include "../include/hal_sim.h"
+#include "../include/hal_timer.h"
+#include "../include/hal_capture.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                Definitions                                  */
+/* -------------------------------------------------------------------------- */
+
+#define SOAK_MAX_THREADS     64U
+#define SOAK_MAX_PAYLOAD     256U
+#define SOAK_DEVICE_ADDR     0x48U   /* Same fake sensor as src/main.c */
+
+typedef enum
+{
+    SOAK_OP_UART_WRITE = 0,
+    SOAK_OP_I2C_READ,
+    SOAK_OP_I2C_WRITE,
+    SOAK_OP_COUNT
+} SoakOp_t;
+
+static const char *const soak_op_names[SOAK_OP_COUNT] = {
+    "uart_write", "i2c_read", "i2c_write"
+};
+
+typedef struct
+{
+    uint32_t threads;
+    uint32_t seconds;                 /* 0 = no time limit */
+    uint64_t ops;                     /* 0 = no operation limit */
+    uint32_t weight[SOAK_OP_COUNT];
+    uint32_t uart_len;
+    uint32_t i2c_len;
+    uint32_t p999_limit_ns;           /* 0 = no pass/fail check */
+    const char *shm_name;
+    uint32_t fault_every;             /* 0 = no fault injection */
+    uint32_t nack_every;              /* 0 = no NACK injection */
+    uint32_t retry_attempts;          /* 0 = no retry policy */
+    uint32_t cache_ttl_us;            /* 0 = I2C reads bypass the sensor cache */
+    bool wire_timing;                 /* Simulated I2C bytes take bus time */
+    const char *capture_path;         /* NULL = no capture */
+    const char *replay_path;          /* NULL = no replay */
+} SoakConfig_t;
+
+typedef struct
+{
+    pthread_t thread;
+    uint32_t rng;
+    HIST_Histogram_t latency[SOAK_OP_COUNT];
+    uint64_t errors[SOAK_OP_COUNT];
+} SoakWorker_t;
+
+static SoakConfig_t soak_cfg = {
+    .threads = 4,
+    .seconds = 2,
+    .weight = { 50, 30, 20 },
+    .uart_len = 16,
+    .i2c_len = 4,
+};
+
+static SoakWorker_t soak_workers[SOAK_MAX_THREADS];
+static pthread_mutex_t soak_uart_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t soak_i2c_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool soak_stop;
+static _Atomic uint64_t soak_issued;
+static uint32_t soak_i2c_ops;         /* Written under soak_i2c_lock */
+
+/* -------------------------------------------------------------------------- */
+/*                          Internal Helper Functions                          */
+/* -------------------------------------------------------------------------- */
+
+static uint64_t Soak_NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t Soak_Random(uint32_t *state)
+{
+    /* xorshift32: cheap, per-thread, good enough for picking operations */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static SoakOp_t Soak_PickOp(uint32_t *rng)
+{
+    uint32_t total = 0;
+    for (uint32_t op = 0; op < SOAK_OP_COUNT; op++)
+        total += soak_cfg.weight[op];
+
+    uint32_t pick = Soak_Random(rng) % total;
+    for (uint32_t op = 0; op < SOAK_OP_COUNT; op++)
+    {
+        if (pick < soak_cfg.weight[op])
+            return (SoakOp_t)op;
+        pick -= soak_cfg.weight[op];
+    }
+    return SOAK_OP_UART_WRITE;
+}
+
+/* Replaces the simulator's putchar() so the report is not buried in output */
+static void Soak_UartSink(uint8_t byte, bool framing_error)
+{
+    (void)byte;
+    (void)framing_error;
+}
+
+static void Soak_LockI2C(void)
+{
+    pthread_mutex_lock(&soak_i2c_lock);
+}
+
+static void Soak_UnlockI2C(void)
+{
+    pthread_mutex_unlock(&soak_i2c_lock);
+}
+
+static void Soak_Yield(void)
+{
+    sched_yield();
+}
+
+static bool Soak_RunOp(SoakOp_t op, uint8_t *payload)
+{
+    bool ok;
+
+    if (op == SOAK_OP_UART_WRITE)
+    {
+        pthread_mutex_lock(&soak_uart_lock);
+        UART_WriteBytes(payload, soak_cfg.uart_len);
+        pthread_mutex_unlock(&soak_uart_lock);
+        return true;
+    }
+
+    /* The cache takes the I2C lock itself, and only on a miss */
+    if (op == SOAK_OP_I2C_READ && soak_cfg.cache_ttl_us != 0)
+        return SCACHE_Read(SOAK_DEVICE_ADDR, 0x00, payload) == I2C_STATUS_OK;
+
+    pthread_mutex_lock(&soak_i2c_lock);
+
+    /* Stuck-SDA fault, released after a few recovery clocks */
+    soak_i2c_ops++;
+    if (soak_cfg.fault_every != 0 && soak_i2c_ops % soak_cfg.fault_every == 0)
+        HAL_I2C_SimStickSDA(3);
+    if (soak_cfg.nack_every != 0 && soak_i2c_ops % soak_cfg.nack_every == 0)
+        HAL_I2C_SimInjectNack(HAL_I2C_SIM_PHASE_ADDRESS, 1);
+
+    if (op == SOAK_OP_I2C_READ)
+        ok = I2C_ReadBuffer(SOAK_DEVICE_ADDR, payload, soak_cfg.i2c_len) == I2C_STATUS_OK;
+    else
+        ok = I2C_WriteBuffer(SOAK_DEVICE_ADDR, payload, soak_cfg.i2c_len) == I2C_STATUS_OK;
+
+    pthread_mutex_unlock(&soak_i2c_lock);
+    return ok;
+}
+
+static void *Soak_Worker(void *arg)
+{
+    SoakWorker_t *worker = arg;
+    uint8_t payload[SOAK_MAX_PAYLOAD];
+
+    for (uint32_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)('a' + i % 26);
+
+    while (!atomic_load_explicit(&soak_stop, memory_order_relaxed))
+    {
+        if (soak_cfg.ops != 0 && atomic_fetch_add(&soak_issued, 1U) >= soak_cfg.ops)
+            break;
+
+        SoakOp_t op = Soak_PickOp(&worker->rng);
+        uint64_t start = Soak_NowNs();
+        bool ok = Soak_RunOp(op, payload);
+        uint64_t elapsed = Soak_NowNs() - start;
+
+        HIST_Record(&worker->latency[op], elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed);
+        if (!ok)
+            worker->errors[op]++;
+    }
+
+    return NULL;
+}
+
+static bool Soak_ParseMix(const char *text)
+{
+    unsigned a, b, c;
+
+    if (sscanf(text, "%u,%u,%u", &a, &b, &c) != 3 || a + b + c == 0)
+        return false;
+
+    soak_cfg.weight[SOAK_OP_UART_WRITE] = a;
+    soak_cfg.weight[SOAK_OP_I2C_READ] = b;
+    soak_cfg.weight[SOAK_OP_I2C_WRITE] = c;
+    return true;
+}
+
+static bool Soak_ParseArgs(int argc, char **argv)
+{
+    bool seconds_set = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:d:n:m:u:i:P:s:F:N:R:C:Ww:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': soak_cfg.threads = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'd': soak_cfg.seconds = (uint32_t)strtoul(optarg, NULL, 0); seconds_set = true; break;
+        case 'n': soak_cfg.ops = strtoull(optarg, NULL, 0); break;
+        case 'm': if (!Soak_ParseMix(optarg)) return false; break;
+        case 'u': soak_cfg.uart_len = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'i': soak_cfg.i2c_len = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'P': soak_cfg.p999_limit_ns = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': soak_cfg.shm_name = optarg; break;
+        case 'F': soak_cfg.fault_every = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'N': soak_cfg.nack_every = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'R': soak_cfg.retry_attempts = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'C': soak_cfg.cache_ttl_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'W': soak_cfg.wire_timing = true; break;
+        case 'w': soak_cfg.capture_path = optarg; break;
+        case 'r': soak_cfg.replay_path = optarg; break;
+        default:  return false;
+        }
+    }
+
+    /* -n alone means "run until done" */
+    if (soak_cfg.ops != 0 && !seconds_set)
+        soak_cfg.seconds = 0;
+
+    return soak_cfg.threads >= 1 && soak_cfg.threads <= SOAK_MAX_THREADS &&
+           soak_cfg.uart_len >= 1 && soak_cfg.uart_len <= SOAK_MAX_PAYLOAD &&
+           soak_cfg.i2c_len >= 1 && soak_cfg.i2c_len <= SOAK_MAX_PAYLOAD &&
+           (soak_cfg.cache_ttl_us == 0 || soak_cfg.i2c_len <= SCACHE_MAX_VALUE) &&
+           (soak_cfg.seconds != 0 || soak_cfg.ops != 0);
+}
+
+static bool Soak_Report(double seconds)
+{
+    bool pass = true;
+    uint64_t uart_bytes = 0;
+
+    printf("soak: %u threads, %.2f s, mix uart/i2c_read/i2c_write = %u/%u/%u\n",
+           (unsigned)soak_cfg.threads, seconds,
+           (unsigned)soak_cfg.weight[0], (unsigned)soak_cfg.weight[1],
+           (unsigned)soak_cfg.weight[2]);
+    printf("%-11s %10s %11s %8s %8s %8s %8s %8s %10s %7s\n", "op", "count", "ops/s",
+           "min", "p50", "p90", "p99", "p99.9", "max", "errors");
+
+    for (uint32_t op = 0; op < SOAK_OP_COUNT; op++)
+    {
+        HIST_Snapshot_t total = { .min = UINT32_MAX };
+        uint64_t errors = 0;
+
+        for (uint32_t t = 0; t < soak_cfg.threads; t++)
+        {
+            HIST_Snapshot_t snap;
+            HIST_Snapshot(&soak_workers[t].latency[op], &snap);
+            HIST_Merge(&total, &snap);
+            errors += soak_workers[t].errors[op];
+        }
+
+        if (total.count == 0)
+            continue;
+
+        if (op == SOAK_OP_UART_WRITE)
+            uart_bytes = (uint64_t)total.count * soak_cfg.uart_len;
+
+        uint32_t p999 = HIST_ValueAt(&total, HIST_P999);
+        printf("%-11s %10u %11.0f %8u %8u %8u %8u %8u %10u %7llu\n", soak_op_names[op],
+               (unsigned)total.count, total.count / seconds, (unsigned)total.min,
+               (unsigned)HIST_ValueAt(&total, HIST_P50), (unsigned)HIST_ValueAt(&total, HIST_P90),
+               (unsigned)HIST_ValueAt(&total, HIST_P99), (unsigned)p999,
+               (unsigned)total.max, (unsigned long long)errors);
+
+        if (errors != 0 || (soak_cfg.p999_limit_ns != 0 && p999 > soak_cfg.p999_limit_ns))
+            pass = false;
+    }
+
+    printf("latency in ns (bus wait + transfer); %llu UART bytes sent\n",
+           (unsigned long long)uart_bytes);
+    if (soak_cfg.fault_every != 0)
+    {
+        I2C_BusStats_t stats;
+        HIST_Snapshot_t recovery;
+
+        I2C_GetBusStats(&stats);
+        I2C_GetLatency(I2C_LATENCY_RECOVERY, &recovery);
+        printf("bus recoveries %u (failed %u), recovery time p50 %u ns, max %u ns\n",
+               (unsigned)stats.recoveries, (unsigned)stats.recovery_failures,
+               (unsigned)HAL_TIMER_TicksToNs(HIST_ValueAt(&recovery, HIST_P50)),
+               (unsigned)HAL_TIMER_TicksToNs(recovery.max));
+    }
+    if (soak_cfg.retry_attempts != 0)
+    {
+        I2C_RetryStats_t retry;
+
+        I2C_GetRetryStats(SOAK_DEVICE_ADDR, &retry);
+        printf("retries %u (recovered %u, exhausted %u), backoff %u us, breaker trips %u, "
+               "fast fails %u\n",
+               (unsigned)retry.retries, (unsigned)retry.recovered, (unsigned)retry.exhausted,
+               (unsigned)retry.backoff_us, (unsigned)retry.breaker_trips,
+               (unsigned)retry.fast_fails);
+    }
+    if (soak_cfg.cache_ttl_us != 0)
+    {
+        SCACHE_Stats_t cache;
+
+        SCACHE_GetStats(&cache);
+        uint32_t reads = cache.hits + cache.misses + cache.coalesced;
+        printf("sensor cache (ttl %u us): hits %u, coalesced %u, misses %u -> "
+               "%.1f%% of reads on the bus\n",
+               (unsigned)soak_cfg.cache_ttl_us, (unsigned)cache.hits, (unsigned)cache.coalesced,
+               (unsigned)cache.misses, reads ? 100.0 * cache.misses / reads : 0.0);
+    }
+    if (soak_cfg.wire_timing)
+    {
+        HAL_I2C_SimRxStats_t rx;
+
+        HAL_I2C_SimGetRxStats(&rx);
+        printf("i2c receiver: %u bytes, %u stalls holding SCL for %u ns total, "
+               "%u reads ended on an ACK, %u bytes unread\n",
+               (unsigned)rx.bytes, (unsigned)rx.stalls,
+               (unsigned)HAL_TIMER_TicksToNs(rx.stall_ticks), (unsigned)rx.acked_last,
+               (unsigned)rx.unread);
+    }
+    if (soak_cfg.capture_path != NULL || soak_cfg.replay_path != NULL)
+    {
+        HAL_CAPTURE_Stats_t cap;
+
+        HAL_CAPTURE_GetStats(&cap);
+        if (soak_cfg.capture_path != NULL)
+            printf("capture %s: %llu records, %llu bytes\n", soak_cfg.capture_path,
+                   (unsigned long long)cap.records_written,
+                   (unsigned long long)cap.bytes_written);
+        if (soak_cfg.replay_path != NULL)
+            printf("replay %s: %llu i2c bytes, %llu nacks, %llu mismatches%s\n",
+                   soak_cfg.replay_path, (unsigned long long)cap.i2c_read,
+                   (unsigned long long)cap.i2c_nacks, (unsigned long long)cap.i2c_mismatches,
+                   cap.replay_done ? ", done" : "");
+    }
+    if (soak_cfg.p999_limit_ns != 0)
+        printf("p99.9 limit %u ns: %s\n", (unsigned)soak_cfg.p999_limit_ns, pass ? "PASS" : "FAIL");
+
+    return pass;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    MAIN                                    */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    if (!Soak_ParseArgs(argc, argv))
+    {
+        fprintf(stderr, "usage: %s [-t threads] [-d seconds] [-n ops] [-m uart,i2c_read,i2c_write]\n"
+                        "       [-u uart_len] [-i i2c_len] [-P p999_limit_ns] [-s shm_name]\n"
+                        "       [-F fault_every] [-N nack_every] [-R attempts] [-C cache_ttl_us]\n"
+                        "       [-W] [-w capture_file] [-r replay_file]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (soak_cfg.shm_name != NULL && !HAL_SIM_AttachShared(soak_cfg.shm_name, SIM_SLOT_ANY))
+    {
+        fprintf(stderr, "soak: cannot attach %s\n", soak_cfg.shm_name);
+        return 2;
+    }
+
+    if (soak_cfg.replay_path != NULL && !HAL_CAPTURE_Replay(soak_cfg.replay_path, 1))
+    {
+        fprintf(stderr, "soak: cannot replay %s\n", soak_cfg.replay_path);
+        return 2;
+    }
+
+    if (soak_cfg.capture_path != NULL && !HAL_CAPTURE_Start(soak_cfg.capture_path))
+    {
+        fprintf(stderr, "soak: cannot capture to %s\n", soak_cfg.capture_path);
+        return 2;
+    }
+
+    UART_Config_t uart_cfg = { .baudrate = 115200, .stop_bits = UART_STOPBITS_1,
+                               .parity = UART_PARITY_NONE };
+    I2C_Config_t i2c_cfg = { .speed = I2C_SPEED_STANDARD, .addressing_mode = I2C_ADDR_7BIT };
+
+    UART_Init(&uart_cfg);
+    I2C_Init(&i2c_cfg);
+    HAL_UART_SimSetTxHook(Soak_UartSink);
+    HAL_I2C_SimSetWireTiming(soak_cfg.wire_timing);
+
+    if (soak_cfg.retry_attempts != 0)
+    {
+        I2C_RetryPolicy_t policy = I2C_RETRY_POLICY_DEFAULT;
+
+        policy.max_attempts = soak_cfg.retry_attempts;
+        I2C_SetRetryPolicy(SOAK_DEVICE_ADDR, &policy);
+    }
+
+    if (soak_cfg.cache_ttl_us != 0)
+    {
+        const SCACHE_Hooks_t hooks = {
+            .lock = Soak_LockI2C, .unlock = Soak_UnlockI2C, .wait = Soak_Yield
+        };
+
+        SCACHE_Init(&hooks);
+        SCACHE_Register(SOAK_DEVICE_ADDR, 0x00, (uint8_t)soak_cfg.i2c_len, soak_cfg.cache_ttl_us);
+    }
+
+    for (uint32_t t = 0; t < soak_cfg.threads; t++)
+    {
+        soak_workers[t].rng = 0x9E3779B9U * (t + 1U);
+        for (uint32_t op = 0; op < SOAK_OP_COUNT; op++)
+            HIST_Reset(&soak_workers[t].latency[op]);
+    }
+
+    uint64_t start = Soak_NowNs();
+    uint32_t started = 0;
+
+    while (started < soak_cfg.threads &&
+           pthread_create(&soak_workers[started].thread, NULL, Soak_Worker,
+                          &soak_workers[started]) == 0)
+        started++;
+
+    if (started < soak_cfg.threads)
+    {
+        fprintf(stderr, "soak: cannot start worker thread %u\n", (unsigned)started);
+        atomic_store(&soak_stop, true);
+    }
+    else if (soak_cfg.seconds != 0)
+    {
+        struct timespec step = { .tv_sec = 0, .tv_nsec = 10000000L };
+        uint64_t deadline = start + (uint64_t)soak_cfg.seconds * 1000000000ULL;
+
+        while (Soak_NowNs() < deadline &&
+               (soak_cfg.ops == 0 || atomic_load(&soak_issued) < soak_cfg.ops))
+            nanosleep(&step, NULL);
+
+        atomic_store(&soak_stop, true);
+    }
+
+    for (uint32_t t = 0; t < started; t++)
+        pthread_join(soak_workers[t].thread, NULL);
+
+    double seconds = (double)(Soak_NowNs() - start) / 1e9;
+    int status = 2;
+
+    if (started == soak_cfg.threads)
+        status = Soak_Report(seconds) ? 0 : 1;
+
+    HAL_UART_SimSetTxHook(NULL);
+    HAL_CAPTURE_Stop();
+    HAL_CAPTURE_ReplayStop();
+    if (soak_cfg.shm_name != NULL)
+        HAL_SIM_Detach();
+
+    return status;
+}